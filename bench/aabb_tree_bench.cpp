@@ -0,0 +1,141 @@
+#include "aabb_tree.hpp"
+#include "bench.hpp"
+
+#include <glm/ext/matrix_clip_space.hpp>
+#include <glm/ext/matrix_transform.hpp>
+#include <glm/ext/scalar_constants.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+// Dynamic AABB tree: insert N boxes one by one, move all of them a small random step per frame (most stay inside their
+// fat AABB, the rest are reinserted), then frustum, overlap and ray queries, before and after a full SAH rebuild.
+// The result column is the tree height after insert and rebuild, reinsertions per frame for update and hits per query
+// otherwise. CPU only, no context. Without an argument it runs 100k and 1M objects.
+//
+//   aabb_tree_bench [objects = 100000 and 1000000] [frames = 10] [queries = 10000]
+
+/* One full run at `objects` objects, printing a table */
+static void runTree(const std::uint32_t objects, const int frames, const int queries)
+{
+    // Boxes spread so the density stays the same whatever the count
+    const auto worldSize = 10.0f * std::cbrt(static_cast<float>(objects));
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> position(-worldSize, worldSize);
+    std::uniform_real_distribution<float> size(0.5f, 2.0f);
+    std::uniform_real_distribution<float> step(-0.04f, 0.04f);
+
+    std::vector<Aabb> boxes(objects);
+    for (auto& box : boxes)
+    {
+        const glm::vec3 centre(position(random), position(random), position(random));
+        const auto extent = glm::vec3(size(random), size(random), size(random));
+        box = { centre - extent, centre + extent };
+    }
+
+    AabbTree tree;
+    tree.init(0.1f);
+    std::vector<AabbTree::Proxy> proxies(objects);
+
+    std::printf("\n%u objects\n", objects);
+    std::printf("%-16s %12s %14s %12s\n", "phase", "ms", "ops/s", "result");
+    auto report = [](const char* name, const double ms, const double operations, const double result) {
+        std::printf("%-16s %12.2f %14.0f %12.1f\n", name, ms, operations / (ms / 1000.0), result);
+    };
+
+    {
+        const BenchTimer timer;
+        for (std::uint32_t i = 0; i < objects; ++i)
+            proxies[i] = tree.createProxy(boxes[i], i);
+        report("insert", timer.elapsedMs(), objects, tree.height());
+    }
+
+    {
+        std::uint64_t reinserted = 0;
+        const BenchTimer timer;
+        for (int frame = 0; frame < frames; ++frame)
+        {
+            for (std::uint32_t i = 0; i < objects; ++i)
+            {
+                const glm::vec3 offset(step(random), step(random), step(random));
+                boxes[i] = { boxes[i].min + offset, boxes[i].max + offset };
+                reinserted += tree.moveProxy(proxies[i], boxes[i]);
+            }
+        }
+        report("update", timer.elapsedMs(), static_cast<double>(objects) * frames, static_cast<double>(reinserted) / frames);
+    }
+
+    // Queries from a fixed set of cameras, boxes and rays. The result column is the average hit count.
+    std::vector<Frustum> frustums(queries);
+    std::vector<Aabb> regions(queries);
+    std::vector<Ray> rays(queries);
+    const auto projection = glm::perspective(glm::pi<float>() / 3.0f, 16.0f / 9.0f, 0.1f, worldSize * 0.25f);
+    for (int q = 0; q < queries; ++q)
+    {
+        const glm::vec3 eye(position(random), position(random), position(random));
+        const glm::vec3 target(position(random), position(random), position(random));
+        frustums[q] = Frustum::fromMatrix(projection * glm::lookAt(eye, target, glm::vec3(0.0f, 1.0f, 0.0f)));
+        regions[q] = { eye - 10.0f, eye + 10.0f };
+        rays[q] = { eye, glm::normalize(target - eye) };
+    }
+
+    auto runQueries = [&](const char* frustumName, const char* overlapName, const char* rayName) {
+        // Frustum queries return thousands of leaves each, so only a hundredth of them
+        const auto frustumQueries = std::max(1, queries / 100);
+        std::uint64_t hits = 0;
+        BenchTimer timer;
+        for (int q = 0; q < frustumQueries; ++q)
+            tree.queryFrustum(frustums[q], [&](AabbTree::Proxy) { ++hits; });
+        report(frustumName, timer.elapsedMs(), frustumQueries, static_cast<double>(hits) / frustumQueries);
+
+        hits = 0;
+        timer = {};
+        for (int q = 0; q < queries; ++q)
+        {
+            tree.queryOverlap(regions[q], [&](AabbTree::Proxy) {
+                ++hits;
+                return true;
+            });
+        }
+        report(overlapName, timer.elapsedMs(), queries, static_cast<double>(hits) / queries);
+
+        hits = 0;
+        timer = {};
+        for (int q = 0; q < queries; ++q)
+            hits += tree.raycast(rays[q]).proxy != AabbTree::NullProxy;
+        report(rayName, timer.elapsedMs(), queries, static_cast<double>(hits) / queries);
+    };
+
+    runQueries("frustum", "overlap", "raycast");
+    std::printf("%-16s %12s %14s %12.1f\n", "area ratio", "", "", tree.areaRatio());
+
+    {
+        const BenchTimer timer;
+        tree.rebuild();
+        report("rebuild", timer.elapsedMs(), objects, tree.height());
+    }
+
+    runQueries("frustum rebuilt", "overlap rebuilt", "raycast rebuilt");
+    std::printf("%-16s %12s %14s %12.1f\n", "area ratio", "", "", tree.areaRatio());
+}
+
+int main(int argc, char** argv)
+{
+    const auto objects = static_cast<std::uint32_t>(benchArgument(argc, argv, 1, 0));
+    const auto frames = static_cast<int>(benchArgument(argc, argv, 2, 10));
+    const auto queries = static_cast<int>(benchArgument(argc, argv, 3, 10000));
+
+    if (objects > 0)
+    {
+        runTree(objects, frames, queries);
+        return 0;
+    }
+
+    runTree(100000, frames, queries);
+    runTree(1000000, frames, queries);
+    return 0;
+}
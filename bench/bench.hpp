@@ -0,0 +1,126 @@
+#pragma once
+
+#include "gl_state.hpp"
+
+#include <glad/glad.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#if defined(__linux__)
+    #include <EGL/egl.h>
+    #include <EGL/eglext.h>
+#else
+    #include <GLFW/glfw3.h>
+#endif
+
+// Shared setup for the benchmarks. Each one is a standalone executable printing a small table, run with no arguments
+// for the default sizes. GL benchmarks run headless: surfaceless EGL on Linux (so Mesa llvmpipe works without a display),
+// a hidden GLFW window elsewhere.
+
+/* Creates a 4.6 (or failing that 4.5) core context, loads glad and initialises GLState */
+inline auto createBenchContext() -> bool
+{
+#if defined(__linux__)
+    const auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    EGLDisplay display = getPlatformDisplay != nullptr ? getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr)
+                                                       : EGL_NO_DISPLAY;
+    if (display == EGL_NO_DISPLAY)
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+    EGLint major = 0, minor = 0;
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor) || !eglBindAPI(EGL_OPENGL_API))
+    {
+        std::fprintf(stderr, "[Bench] Failed to initialise EGL\n");
+        return false;
+    }
+
+    EGLContext context = EGL_NO_CONTEXT;
+    for (const EGLint version : { 6, 5 })
+    {
+        const EGLint attributes[] = { EGL_CONTEXT_MAJOR_VERSION,       4, EGL_CONTEXT_MINOR_VERSION, version, EGL_CONTEXT_OPENGL_PROFILE_MASK,
+                                      EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT, EGL_NONE };
+        context = eglCreateContext(display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, attributes);
+        if (context != EGL_NO_CONTEXT)
+            break;
+    }
+
+    if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context) ||
+        !gladLoadGLLoader(reinterpret_cast<GLADloadproc>(eglGetProcAddress)))
+    {
+        std::fprintf(stderr, "[Bench] Failed to create a GL 4.5 context\n");
+        return false;
+    }
+#else
+    if (!glfwInit())
+        return false;
+
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    GLFWwindow* window = glfwCreateWindow(64, 64, "Bench", nullptr, nullptr);
+    if (window == nullptr)
+    {
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+        window = glfwCreateWindow(64, 64, "Bench", nullptr, nullptr);
+    }
+
+    if (window == nullptr)
+    {
+        std::fprintf(stderr, "[Bench] Failed to create a GL 4.5 context\n");
+        return false;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSwapInterval(0);
+
+    if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress)))
+        return false;
+#endif
+
+    std::printf("%s | %s\n", reinterpret_cast<const char*>(glGetString(GL_VERSION)), reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+    GLState::init();
+    return true;
+}
+
+/* Small offscreen colour + depth target, so draws have somewhere to go without a default framebuffer */
+inline void bindBenchFramebuffer(const GLsizei width = 64, const GLsizei height = 64)
+{
+    GLuint framebuffer = 0, renderbuffers[2] = {};
+    glCreateFramebuffers(1, &framebuffer);
+    glCreateRenderbuffers(2, renderbuffers);
+    glNamedRenderbufferStorage(renderbuffers[0], GL_RGBA8, width, height);
+    glNamedRenderbufferStorage(renderbuffers[1], GL_DEPTH_COMPONENT24, width, height);
+    glNamedFramebufferRenderbuffer(framebuffer, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffers[0]);
+    glNamedFramebufferRenderbuffer(framebuffer, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, renderbuffers[1]);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    GLState::setViewport(0, 0, width, height);
+}
+
+/* Positional integer argument, `fallback` if missing */
+inline auto benchArgument(const int argc, char** argv, const int index, const long long fallback) -> long long
+{
+    return index < argc ? std::atoll(argv[index]) : fallback;
+}
+
+class BenchTimer
+{
+public:
+    BenchTimer();
+
+    auto elapsedMs() const -> double;
+
+private:
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point m_start;
+};
+
+inline BenchTimer::BenchTimer() : m_start(Clock::now())
+{
+}
+
+inline auto BenchTimer::elapsedMs() const -> double
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - m_start).count();
+}
@@ -0,0 +1,90 @@
+#include "bench.hpp"
+#include "culling.hpp"
+
+#include <glm/ext/matrix_clip_space.hpp>
+#include <glm/ext/matrix_transform.hpp>
+#include <glm/ext/scalar_constants.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+// Frustum culling kernels: scalar, SSE2 and AVX2 over the same random set of boxes scattered around a camera, plus
+// the dispatching cullFrustum and cullFrustumParallel. CPU only, no context. Every path must produce exactly the
+// scalar visible list, a mismatch fails the run. Kernels the build or CPU lacks are reported as skipped.
+//
+//   culling_bench [objects = 1000000] [iterations = 20] [threads = 0 (hardware)]
+
+int main(int argc, char** argv)
+{
+    const auto objects = static_cast<std::uint32_t>(benchArgument(argc, argv, 1, 1000000));
+    const auto iterations = static_cast<int>(benchArgument(argc, argv, 2, 20));
+    const auto threads = static_cast<std::uint32_t>(benchArgument(argc, argv, 3, 0));
+
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+    std::uniform_real_distribution<float> size(0.5f, 10.0f);
+
+    CullingSet set;
+    set.reserve(objects);
+    for (std::uint32_t i = 0; i < objects; ++i)
+    {
+        const glm::vec3 centre(position(random), position(random) * 0.1f, position(random));
+        const glm::vec3 extent(size(random), size(random), size(random));
+        set.add(centre - extent, centre + extent);
+    }
+
+    const auto projection = glm::perspective(glm::pi<float>() / 3.0f, 16.0f / 9.0f, 0.1f, 400.0f);
+    const auto view = glm::lookAt(glm::vec3(0.0f, 20.0f, 0.0f), glm::vec3(100.0f, 0.0f, 60.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    const auto frustum = Frustum::fromMatrix(projection * view);
+
+    ThreadPool pool;
+    pool.init(threads);
+
+    std::vector<std::uint32_t> reference(set.size());
+    reference.resize(cullFrustumScalar(set, frustum, 0, set.size(), reference.data()));
+
+    std::printf("%u objects, %zu visible, %d iterations, %u pool threads\n", set.size(), reference.size(), iterations, pool.threadCount());
+    std::printf("%-10s %12s %14s %8s\n", "kernel", "ms/cull", "Mobjects/s", "match");
+
+    bool allMatch = true;
+    std::vector<std::uint32_t> visible;
+    auto run = [&](const char* name, auto&& cull) {
+        cull(); // Warm up
+        const BenchTimer timer;
+        for (int iteration = 0; iteration < iterations; ++iteration)
+            cull();
+        const auto ms = timer.elapsedMs() / iterations;
+
+        const auto match = visible == reference;
+        allMatch &= match;
+        std::printf("%-10s %12.3f %14.1f %8s\n", name, ms, set.size() / (ms * 1000.0), match ? "yes" : "NO");
+    };
+
+    auto kernel = [&](auto&& cullRange) {
+        return [&, cullRange] {
+            visible.resize(set.size());
+            visible.resize(cullRange(set, frustum, 0, set.size(), visible.data()));
+        };
+    };
+
+    run("scalar", kernel(cullFrustumScalar));
+#if defined(SIMD_SSE2)
+    run("sse2", kernel(cullFrustumSse2));
+#else
+    std::printf("%-10s %12s\n", "sse2", "skipped");
+#endif
+#if defined(SIMD_AVX2_DISPATCH)
+    if (simdHasAvx2())
+        run("avx2", kernel(cullFrustumAvx2));
+    else
+        std::printf("%-10s %12s\n", "avx2", "skipped");
+#else
+    std::printf("%-10s %12s\n", "avx2", "skipped");
+#endif
+    run("dispatch", [&] { cullFrustum(set, frustum, visible); });
+    run("parallel", [&] { cullFrustumParallel(set, frustum, pool, visible); });
+
+    return allMatch ? 0 : 1;
+}
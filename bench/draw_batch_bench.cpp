@@ -0,0 +1,131 @@
+#include "bench.hpp"
+#include "draw_batch.hpp"
+#include "geometry_pool.hpp"
+#include "mesh.hpp"
+#include "shader.hpp"
+
+#include <glad/glad.h>
+#include <glm/ext/vector_float3.hpp>
+#include <glm/ext/vector_float4.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+// Draw-call throughput: N small meshes drawn one by one (bind program, set a uniform, bind the mesh, glDrawElements)
+// against the same meshes suballocated from a GeometryPool and submitted as one DrawBatch, with the per-draw offset
+// read from an SSBO by gl_DrawID.
+//
+//   draw_batch_bench [objects = 10000] [frames = 50]
+
+struct PositionVertex
+{
+    glm::vec3 pos = {};
+};
+
+VERTEX_LAYOUT(PositionVertex, VERTEX_ATTRIB(0, pos));
+
+constexpr const char* LoopVertexSource = R"(#version 450 core
+layout(location = 0) in vec3 position;
+uniform vec4 offset;
+void main() { gl_Position = vec4(position.xy * 0.01 + offset.xy, 0.0, 1.0); }
+)";
+
+constexpr const char* BatchVertexSource = R"(#version 450 core
+#extension GL_ARB_shader_draw_parameters : require
+layout(location = 0) in vec3 position;
+layout(std430, binding = 0) readonly buffer DrawData { vec4 offsets[]; };
+void main() { gl_Position = vec4(position.xy * 0.01 + offsets[gl_DrawIDARB].xy, 0.0, 1.0); }
+)";
+
+constexpr const char* FragmentSource = R"(#version 450 core
+out vec4 colour;
+void main() { colour = vec4(1.0); }
+)";
+
+constexpr PositionVertex QuadVertices[] = { { { -1, -1, 0 } }, { { 1, -1, 0 } }, { { 1, 1, 0 } }, { { -1, 1, 0 } } };
+constexpr std::uint32_t QuadIndices[] = { 0, 1, 2, 2, 3, 0 };
+
+int main(int argc, char** argv)
+{
+    const auto objects = static_cast<std::uint32_t>(benchArgument(argc, argv, 1, 10000));
+    const auto frames = static_cast<int>(benchArgument(argc, argv, 2, 50));
+
+    if (!createBenchContext())
+        return 1;
+    bindBenchFramebuffer();
+
+    std::vector<glm::vec4> offsets(objects);
+    for (std::uint32_t i = 0; i < objects; ++i)
+        offsets[i] = { static_cast<float>(i % 100) / 50.0f - 1.0f, static_cast<float>(i / 100 % 100) / 50.0f - 1.0f, 0.0f, 0.0f };
+
+    // Per-mesh loop
+    Shader loopShader;
+    loopShader.init(LoopVertexSource, FragmentSource);
+    const auto offsetUniform = loopShader.uniform<glm::vec4>("offset");
+
+    std::vector<std::unique_ptr<Mesh<std::uint32_t>>> meshes;
+    for (std::uint32_t i = 0; i < objects; ++i)
+    {
+        auto& mesh = meshes.emplace_back(std::make_unique<Mesh<std::uint32_t>>());
+        mesh->setImmutableVertices(QuadVertices, sizeof(QuadVertices));
+        mesh->setImmutableIndices(QuadIndices, std::size(QuadIndices));
+        mesh->apply<PositionVertex>(GL_TRIANGLES);
+    }
+
+    // Batched
+    Shader batchShader;
+    batchShader.init(BatchVertexSource, FragmentSource);
+
+    GeometryPool<std::uint32_t> pool;
+    pool.init<PositionVertex>(GL_TRIANGLES, objects * 4, objects * 6);
+    std::vector<GeometryPool<std::uint32_t>::Handle> handles;
+    for (std::uint32_t i = 0; i < objects; ++i)
+        handles.push_back(pool.allocate(QuadVertices, 4, QuadIndices, 6));
+
+    DrawBatch<std::uint32_t> batch;
+    batch.init(GL_TRIANGLES, sizeof(glm::vec4), objects);
+
+    auto drawLoop = [&] {
+        for (std::uint32_t i = 0; i < objects; ++i)
+        {
+            loopShader.bind();
+            loopShader.set(offsetUniform, offsets[i]);
+            meshes[i]->bind();
+            meshes[i]->draw();
+        }
+    };
+
+    auto drawBatch = [&] {
+        batch.clear();
+        for (std::uint32_t i = 0; i < objects; ++i)
+            batch.add(pool.range(handles[i]), &offsets[i]);
+
+        batchShader.bind();
+        pool.bind();
+        batch.submit();
+    };
+
+    std::printf("%u objects, %d frames\n", objects, frames);
+    std::printf("%-10s %14s %14s %14s\n", "path", "submit ms/f", "total ms/f", "draws/s");
+
+    auto run = [&](const char* name, auto&& draw) {
+        draw(); // Warm up
+        glFinish();
+
+        const BenchTimer timer;
+        for (int frame = 0; frame < frames; ++frame)
+            draw();
+        const auto submitMs = timer.elapsedMs();
+        glFinish();
+        const auto totalMs = timer.elapsedMs();
+
+        std::printf("%-10s %14.3f %14.3f %14.0f\n", name, submitMs / frames, totalMs / frames, objects * frames / (totalMs / 1000.0));
+    };
+
+    run("loop", drawLoop);
+    run("batch", drawBatch);
+
+    return glGetError() == GL_NO_ERROR ? 0 : 1;
+}
@@ -0,0 +1,122 @@
+#include "bench.hpp"
+#include "gpu_culling.hpp"
+
+#include <glad/glad.h>
+#include <glm/ext/matrix_clip_space.hpp>
+#include <glm/ext/matrix_transform.hpp>
+#include <glm/ext/scalar_constants.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+// GpuCuller's compute pass against the CPU: random spheres are frustum culled on the GPU from several cameras, the draw
+// count and commands are read back and must match Frustum::intersectsSphere exactly, command for command (sorted by
+// baseInstance, the GPU appends in any order). Without glMultiDrawElementsIndirectCount the slots past the draw count
+// must also be zeroed. Reports the GPU time per cull, including the readback stall, and the CPU time for the same test.
+//
+//   gpu_culling_bench [instances = 100000] [iterations = 10]
+
+int main(int argc, char** argv)
+{
+    const auto instanceCount = static_cast<std::uint32_t>(benchArgument(argc, argv, 1, 100000));
+    const auto iterations = static_cast<int>(benchArgument(argc, argv, 2, 10));
+
+    if (!createBenchContext())
+        return 1;
+
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+    std::uniform_real_distribution<float> radius(0.5f, 10.0f);
+
+    std::vector<GpuCullInstance> instances(instanceCount);
+    for (std::uint32_t i = 0; i < instanceCount; ++i)
+    {
+        auto& instance = instances[i];
+        instance.sphere = glm::vec4(position(random), position(random) * 0.1f, position(random), radius(random));
+        instance.indexCount = 3 + 3 * (i % 64);
+        instance.firstIndex = i * 3;
+        instance.baseVertex = static_cast<GLint>(i % 1000);
+        instance.instanceCount = 1 + i % 4;
+    }
+
+    GpuCuller culler;
+    culler.init(instanceCount);
+    culler.setInstances(instances.data(), instanceCount);
+
+    const auto countPath = glMultiDrawElementsIndirectCount != nullptr;
+    std::printf("%u instances, %d iterations, %s\n", instanceCount, iterations,
+                countPath ? "glMultiDrawElementsIndirectCount" : "no indirect count, zeroed tail");
+    std::printf("%-8s %10s %10s %10s %12s %12s %8s\n", "camera", "gpu draws", "cpu draws", "visible%", "gpu ms/cull", "cpu ms/cull", "match");
+
+    const auto projection = glm::perspective(glm::pi<float>() / 3.0f, 16.0f / 9.0f, 0.1f, 400.0f);
+    const glm::vec3 up(0.0f, 1.0f, 0.0f);
+
+    bool allMatch = true;
+    std::vector<DrawElementsIndirectCommand> commands(instanceCount);
+    std::vector<DrawElementsIndirectCommand> expected;
+    expected.reserve(instanceCount);
+    auto run = [&](const char* name, const glm::vec3& eye, const glm::vec3& target) {
+        const auto frustum = Frustum::fromMatrix(projection * glm::lookAt(eye, target, up));
+
+        BenchTimer timer;
+        for (int iteration = 0; iteration < iterations; ++iteration)
+        {
+            expected.clear();
+            for (std::uint32_t i = 0; i < instanceCount; ++i)
+            {
+                const auto& instance = instances[i];
+                if (frustum.intersectsSphere(glm::vec3(instance.sphere), instance.sphere.w))
+                    expected.push_back({ instance.indexCount, instance.instanceCount, instance.firstIndex, instance.baseVertex, i });
+            }
+        }
+        const auto cpuMs = timer.elapsedMs() / iterations;
+
+        // Warm up, then time the dispatch up to the count readback
+        culler.cull(frustum);
+        culler.readDrawCount();
+        timer = {};
+        std::uint32_t drawCount = 0;
+        for (int iteration = 0; iteration < iterations; ++iteration)
+        {
+            culler.cull(frustum);
+            drawCount = culler.readDrawCount();
+        }
+        const auto gpuMs = timer.elapsedMs() / iterations;
+
+        glGetNamedBufferSubData(culler.commandBuffer(), 0, static_cast<GLsizeiptr>(instanceCount * sizeof(DrawElementsIndirectCommand)), commands.data());
+        const auto byInstance = [](const DrawElementsIndirectCommand& lhs, const DrawElementsIndirectCommand& rhs) {
+            return lhs.baseInstance < rhs.baseInstance;
+        };
+        const auto same = [](const DrawElementsIndirectCommand& lhs, const DrawElementsIndirectCommand& rhs) {
+            return lhs.count == rhs.count && lhs.instanceCount == rhs.instanceCount && lhs.firstIndex == rhs.firstIndex && lhs.baseVertex == rhs.baseVertex
+                   && lhs.baseInstance == rhs.baseInstance;
+        };
+
+        auto match = drawCount == expected.size();
+        if (match)
+        {
+            std::sort(commands.begin(), commands.begin() + drawCount, byInstance);
+            match = std::equal(expected.begin(), expected.end(), commands.begin(), same);
+        }
+        // The fallback draws every slot, so the ones past the count have to be empty draws
+        if (match && !countPath)
+        {
+            match = std::all_of(commands.begin() + drawCount, commands.end(),
+                                [](const DrawElementsIndirectCommand& command) { return command.count == 0 && command.instanceCount == 0; });
+        }
+        allMatch &= match;
+
+        std::printf("%-8s %10u %10zu %10.1f %12.3f %12.3f %8s\n", name, drawCount, expected.size(), 100.0 * expected.size() / instanceCount, gpuMs, cpuMs,
+                    match ? "yes" : "NO");
+    };
+
+    run("centre", glm::vec3(0.0f, 20.0f, 0.0f), glm::vec3(100.0f, 0.0f, 60.0f));
+    run("corner", glm::vec3(-500.0f, 30.0f, -500.0f), glm::vec3(0.0f));
+    run("above", glm::vec3(0.0f, 300.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+    run("outside", glm::vec3(0.0f, 0.0f, 900.0f), glm::vec3(0.0f, 0.0f, 2000.0f));
+
+    return allMatch && glGetError() == GL_NO_ERROR ? 0 : 1;
+}
@@ -0,0 +1,123 @@
+#include "bench.hpp"
+#include "mesh.hpp"
+#include "shader.hpp"
+
+#include <glad/glad.h>
+#include <glm/ext/vector_float3.hpp>
+#include <glm/ext/vector_float4.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+// Instancing: N copies of one mesh drawn one by one (set a uniform, glDrawElements) against a single
+// glDrawElementsInstanced reading per-instance offsets from the mesh's streamed instance buffer. The instanced path
+// rewrites the instances after the mesh is bound, so each frame reads the segment setInstances just wrote.
+//
+//   instancing_bench [instances = 10000] [frames = 50]
+
+struct PositionVertex
+{
+    glm::vec3 pos = {};
+};
+
+struct OffsetInstance
+{
+    glm::vec4 offset = {};
+};
+
+VERTEX_LAYOUT(PositionVertex, VERTEX_ATTRIB(0, pos));
+VERTEX_LAYOUT(OffsetInstance, VERTEX_ATTRIB(1, offset));
+
+constexpr const char* DrawVertexSource = R"(#version 450 core
+layout(location = 0) in vec3 position;
+uniform vec4 offset;
+void main() { gl_Position = vec4(position.xy * 0.01 + offset.xy, 0.0, 1.0); }
+)";
+
+constexpr const char* InstancedVertexSource = R"(#version 450 core
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec4 offset;
+void main() { gl_Position = vec4(position.xy * 0.01 + offset.xy, 0.0, 1.0); }
+)";
+
+constexpr const char* FragmentSource = R"(#version 450 core
+out vec4 colour;
+void main() { colour = vec4(1.0); }
+)";
+
+constexpr PositionVertex QuadVertices[] = { { { -1, -1, 0 } }, { { 1, -1, 0 } }, { { 1, 1, 0 } }, { { -1, 1, 0 } } };
+constexpr std::uint32_t QuadIndices[] = { 0, 1, 2, 2, 3, 0 };
+
+int main(int argc, char** argv)
+{
+    const auto instances = static_cast<std::uint32_t>(benchArgument(argc, argv, 1, 10000));
+    const auto frames = static_cast<int>(benchArgument(argc, argv, 2, 50));
+
+    if (!createBenchContext())
+        return 1;
+    bindBenchFramebuffer();
+
+    std::vector<OffsetInstance> offsets(instances);
+    for (std::uint32_t i = 0; i < instances; ++i)
+        offsets[i].offset = { static_cast<float>(i % 100) / 50.0f - 1.0f, static_cast<float>(i / 100 % 100) / 50.0f - 1.0f, 0.0f, 0.0f };
+
+    // Individual draws, with the mesh and program bound once so only the per-draw cost is measured
+    Shader drawShader;
+    drawShader.init(DrawVertexSource, FragmentSource);
+    const auto offsetUniform = drawShader.uniform<glm::vec4>("offset");
+
+    Mesh<std::uint32_t> mesh;
+    mesh.setImmutableVertices(QuadVertices, sizeof(QuadVertices));
+    mesh.setImmutableIndices(QuadIndices, std::size(QuadIndices));
+    mesh.apply<PositionVertex>(GL_TRIANGLES);
+
+    // Instanced
+    Shader instancedShader;
+    instancedShader.init(InstancedVertexSource, FragmentSource);
+
+    Mesh<std::uint32_t> instancedMesh;
+    instancedMesh.setImmutableVertices(QuadVertices, sizeof(QuadVertices));
+    instancedMesh.setImmutableIndices(QuadIndices, std::size(QuadIndices));
+    instancedMesh.apply<PositionVertex, OffsetInstance>(GL_TRIANGLES);
+    instancedMesh.reserveInstances(instances);
+
+    auto drawIndividually = [&] {
+        drawShader.bind();
+        mesh.bind();
+        for (std::uint32_t i = 0; i < instances; ++i)
+        {
+            drawShader.set(offsetUniform, offsets[i].offset);
+            mesh.draw();
+        }
+    };
+
+    auto drawInstanced = [&] {
+        instancedShader.bind();
+        instancedMesh.bind();
+        instancedMesh.setInstances(offsets.data(), instances);
+        instancedMesh.drawInstanced(static_cast<GLsizei>(instances));
+    };
+
+    std::printf("%u instances, %d frames\n", instances, frames);
+    std::printf("%-10s %14s %14s %14s\n", "path", "submit ms/f", "total ms/f", "instances/s");
+
+    auto run = [&](const char* name, auto&& draw) {
+        draw(); // Warm up
+        glFinish();
+
+        const BenchTimer timer;
+        for (int frame = 0; frame < frames; ++frame)
+            draw();
+        const auto submitMs = timer.elapsedMs();
+        glFinish();
+        const auto totalMs = timer.elapsedMs();
+
+        std::printf("%-10s %14.3f %14.3f %14.0f\n", name, submitMs / frames, totalMs / frames, instances * frames / (totalMs / 1000.0));
+    };
+
+    run("draws", drawIndividually);
+    run("instanced", drawInstanced);
+
+    return glGetError() == GL_NO_ERROR ? 0 : 1;
+}
@@ -0,0 +1,135 @@
+#include "bench.hpp"
+#include "mesh_optimiser.hpp"
+
+#include <glm/ext/scalar_constants.hpp>
+#include <glm/ext/vector_float3.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <numeric>
+#include <random>
+#include <vector>
+
+// Mesh optimiser passes on a UV sphere with its vertices and triangles shuffled: post-transform cache efficiency (ACMR
+// and ATVR for a 16 and 32 entry FIFO cache) and vertex fetch misses before and after each pass, and the time each pass
+// takes. CPU only, no context needed.
+//
+//   mesh_optimiser_bench [rings = 512] [segments = 1024]
+
+struct Vertex
+{
+    glm::vec3 position;
+    glm::vec3 normal;
+};
+
+/* Vertex fetches that miss a 32KB direct-mapped cache of 64 byte lines, per vertex. Only post-transform cache misses
+   fetch, so this measures what optimiseVertexFetch improves on top of the cache order. */
+static auto fetchMissRatio(const std::vector<std::uint32_t>& indices, const std::size_t vertexCount) -> double
+{
+    constexpr std::uint32_t CacheSize = 16, LineSize = 64, LineCount = 512;
+
+    std::vector<std::uint32_t> timestamps(vertexCount, 0);
+    std::uint32_t time = CacheSize + 1;
+    std::vector<std::size_t> lines(LineCount, ~std::size_t(0));
+    std::size_t misses = 0;
+    for (const auto index : indices)
+    {
+        if (time - timestamps[index] <= CacheSize)
+            continue;
+        timestamps[index] = time++;
+
+        // A vertex may straddle two lines
+        const auto first = index * sizeof(Vertex) / LineSize, last = ((index + 1) * sizeof(Vertex) - 1) / LineSize;
+        for (auto line = first; line <= last; ++line)
+        {
+            if (lines[line % LineCount] != line)
+            {
+                lines[line % LineCount] = line;
+                ++misses;
+            }
+        }
+    }
+    return static_cast<double>(misses) / static_cast<double>(vertexCount);
+}
+
+int main(int argc, char** argv)
+{
+    const auto rings = static_cast<std::uint32_t>(benchArgument(argc, argv, 1, 512));
+    const auto segments = static_cast<std::uint32_t>(benchArgument(argc, argv, 2, 1024));
+
+    std::vector<Vertex> vertices;
+    for (std::uint32_t ring = 0; ring <= rings; ++ring)
+    {
+        const auto theta = glm::pi<float>() * static_cast<float>(ring) / static_cast<float>(rings);
+        for (std::uint32_t segment = 0; segment <= segments; ++segment)
+        {
+            const auto phi = 2.0f * glm::pi<float>() * static_cast<float>(segment) / static_cast<float>(segments);
+            const glm::vec3 normal(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+            vertices.push_back({ normal, normal });
+        }
+    }
+
+    std::vector<std::array<std::uint32_t, 3>> triangles;
+    for (std::uint32_t ring = 0; ring < rings; ++ring)
+    {
+        for (std::uint32_t segment = 0; segment < segments; ++segment)
+        {
+            const auto v = ring * (segments + 1) + segment;
+            triangles.push_back({ v, v + segments + 1, v + 1 });
+            triangles.push_back({ v + 1, v + segments + 1, v + segments + 2 });
+        }
+    }
+    // Shuffle vertices as well as triangles, the grid order a generated sphere starts with already fetches well
+    std::mt19937 random(42);
+    std::vector<std::uint32_t> remap(vertices.size());
+    std::iota(remap.begin(), remap.end(), 0u);
+    std::shuffle(remap.begin(), remap.end(), random);
+    std::vector<Vertex> shuffled(vertices.size());
+    for (std::size_t v = 0; v < vertices.size(); ++v)
+        shuffled[remap[v]] = vertices[v];
+    vertices.swap(shuffled);
+    for (auto& triangle : triangles)
+        triangle = { remap[triangle[0]], remap[triangle[1]], remap[triangle[2]] };
+    std::shuffle(triangles.begin(), triangles.end(), random);
+
+    std::vector<std::uint32_t> indices(triangles.size() * 3);
+    std::memcpy(indices.data(), triangles.data(), indices.size() * sizeof(std::uint32_t));
+    auto vertexCount = vertices.size();
+
+    std::printf("%zu vertices, %zu triangles (shuffled)\n", vertexCount, triangles.size());
+    std::printf("%-8s %10s %10s %10s %10s %10s %12s\n", "pass", "ms", "acmr16", "atvr16", "acmr32", "atvr32", "fetch miss");
+
+    auto report = [&](const char* name, const double ms) {
+        const auto cache16 = analyseVertexCache(indices.data(), indices.size(), vertexCount, 16);
+        const auto cache32 = analyseVertexCache(indices.data(), indices.size(), vertexCount, 32);
+        std::printf("%-8s %10.2f %10.3f %10.3f %10.3f %10.3f %12.3f\n", name, ms, cache16.acmr, cache16.atvr, cache32.acmr, cache32.atvr,
+                    fetchMissRatio(indices, vertexCount));
+    };
+
+    report("input", 0.0);
+
+    {
+        std::vector<std::uint32_t> optimised(indices.size());
+        const BenchTimer timer;
+        optimiseVertexCache(optimised.data(), indices.data(), indices.size(), vertexCount);
+        const auto ms = timer.elapsedMs();
+        indices.swap(optimised);
+        report("cache", ms);
+    }
+    {
+        const BenchTimer timer;
+        optimiseOverdraw(indices.data(), indices.size(), vertices.data(), vertexCount, sizeof(Vertex));
+        report("overdraw", timer.elapsedMs());
+    }
+    {
+        const BenchTimer timer;
+        vertexCount = optimiseVertexFetch(vertices.data(), indices.data(), indices.size(), vertexCount, sizeof(Vertex));
+        report("fetch", timer.elapsedMs());
+    }
+
+    return 0;
+}
@@ -0,0 +1,96 @@
+#include "bench.hpp"
+#include "mesh_simplifier.hpp"
+
+#include <glm/ext/vector_float3.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <future>
+#include <vector>
+
+// LOD chain generation on a rolling heightfield grid (708 cells square is ~1M triangles). Times the whole of
+// generateLodChain, then each level on its own by simplifying the previous level again with the same target, and finally
+// several chains built at once with generateLodChainAsync against the same count built back to back. CPU only.
+//
+//   mesh_simplifier_bench [cells = 708] [meshes = 2]
+
+int main(int argc, char** argv)
+{
+    const auto cells = static_cast<std::uint32_t>(benchArgument(argc, argv, 1, 708));
+    const auto meshes = static_cast<std::uint32_t>(benchArgument(argc, argv, 2, 2));
+
+    // Gentle hills rather than a flat plane, so collapses have a non-zero error to rank by
+    std::vector<glm::vec3> positions;
+    for (std::uint32_t y = 0; y <= cells; ++y)
+    {
+        for (std::uint32_t x = 0; x <= cells; ++x)
+        {
+            const auto u = static_cast<float>(x) / static_cast<float>(cells), v = static_cast<float>(y) / static_cast<float>(cells);
+            positions.emplace_back(u * 100.0f, 4.0f * std::sin(u * 12.0f) * std::cos(v * 9.0f) + std::sin(u * 40.0f + v * 31.0f), v * 100.0f);
+        }
+    }
+
+    std::vector<std::uint32_t> indices;
+    for (std::uint32_t y = 0; y < cells; ++y)
+    {
+        for (std::uint32_t x = 0; x < cells; ++x)
+        {
+            const auto v = y * (cells + 1) + x;
+            indices.insert(indices.end(), { v, v + cells + 1, v + 1, v + 1, v + cells + 1, v + cells + 2 });
+        }
+    }
+    const auto vertexCount = positions.size();
+    std::printf("%zu vertices, %zu triangles\n", vertexCount, indices.size() / 3);
+
+    BenchTimer timer;
+    const auto chain = generateLodChain(indices.data(), indices.size(), positions.data(), vertexCount, sizeof(glm::vec3));
+    const auto chainMs = timer.elapsedMs();
+    std::printf("generateLodChain: %zu levels in %.1f ms\n\n", chain.levels.size(), chainMs);
+
+    // Level 0 is the source, every later level is one simplifyMesh over the level before it
+    bool matches = true;
+    std::printf("%-6s %10s %10s %12s %10s\n", "level", "triangles", "ratio", "error", "ms");
+    std::printf("%-6u %10u %10.3f %12.5f %10s\n", 0u, chain.levels[0].indexCount / 3, 1.0, 0.0, "-");
+    for (std::size_t level = 1; level < chain.levels.size(); ++level)
+    {
+        const auto& previous = chain.levels[level - 1];
+        const auto target = static_cast<std::size_t>(static_cast<float>(previous.indexCount) * 0.5f) / 3 * 3;
+
+        timer = {};
+        const auto result = simplifyMesh(chain.indices.data() + previous.firstIndex, previous.indexCount, positions.data(), vertexCount,
+                                         sizeof(glm::vec3), 0, target);
+        const auto ms = timer.elapsedMs();
+        matches = matches && result.indices.size() == chain.levels[level].indexCount;
+
+        std::printf("%-6zu %10u %10.3f %12.5f %10.1f\n", level, chain.levels[level].indexCount / 3,
+                    static_cast<double>(chain.levels[level].indexCount) / static_cast<double>(chain.levels[0].indexCount),
+                    static_cast<double>(chain.levels[level].error), ms);
+    }
+
+    // Async only helps with spare cores; with one core the two should be about even
+    std::vector<std::uint8_t> vertexBytes(vertexCount * sizeof(glm::vec3));
+    std::memcpy(vertexBytes.data(), positions.data(), vertexBytes.size());
+
+    const auto sameChain = [&](const LodChain& other) { return other.indices == chain.indices && other.levels.size() == chain.levels.size(); };
+
+    timer = {};
+    for (std::uint32_t i = 0; i < meshes; ++i)
+        matches = sameChain(generateLodChain(indices.data(), indices.size(), positions.data(), vertexCount, sizeof(glm::vec3))) && matches;
+    const auto serialMs = timer.elapsedMs();
+
+    timer = {};
+    std::vector<std::future<LodChain>> futures;
+    for (std::uint32_t i = 0; i < meshes; ++i)
+        futures.push_back(generateLodChainAsync(indices, vertexBytes, sizeof(glm::vec3)));
+    for (auto& future : futures)
+        matches = sameChain(future.get()) && matches;
+    const auto asyncMs = timer.elapsedMs();
+
+    std::printf("\n%u chains: serial %.1f ms, async %.1f ms (%.2fx)\n", meshes, serialMs, asyncMs, serialMs / asyncMs);
+    if (!matches)
+        std::printf("Level mismatch between runs!\n");
+
+    return matches ? 0 : 1;
+}
@@ -0,0 +1,91 @@
+#include "bench.hpp"
+#include "mesh_optimiser.hpp"
+#include "meshlet.hpp"
+
+#include <glm/ext/matrix_clip_space.hpp>
+#include <glm/ext/matrix_transform.hpp>
+#include <glm/ext/scalar_constants.hpp>
+#include <glm/ext/vector_float3.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+// Meshlet culling on a dense unit UV sphere (cache optimised, then split into 64 vertex / 124 triangle meshlets),
+// viewed from several cameras: far and near the surface, grazing the edge of the view and facing away. Reports how
+// many meshlets and triangles survive the frustum and normal cone tests, how many indirect commands the surviving runs
+// merge into, and the time per cullMeshlets call. CPU only, no context needed.
+//
+//   meshlet_bench [rings = 1024] [segments = 2048] [iterations = 50]
+
+int main(int argc, char** argv)
+{
+    const auto rings = static_cast<std::uint32_t>(benchArgument(argc, argv, 1, 1024));
+    const auto segments = static_cast<std::uint32_t>(benchArgument(argc, argv, 2, 2048));
+    const auto iterations = static_cast<int>(benchArgument(argc, argv, 3, 50));
+
+    std::vector<glm::vec3> positions;
+    for (std::uint32_t ring = 0; ring <= rings; ++ring)
+    {
+        const auto theta = glm::pi<float>() * static_cast<float>(ring) / static_cast<float>(rings);
+        for (std::uint32_t segment = 0; segment <= segments; ++segment)
+        {
+            const auto phi = 2.0f * glm::pi<float>() * static_cast<float>(segment) / static_cast<float>(segments);
+            positions.emplace_back(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+        }
+    }
+
+    std::vector<std::uint32_t> indices;
+    for (std::uint32_t ring = 0; ring < rings; ++ring)
+    {
+        for (std::uint32_t segment = 0; segment < segments; ++segment)
+        {
+            const auto v = ring * (segments + 1) + segment;
+            indices.insert(indices.end(), { v, v + segments + 1, v + 1, v + 1, v + segments + 1, v + segments + 2 });
+        }
+    }
+
+    std::vector<std::uint32_t> optimised(indices.size());
+    optimiseVertexCache(optimised.data(), indices.data(), indices.size(), positions.size());
+
+    BenchTimer timer;
+    const auto set = buildMeshlets(optimised.data(), optimised.size(), positions.data(), positions.size(), sizeof(glm::vec3));
+    std::printf("%zu vertices, %zu triangles, %zu meshlets built in %.1f ms, %d iterations\n", positions.size(), indices.size() / 3, set.meshlets.size(),
+                timer.elapsedMs(), iterations);
+    std::printf("%-8s %10s %10s %12s %12s %9s %10s %10s\n", "camera", "meshlets", "visible", "triangles", "visible", "visible%", "commands", "ms/cull");
+
+    const auto projection = glm::perspective(glm::pi<float>() / 3.0f, 16.0f / 9.0f, 0.01f, 100.0f);
+    const glm::vec3 up(0.0f, 1.0f, 0.0f);
+
+    std::vector<DrawElementsIndirectCommand> commands;
+    commands.reserve(set.meshlets.size());
+    auto run = [&](const char* name, const glm::vec3& eye, const glm::vec3& target) {
+        const auto frustum = Frustum::fromMatrix(projection * glm::lookAt(eye, target, up));
+
+        MeshletCullStats stats;
+        commands.clear();
+        stats = cullMeshlets(set, frustum, eye, 0, 0, 0, commands); // Warm up
+
+        timer = {};
+        for (int iteration = 0; iteration < iterations; ++iteration)
+        {
+            commands.clear();
+            stats = cullMeshlets(set, frustum, eye, 0, 0, 0, commands);
+        }
+        const auto ms = timer.elapsedMs() / iterations;
+
+        const auto percent = stats.triangles > 0 ? 100.0 * static_cast<double>(stats.visibleTriangles) / static_cast<double>(stats.triangles) : 0.0;
+        std::printf("%-8s %10u %10u %12llu %12llu %9.1f %10zu %10.3f\n", name, stats.meshlets, stats.visibleMeshlets,
+                    static_cast<unsigned long long>(stats.triangles), static_cast<unsigned long long>(stats.visibleTriangles), percent, commands.size(), ms);
+    };
+
+    // Far away only the back half goes, close up the cone test removes more and the frustum clips the rest
+    run("far", glm::vec3(0.0f, 0.0f, 4.0f), glm::vec3(0.0f));
+    run("near", glm::vec3(0.0f, 0.0f, 1.2f), glm::vec3(0.0f));
+    run("surface", glm::vec3(0.0f, 0.3f, 1.05f), glm::vec3(0.0f, -0.3f, 0.9f));
+    run("edge", glm::vec3(0.0f, 0.0f, 3.0f), glm::vec3(3.5f, 0.0f, 0.0f));
+    run("away", glm::vec3(0.0f, 0.0f, 3.0f), glm::vec3(0.0f, 0.0f, 6.0f));
+
+    return 0;
+}
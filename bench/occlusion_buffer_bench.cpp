@@ -0,0 +1,128 @@
+#include "bench.hpp"
+#include "occlusion_buffer.hpp"
+
+#include <glm/ext/matrix_clip_space.hpp>
+#include <glm/ext/matrix_transform.hpp>
+#include <glm/ext/scalar_constants.hpp>
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+// Software occlusion on a street-level view of a city block grid: every building box is queued as an occluder, then
+// the buffer is rasterised serially and in bands across a ThreadPool (both must produce identical depth), and finally
+// random object boxes are tested with isVisible. Reports the time to queue the occluders, to rasterise them and per
+// visibility query, plus how many objects the occluders hide. CPU only, no context needed.
+//
+//   occlusion_buffer_bench [buildings = 2000] [objects = 200000] [iterations = 20] [threads = 0 (hardware)]
+
+static constexpr std::uint32_t BoxIndices[] = {
+    0, 2, 1, 0, 3, 2, // -z
+    4, 5, 6, 4, 6, 7, // +z
+    0, 1, 5, 0, 5, 4, // -y
+    3, 7, 6, 3, 6, 2, // +y
+    0, 4, 7, 0, 7, 3, // -x
+    1, 2, 6, 1, 6, 5, // +x
+};
+
+/* Corners in the order BoxIndices winds counter-clockwise from outside */
+static auto boxCorners(const glm::vec3& min, const glm::vec3& max) -> std::array<glm::vec3, 8>
+{
+    return { glm::vec3(min.x, min.y, min.z), glm::vec3(max.x, min.y, min.z), glm::vec3(max.x, max.y, min.z), glm::vec3(min.x, max.y, min.z),
+             glm::vec3(min.x, min.y, max.z), glm::vec3(max.x, min.y, max.z), glm::vec3(max.x, max.y, max.z), glm::vec3(min.x, max.y, max.z) };
+}
+
+int main(int argc, char** argv)
+{
+    const auto buildings = static_cast<std::uint32_t>(benchArgument(argc, argv, 1, 2000));
+    const auto objects = static_cast<std::uint32_t>(benchArgument(argc, argv, 2, 200000));
+    const auto iterations = static_cast<int>(benchArgument(argc, argv, 3, 20));
+    const auto threads = static_cast<std::uint32_t>(benchArgument(argc, argv, 4, 0));
+
+    // Buildings on a 20 unit grid, objects scattered in the streets between them
+    std::mt19937 random(3);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    const auto gridSize = static_cast<std::uint32_t>(std::ceil(std::sqrt(static_cast<float>(buildings))));
+    const auto extent = static_cast<float>(gridSize) * 10.0f;
+
+    std::vector<std::array<glm::vec3, 8>> occluders;
+    for (std::uint32_t i = 0; i < buildings; ++i)
+    {
+        const glm::vec3 corner(static_cast<float>(i % gridSize) * 20.0f - extent + 3.0f, 0.0f, static_cast<float>(i / gridSize) * 20.0f - extent + 3.0f);
+        occluders.push_back(boxCorners(corner, corner + glm::vec3(8.0f + 6.0f * unit(random), 10.0f + 40.0f * unit(random), 8.0f + 6.0f * unit(random))));
+    }
+
+    std::vector<std::pair<glm::vec3, glm::vec3>> boxes;
+    for (std::uint32_t i = 0; i < objects; ++i)
+    {
+        const glm::vec3 centre((unit(random) * 2.0f - 1.0f) * extent, unit(random) * 3.0f, (unit(random) * 2.0f - 1.0f) * extent);
+        boxes.emplace_back(centre - glm::vec3(0.5f), centre + glm::vec3(0.5f));
+    }
+
+    const auto projection = glm::perspective(glm::pi<float>() / 3.0f, 2.0f, 0.5f, extent * 2.0f);
+    const auto view = glm::lookAt(glm::vec3(-extent + 1.0f, 2.0f, -extent + 1.0f), glm::vec3(0.0f, 2.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    const auto viewProjection = projection * view;
+
+    ThreadPool pool;
+    pool.init(threads);
+
+    OcclusionBuffer serial, pooled;
+    serial.init();
+    pooled.init();
+
+    std::printf("%u buildings, %u objects, %ux%u buffer, %d iterations, %u pool threads\n", buildings, objects, serial.width(), serial.height(), iterations,
+                pool.threadCount());
+    std::printf("%-10s %12s %14s %12s\n", "rasterise", "queue ms", "rasterise ms", "triangles");
+
+    auto run = [&](const char* name, OcclusionBuffer& buffer, ThreadPool* threadPool) {
+        double queueMs = 0.0, rasteriseMs = 0.0;
+        for (int iteration = 0; iteration <= iterations; ++iteration)
+        {
+            BenchTimer timer;
+            buffer.clear();
+            for (const auto& corners : occluders)
+                buffer.addOccluder(corners.data(), corners.size(), sizeof(glm::vec3), 0, BoxIndices, std::size(BoxIndices), viewProjection);
+            const auto queued = timer.elapsedMs();
+
+            timer = {};
+            buffer.rasterise(threadPool);
+            // The first pass is a warm up
+            if (iteration > 0)
+            {
+                queueMs += queued;
+                rasteriseMs += timer.elapsedMs();
+            }
+        }
+        std::printf("%-10s %12.3f %14.3f %12u\n", name, queueMs / iterations, rasteriseMs / iterations, buffer.triangleCount());
+    };
+
+    run("serial", serial, nullptr);
+    run("pool", pooled, &pool);
+
+    bool matches = true;
+    for (std::uint32_t level = 0; level < serial.levelCount(); ++level)
+        matches = matches && serial.depth(level) == pooled.depth(level);
+    if (!matches)
+        std::printf("Serial and pooled depth differ!\n");
+
+    // An empty buffer only rejects what's off screen, the difference is what the occluders hide
+    OcclusionBuffer empty;
+    empty.init();
+    empty.rasterise();
+    std::uint32_t onScreen = 0;
+    for (const auto& [min, max] : boxes)
+        onScreen += empty.isVisible(min, max, viewProjection);
+
+    std::uint32_t visible = 0;
+    const BenchTimer timer;
+    for (const auto& [min, max] : boxes)
+        visible += serial.isVisible(min, max, viewProjection);
+    const auto queryMs = timer.elapsedMs();
+
+    std::printf("\nisVisible: %u of %u on screen, %u visible (%.1f%% occluded), %.1f ns/query, %.1f Mqueries/s\n", onScreen, objects, visible,
+                onScreen > 0 ? 100.0 * (onScreen - visible) / onScreen : 0.0, queryMs * 1e6 / objects, objects / (queryMs * 1000.0));
+
+    return matches ? 0 : 1;
+}
@@ -0,0 +1,228 @@
+#include "bench.hpp"
+#include "render_queue.hpp"
+
+#include <glad/glad.h>
+#include <glm/ext/vector_float3.hpp>
+#include <glm/ext/vector_float4.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+// Render queue: N random draws over 16 programs, 256 meshes and 64 materials, 20% translucent, split over 2 passes.
+// First the key sort alone, radixSort against std::sort on the same shuffled keys (the radix order must match a
+// stable sort). Then whole frames: add + sort + execute through the queue, against the same draws submitted in their
+// original order with the same bind-on-change logic. Materials set a per-program uniform, so they are rebound after
+// every program change on both paths.
+//
+//   render_queue_bench [draws = 100000] [frames = 10]
+
+struct PositionVertex
+{
+    glm::vec3 pos = {};
+};
+
+VERTEX_LAYOUT(PositionVertex, VERTEX_ATTRIB(0, pos));
+
+constexpr std::uint32_t ShaderCount = 16, MeshCount = 256, MaterialCount = 64, PassCount = 2;
+
+constexpr const char* VertexSource = R"(#version 450 core
+layout(location = 0) in vec3 position;
+void main() { gl_Position = vec4(position, 1.0); }
+)";
+
+constexpr PositionVertex TriangleVertices[] = { { { 0.0f, 0.0f, 0.5f } }, { { 0.01f, 0.0f, 0.5f } }, { { 0.0f, 0.01f, 0.5f } } };
+constexpr std::uint32_t TriangleIndices[] = { 0, 1, 2 };
+
+struct Draw
+{
+    std::uint32_t shader = 0, mesh = 0;
+    std::uint16_t material = 0;
+    std::uint8_t pass = 0;
+    Translucency translucency = Translucency::Opaque;
+    float depth = 0.0f;
+};
+
+int main(int argc, char** argv)
+{
+    const auto drawCount = static_cast<std::uint32_t>(benchArgument(argc, argv, 1, 100000));
+    const auto frames = static_cast<int>(benchArgument(argc, argv, 2, 10));
+
+    if (!createBenchContext())
+        return 1;
+    bindBenchFramebuffer();
+    GLState::setEnabled(GLCap::DepthTest, true);
+
+    // Every program has its material colour at uniform location 0
+    std::vector<Shader> shaders(ShaderCount);
+    for (std::uint32_t i = 0; i < ShaderCount; ++i)
+    {
+        const auto fragmentSource = "#version 450 core\nlayout(location = 0) uniform vec4 tint;\nout vec4 colour;\nvoid main() { colour = tint * "
+                                    + std::to_string(static_cast<float>(i + 1) / ShaderCount) + "; }\n";
+        shaders[i].init(VertexSource, fragmentSource.c_str());
+    }
+
+    std::vector<Mesh<std::uint32_t>> meshes(MeshCount);
+    for (auto& mesh : meshes)
+    {
+        mesh.setImmutableVertices(TriangleVertices, sizeof(TriangleVertices));
+        mesh.setImmutableIndices(TriangleIndices, std::size(TriangleIndices));
+        mesh.apply<PositionVertex>(GL_TRIANGLES);
+    }
+
+    std::array<glm::vec4, MaterialCount> materialColours;
+    for (std::uint32_t i = 0; i < MaterialCount; ++i)
+        materialColours[i] = glm::vec4(static_cast<float>(i) / MaterialCount, 0.5f, 1.0f, 0.5f);
+    auto bindMaterial = [&](const std::uint16_t material) {
+        glProgramUniform4fv(GLState::snapshot().program, 0, 1, &materialColours[material].x);
+    };
+
+    std::mt19937 random(1);
+    std::vector<Draw> draws(drawCount);
+    for (auto& draw : draws)
+    {
+        draw.shader = random() % ShaderCount;
+        draw.mesh = random() % MeshCount;
+        draw.material = static_cast<std::uint16_t>(random() % MaterialCount);
+        draw.pass = static_cast<std::uint8_t>(random() % PassCount);
+        draw.translucency = random() % 5 == 0 ? Translucency::Translucent : Translucency::Opaque;
+        draw.depth = std::uniform_real_distribution<float>(0.0f, 1.0f)(random);
+    }
+
+    auto key = [&](const Draw& draw) {
+        return makeRenderKey(draw.pass, 0, draw.translucency, shaders[draw.shader].id(), draw.material, meshes[draw.mesh].id(), draw.depth);
+    };
+
+    // Sorting alone
+    std::vector<RenderSortEntry> entries(drawCount);
+    for (std::uint32_t i = 0; i < drawCount; ++i)
+        entries[i] = { key(draws[i]), i };
+
+    auto reference = entries;
+    std::stable_sort(reference.begin(), reference.end(), [](const RenderSortEntry& lhs, const RenderSortEntry& rhs) { return lhs.key < rhs.key; });
+
+    std::vector<RenderSortEntry> scratch;
+    auto radixSorted = entries;
+    radixSort(radixSorted, scratch);
+    const auto sortMatches = std::equal(radixSorted.begin(), radixSorted.end(), reference.begin(), [](const RenderSortEntry& lhs, const RenderSortEntry& rhs) {
+        return lhs.key == rhs.key && lhs.index == rhs.index;
+    });
+
+    constexpr int SortRepeats = 20;
+    double radixMs = 0.0, stdMs = 0.0;
+    for (int repeat = 0; repeat < SortRepeats; ++repeat)
+    {
+        std::shuffle(entries.begin(), entries.end(), random);
+        auto copy = entries;
+
+        const BenchTimer radixTimer;
+        radixSort(entries, scratch);
+        radixMs += radixTimer.elapsedMs();
+
+        const BenchTimer stdTimer;
+        std::sort(copy.begin(), copy.end(), [](const RenderSortEntry& lhs, const RenderSortEntry& rhs) { return lhs.key < rhs.key; });
+        stdMs += stdTimer.elapsedMs();
+    }
+
+    std::printf("%u draws, %u programs, %u meshes, %u materials, %u passes, %d frames\n", drawCount, ShaderCount, MeshCount, MaterialCount, PassCount, frames);
+    std::printf("sort: radix %.3f ms, std::sort %.3f ms, radix order %s stable sort\n\n", radixMs / SortRepeats, stdMs / SortRepeats,
+                sortMatches ? "matches" : "DIFFERS FROM");
+
+    // Whole frames
+    RenderQueue<std::uint32_t> queue;
+    queue.reserve(drawCount);
+    auto submitSorted = [&] {
+        queue.clear();
+        for (const auto& draw : draws)
+            queue.add(draw.pass, 0, draw.translucency, shaders[draw.shader], draw.material, meshes[draw.mesh], draw.depth);
+        queue.sort();
+        for (std::uint8_t pass = 0; pass < PassCount; ++pass)
+            queue.execute(pass, bindMaterial);
+        return queue.stats();
+    };
+
+    // Submission order, binding only what changes and following the same blending and material rules as the queue
+    auto submitUnsorted = [&] {
+        RenderQueueStats stats;
+        const Shader* shader = nullptr;
+        const Mesh<std::uint32_t>* mesh = nullptr;
+        std::uint32_t material = ~0u;
+        for (const auto& draw : draws)
+        {
+            const bool translucent = draw.translucency == Translucency::Translucent;
+            GLState::setEnabled(GLCap::Blend, translucent);
+            GLState::setDepthMask(translucent ? GL_FALSE : GL_TRUE);
+            if (translucent)
+                GLState::setBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+            if (&shaders[draw.shader] != shader)
+            {
+                shader = &shaders[draw.shader];
+                shader->bind();
+                material = ~0u;
+                ++stats.programChanges;
+            }
+            if (draw.material != material)
+            {
+                material = draw.material;
+                bindMaterial(draw.material);
+                ++stats.materialChanges;
+            }
+            if (&meshes[draw.mesh] != mesh)
+            {
+                mesh = &meshes[draw.mesh];
+                mesh->bind();
+                ++stats.meshChanges;
+            }
+            mesh->draw();
+            ++stats.draws;
+        }
+        GLState::setEnabled(GLCap::Blend, false);
+        GLState::setDepthMask(GL_TRUE);
+        return stats;
+    };
+
+    std::printf("%-10s %12s %12s %10s %10s %10s %12s %12s\n", "path", "submit ms/f", "total ms/f", "programs", "materials", "meshes", "GL issued",
+                "GL skipped");
+    auto run = [&](const char* name, auto&& submit) {
+        submit(); // Warm up
+        glFinish();
+        GLState::endFrame();
+
+        RenderQueueStats stats;
+        GLStateStats state;
+        double submitMs = 0.0;
+        const BenchTimer timer;
+        for (int frame = 0; frame < frames; ++frame)
+        {
+            const BenchTimer submitTimer;
+            stats = submit();
+            submitMs += submitTimer.elapsedMs();
+            GLState::endFrame();
+            state = GLState::stats();
+        }
+        glFinish();
+        const auto totalMs = timer.elapsedMs();
+
+        std::printf("%-10s %12.3f %12.3f %10u %10u %10u %12llu %12llu\n", name, submitMs / frames, totalMs / frames, stats.programChanges,
+                    stats.materialChanges, stats.meshChanges, static_cast<unsigned long long>(state.issued),
+                    static_cast<unsigned long long>(state.skipped));
+    };
+
+    run("sorted", submitSorted);
+
+    // execute() has to hand back opaque state, checked against GL itself rather than GLState's shadow copy
+    GLboolean depthMask = GL_FALSE;
+    glGetBooleanv(GL_DEPTH_WRITEMASK, &depthMask);
+    const auto stateRestored = glIsEnabled(GL_BLEND) == GL_FALSE && depthMask == GL_TRUE;
+    if (!stateRestored)
+        std::printf("execute() left blending on or depth writes off!\n");
+
+    run("unsorted", submitUnsorted);
+
+    return sortMatches && stateRestored && glGetError() == GL_NO_ERROR ? 0 : 1;
+}
@@ -0,0 +1,136 @@
+#include "bench.hpp"
+#include "shader.hpp"
+#include "stream_buffer.hpp"
+
+#include <glad/glad.h>
+#include <glm/ext/vector_float3.hpp>
+
+#include <cstdio>
+#include <utility>
+#include <vector>
+
+// Per-frame vertex uploads three ways: glNamedBufferData with the data (what Mesh did before streaming mode), orphaning
+// with a null glNamedBufferData followed by glNamedBufferSubData, and a persistently mapped StreamBuffer ring.
+// Every frame draws the uploaded vertices as points, so the GPU really does source the buffer that's being replaced.
+//
+//   stream_buffer_bench [vertexCount = 65536] [frames = 300]
+
+enum class UploadMode
+{
+    Reallocate,
+    Orphan,
+    Ring,
+};
+
+constexpr const char* VertexSource = R"(#version 450 core
+layout(location = 0) in vec3 position;
+void main() { gl_Position = vec4(position, 1.0); }
+)";
+
+constexpr const char* FragmentSource = R"(#version 450 core
+out vec4 colour;
+void main() { colour = vec4(1.0); }
+)";
+
+struct UploadResult
+{
+    double submitMs = 0.0; // CPU time for uploads + draws
+    double totalMs = 0.0;  // Including the final glFinish
+    std::uint64_t stalls = 0;
+};
+
+auto runUploads(const UploadMode mode, std::vector<glm::vec3>& vertices, const int frames) -> UploadResult
+{
+    const auto size = vertices.size() * sizeof(glm::vec3);
+    const auto stride = static_cast<GLsizei>(sizeof(glm::vec3));
+
+    GLuint vao = 0, vbo = 0;
+    glCreateVertexArrays(1, &vao);
+    glEnableVertexArrayAttrib(vao, 0);
+    glVertexArrayAttribFormat(vao, 0, 3, GL_FLOAT, GL_FALSE, 0);
+    glVertexArrayAttribBinding(vao, 0, 0);
+    glCreateBuffers(1, &vbo);
+
+    StreamBuffer ring;
+    if (mode == UploadMode::Ring)
+        ring.init(size);
+
+    GLState::bindVertexArray(vao);
+    glFinish();
+
+    const BenchTimer timer;
+    for (int frame = 0; frame < frames; ++frame)
+    {
+        vertices[frame % vertices.size()].z = static_cast<float>(frame) * 1e-6f;
+
+        switch (mode)
+        {
+        case UploadMode::Reallocate:
+            glNamedBufferData(vbo, static_cast<GLsizeiptr>(size), vertices.data(), GL_STATIC_DRAW);
+            glVertexArrayVertexBuffer(vao, 0, vbo, 0, stride);
+            break;
+        case UploadMode::Orphan:
+            glNamedBufferData(vbo, static_cast<GLsizeiptr>(size), nullptr, GL_STREAM_DRAW);
+            glNamedBufferSubData(vbo, 0, static_cast<GLsizeiptr>(size), vertices.data());
+            glVertexArrayVertexBuffer(vao, 0, vbo, 0, stride);
+            break;
+        case UploadMode::Ring:
+        {
+            ring.advance();
+            const auto offset = ring.write(vertices.data(), size);
+            glVertexArrayVertexBuffer(vao, 0, ring.buffer(), static_cast<GLintptr>(offset), stride);
+            break;
+        }
+        }
+
+        glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(vertices.size()));
+    }
+
+    UploadResult result;
+    result.submitMs = timer.elapsedMs();
+    glFinish();
+    result.totalMs = timer.elapsedMs();
+    result.stalls = ring.stallCount();
+
+    GLState::bindVertexArray(0);
+    glDeleteVertexArrays(1, &vao);
+    GLState::forgetVertexArray(vao);
+    glDeleteBuffers(1, &vbo);
+    GLState::forgetBuffer(vbo);
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    const auto vertexCount = static_cast<std::size_t>(benchArgument(argc, argv, 1, 65536));
+    const auto frames = static_cast<int>(benchArgument(argc, argv, 2, 300));
+
+    if (!createBenchContext())
+        return 1;
+    bindBenchFramebuffer();
+
+    Shader shader;
+    shader.init(VertexSource, FragmentSource);
+    shader.bind();
+
+    std::vector<glm::vec3> vertices(vertexCount);
+    for (std::size_t i = 0; i < vertexCount; ++i)
+        vertices[i] = { static_cast<float>(i % 256) / 128.0f - 1.0f, static_cast<float>(i / 256 % 256) / 128.0f - 1.0f, 0.0f };
+
+    std::printf("%zu vertices (%.1f KiB) per frame, %d frames\n", vertexCount, vertexCount * sizeof(glm::vec3) / 1024.0, frames);
+    std::printf("%-12s %14s %14s %8s\n", "mode", "submit ms/f", "total ms/f", "stalls");
+
+    const std::pair<UploadMode, const char*> modes[] = {
+        { UploadMode::Reallocate, "reallocate" },
+        { UploadMode::Orphan, "orphan" },
+        { UploadMode::Ring, "ring" },
+    };
+    for (const auto& [mode, name] : modes)
+    {
+        runUploads(mode, vertices, 10); // Warm up
+        const auto result = runUploads(mode, vertices, frames);
+        std::printf("%-12s %14.3f %14.3f %8llu\n", name, result.submitMs / frames, result.totalMs / frames, static_cast<unsigned long long>(result.stalls));
+    }
+
+    return glGetError() == GL_NO_ERROR ? 0 : 1;
+}
@@ -0,0 +1,167 @@
+#include "bench.hpp"
+#include "mesh.hpp"
+#include "shader.hpp"
+
+#include <glad/glad.h>
+#include <glm/ext/matrix_float4x4.hpp>
+#include <glm/ext/vector_float3.hpp>
+#include <glm/ext/vector_float4.hpp>
+
+#include <cstdint>
+#include <cstdio>
+
+// Uniform-heavy frames: every draw sets eight uniforms (two matrices, vectors, scalars) before drawing a quad. Compares
+// a glGetUniformLocation string lookup per update, Shader's set by compile-time hashed name (table lookup, then DSA
+// update), and handles resolved once up front. ns/uniform is the whole submit time, draws included, per uniform set.
+//
+//   uniform_bench [draws = 2000] [frames = 50]
+
+struct PositionVertex
+{
+    glm::vec3 pos = {};
+};
+
+VERTEX_LAYOUT(PositionVertex, VERTEX_ATTRIB(0, pos));
+
+constexpr const char* VertexSource = R"(#version 450 core
+layout(location = 0) in vec3 position;
+uniform mat4 model;
+uniform mat4 viewProjection;
+uniform vec4 offset;
+uniform vec3 scale;
+uniform vec2 uvScale;
+uniform float time;
+uniform int mode;
+out vec2 uv;
+void main()
+{
+    uv = position.xy * uvScale + vec2(time, float(mode));
+    gl_Position = viewProjection * model * vec4(position * scale * 0.01, 1.0) + offset;
+}
+)";
+
+constexpr const char* FragmentSource = R"(#version 450 core
+uniform vec4 colour;
+in vec2 uv;
+out vec4 fragColour;
+void main() { fragColour = colour * vec4(uv, 1.0, 1.0); }
+)";
+
+constexpr PositionVertex QuadVertices[] = { { { -1, -1, 0 } }, { { 1, -1, 0 } }, { { 1, 1, 0 } }, { { -1, 1, 0 } } };
+constexpr std::uint32_t QuadIndices[] = { 0, 1, 2, 2, 3, 0 };
+
+int main(int argc, char** argv)
+{
+    const auto draws = static_cast<int>(benchArgument(argc, argv, 1, 2000));
+    const auto frames = static_cast<int>(benchArgument(argc, argv, 2, 50));
+
+    if (!createBenchContext())
+        return 1;
+    bindBenchFramebuffer();
+
+    Shader shader;
+    shader.init(VertexSource, FragmentSource);
+
+    Mesh<std::uint32_t> mesh;
+    mesh.setImmutableVertices(QuadVertices, sizeof(QuadVertices));
+    mesh.setImmutableIndices(QuadIndices, std::size(QuadIndices));
+    mesh.apply<PositionVertex>(GL_TRIANGLES);
+
+    const glm::mat4 viewProjection(1.0f);
+    auto model = [](const int draw) {
+        auto m = glm::mat4(1.0f);
+        m[3] = glm::vec4(static_cast<float>(draw % 100) / 50.0f - 1.0f, static_cast<float>(draw / 100 % 100) / 50.0f - 1.0f, 0.0f, 1.0f);
+        return m;
+    };
+
+    // What every setter did before the cache: a driver side string lookup, then a bound-program update
+    auto drawLookup = [&] {
+        const auto program = shader.id();
+        glUseProgram(program);
+        mesh.bind();
+        for (int draw = 0; draw < draws; ++draw)
+        {
+            const auto m = model(draw);
+            glUniformMatrix4fv(glGetUniformLocation(program, "model"), 1, GL_FALSE, &m[0][0]);
+            glUniformMatrix4fv(glGetUniformLocation(program, "viewProjection"), 1, GL_FALSE, &viewProjection[0][0]);
+            glUniform4f(glGetUniformLocation(program, "offset"), 0.0f, 0.0f, 0.0f, 0.0f);
+            glUniform3f(glGetUniformLocation(program, "scale"), 1.0f, 1.0f, 1.0f);
+            glUniform2f(glGetUniformLocation(program, "uvScale"), 1.0f, 1.0f);
+            glUniform1f(glGetUniformLocation(program, "time"), static_cast<float>(draw));
+            glUniform1i(glGetUniformLocation(program, "mode"), draw & 3);
+            glUniform4f(glGetUniformLocation(program, "colour"), 1.0f, 0.5f, 0.25f, 1.0f);
+            mesh.draw();
+        }
+    };
+
+    auto drawByName = [&] {
+        shader.bind();
+        mesh.bind();
+        for (int draw = 0; draw < draws; ++draw)
+        {
+            shader.setMat4("model", model(draw));
+            shader.setMat4("viewProjection", viewProjection);
+            shader.setFloat4("offset", glm::vec4(0.0f));
+            shader.setFloat3("scale", glm::vec3(1.0f));
+            shader.setFloat2("uvScale", glm::vec2(1.0f));
+            shader.setFloat("time", static_cast<float>(draw));
+            shader.setInt("mode", draw & 3);
+            shader.setFloat4("colour", glm::vec4(1.0f, 0.5f, 0.25f, 1.0f));
+            mesh.draw();
+        }
+    };
+
+    const auto modelUniform = shader.uniform<glm::mat4>("model");
+    const auto viewProjectionUniform = shader.uniform<glm::mat4>("viewProjection");
+    const auto offsetUniform = shader.uniform<glm::vec4>("offset");
+    const auto scaleUniform = shader.uniform<glm::vec3>("scale");
+    const auto uvScaleUniform = shader.uniform<glm::vec2>("uvScale");
+    const auto timeUniform = shader.uniform<float>("time");
+    const auto modeUniform = shader.uniform<int>("mode");
+    const auto colourUniform = shader.uniform<glm::vec4>("colour");
+    if (!modelUniform || !viewProjectionUniform || !offsetUniform || !scaleUniform || !uvScaleUniform || !timeUniform || !modeUniform || !colourUniform)
+    {
+        std::printf("A uniform was optimised out\n");
+        return 1;
+    }
+
+    auto drawHandles = [&] {
+        shader.bind();
+        mesh.bind();
+        for (int draw = 0; draw < draws; ++draw)
+        {
+            shader.set(modelUniform, model(draw));
+            shader.set(viewProjectionUniform, viewProjection);
+            shader.set(offsetUniform, glm::vec4(0.0f));
+            shader.set(scaleUniform, glm::vec3(1.0f));
+            shader.set(uvScaleUniform, glm::vec2(1.0f));
+            shader.set(timeUniform, static_cast<float>(draw));
+            shader.set(modeUniform, draw & 3);
+            shader.set(colourUniform, glm::vec4(1.0f, 0.5f, 0.25f, 1.0f));
+            mesh.draw();
+        }
+    };
+
+    std::printf("%d draws x 8 uniforms, %d frames\n", draws, frames);
+    std::printf("%-10s %14s %14s %16s\n", "path", "submit ms/f", "total ms/f", "ns/uniform");
+
+    auto run = [&](const char* name, auto&& draw) {
+        draw(); // Warm up
+        glFinish();
+
+        const BenchTimer timer;
+        for (int frame = 0; frame < frames; ++frame)
+            draw();
+        const auto submitMs = timer.elapsedMs();
+        glFinish();
+        const auto totalMs = timer.elapsedMs();
+
+        std::printf("%-10s %14.3f %14.3f %16.1f\n", name, submitMs / frames, totalMs / frames, submitMs * 1e6 / (static_cast<double>(frames) * draws * 8));
+    };
+
+    run("lookup", drawLookup);
+    run("by name", drawByName);
+    run("handles", drawHandles);
+
+    return glGetError() == GL_NO_ERROR ? 0 : 1;
+}
@@ -0,0 +1,730 @@
+#pragma once
+
+#include "frustum.hpp"
+
+#include <glm/common.hpp>
+#include <glm/ext/matrix_float4x4.hpp>
+#include <glm/ext/vector_float2.hpp>
+#include <glm/ext/vector_float3.hpp>
+#include <glm/ext/vector_float4.hpp>
+#include <glm/geometric.hpp>
+#include <glm/matrix.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+struct Aabb
+{
+    glm::vec3 min = {};
+    glm::vec3 max = {};
+
+    static auto merge(const Aabb& a, const Aabb& b) -> Aabb;
+
+    auto centre() const -> glm::vec3;
+    /* Half the surface area, the SAH only ever compares areas */
+    auto area() const -> float;
+    auto expanded(float margin) const -> Aabb;
+
+    bool contains(const Aabb& other) const;
+    bool overlaps(const Aabb& other) const;
+};
+
+struct Ray
+{
+    glm::vec3 origin = {};
+    glm::vec3 direction = { 0, 0, -1 };
+
+    /* World space ray through a window position, eg. Input::getCursorPos(). `viewport` is the window size in pixels. */
+    static auto fromScreen(const glm::vec2& cursorPos, const glm::vec2& viewport, const glm::mat4& viewProjection) -> Ray;
+
+    /* Entry distance into `box`, or a negative value if the ray misses it within `maxDistance` */
+    auto intersect(const Aabb& box, const glm::vec3& inverseDirection, float maxDistance) const -> float;
+};
+
+// Dynamic bounding volume hierarchy. Leaves store a "fat" AABB so small movements don't touch the tree. Leaves are
+// inserted down the cheapest SAH path and the tree is kept balanced with local rotations on the way back up.
+// rebuild() replaces the whole tree with a binned SAH top-down build, which gives a better tree for static geometry.
+class AabbTree
+{
+public:
+    using Proxy = std::int32_t;
+    static constexpr Proxy NullProxy = -1;
+
+    struct RaycastHit
+    {
+        Proxy proxy = NullProxy;
+        float distance = 0.0f;
+    };
+
+    void init(float margin = 0.1f);
+    void clear();
+
+    auto createProxy(const Aabb& aabb, std::uint32_t userData) -> Proxy;
+    void destroyProxy(Proxy proxy);
+    /* Returns true if the proxy had to be reinserted */
+    auto moveProxy(Proxy proxy, const Aabb& aabb) -> bool;
+
+    auto userData(Proxy proxy) const -> std::uint32_t;
+    auto fatAabb(Proxy proxy) const -> const Aabb&;
+
+    /* Rebuilds the tree from its current leaves with a top-down binned SAH build. Proxies stay valid. */
+    void rebuild();
+
+    /* `visit(Proxy)` for every leaf that may be inside the frustum */
+    template <typename F>
+    void queryFrustum(const Frustum& frustum, F&& visit) const;
+    /* `visit(Proxy)` for every leaf overlapping `aabb`. Return false to stop the query early. */
+    template <typename F>
+    void queryOverlap(const Aabb& aabb, F&& visit) const;
+    /* `hit(Proxy, maxDistance)` returns the exact hit distance for the leaf, or a negative value for a miss.
+       Leaves are visited roughly front to back and subtrees beyond the closest hit so far are skipped. */
+    template <typename F>
+    auto raycast(const Ray& ray, float maxDistance, F&& hit) const -> RaycastHit;
+    /* Closest leaf AABB along the ray */
+    auto raycast(const Ray& ray, float maxDistance = std::numeric_limits<float>::max()) const -> RaycastHit;
+
+    auto proxyCount() const -> std::uint32_t;
+    auto height() const -> std::int32_t;
+    /* Sum of internal node areas over the root area. Lower is a better tree. */
+    auto areaRatio() const -> float;
+
+private:
+    struct Node
+    {
+        Aabb aabb;
+        std::int32_t parent = NullProxy; // Next free node when on the free list
+        std::int32_t child1 = NullProxy, child2 = NullProxy;
+        std::int32_t height = 0; // -1 when free
+        std::uint32_t userData = 0;
+
+        bool isLeaf() const { return child1 == NullProxy; }
+    };
+
+    // Per query traversal stack, so concurrent const queries share nothing. The fixed part covers any reasonably
+    // balanced tree; a degenerate one spills into the heap rather than overflowing.
+    class TraversalStack
+    {
+    public:
+        void push(const std::int32_t node)
+        {
+            if (m_size < m_fixed.size())
+                m_fixed[m_size] = node;
+            else
+                m_overflow.push_back(node);
+            ++m_size;
+        }
+
+        auto pop() -> std::int32_t
+        {
+            if (--m_size < m_fixed.size())
+                return m_fixed[m_size];
+            const auto node = m_overflow.back();
+            m_overflow.pop_back();
+            return node;
+        }
+
+        bool empty() const { return m_size == 0; }
+
+    private:
+        std::array<std::int32_t, 64> m_fixed;
+        std::vector<std::int32_t> m_overflow;
+        std::size_t m_size = 0;
+    };
+
+    auto allocateNode() -> std::int32_t;
+    void freeNode(std::int32_t node);
+
+    void insertLeaf(std::int32_t leaf);
+    void removeLeaf(std::int32_t leaf);
+    void refit(std::int32_t node);
+    void rotate(std::int32_t node);
+    void refitAndRotateUp(std::int32_t node);
+
+    auto buildRange(std::int32_t* leaves, std::size_t count) -> std::int32_t;
+
+private:
+    std::vector<Node> m_nodes;
+    std::int32_t m_root = NullProxy;
+    std::int32_t m_freeList = NullProxy;
+    std::uint32_t m_proxyCount = 0;
+    float m_margin = 0.1f;
+};
+
+inline auto Aabb::merge(const Aabb& a, const Aabb& b) -> Aabb
+{
+    return { glm::min(a.min, b.min), glm::max(a.max, b.max) };
+}
+
+inline auto Aabb::centre() const -> glm::vec3
+{
+    return (min + max) * 0.5f;
+}
+
+inline auto Aabb::area() const -> float
+{
+    const auto d = max - min;
+    return d.x * d.y + d.y * d.z + d.z * d.x;
+}
+
+inline auto Aabb::expanded(const float margin) const -> Aabb
+{
+    return { min - margin, max + margin };
+}
+
+inline bool Aabb::contains(const Aabb& other) const
+{
+    return glm::all(glm::lessThanEqual(min, other.min)) && glm::all(glm::greaterThanEqual(max, other.max));
+}
+
+inline bool Aabb::overlaps(const Aabb& other) const
+{
+    return glm::all(glm::lessThanEqual(min, other.max)) && glm::all(glm::greaterThanEqual(max, other.min));
+}
+
+inline auto Ray::fromScreen(const glm::vec2& cursorPos, const glm::vec2& viewport, const glm::mat4& viewProjection) -> Ray
+{
+    // Window coordinates have y pointing down
+    const glm::vec2 ndc(cursorPos.x / viewport.x * 2.0f - 1.0f, 1.0f - cursorPos.y / viewport.y * 2.0f);
+
+    const auto inverse = glm::inverse(viewProjection);
+    auto nearPoint = inverse * glm::vec4(ndc, -1.0f, 1.0f);
+    auto farPoint = inverse * glm::vec4(ndc, 1.0f, 1.0f);
+    nearPoint /= nearPoint.w;
+    farPoint /= farPoint.w;
+
+    return { glm::vec3(nearPoint), glm::normalize(glm::vec3(farPoint - nearPoint)) };
+}
+
+inline auto Ray::intersect(const Aabb& box, const glm::vec3& inverseDirection, const float maxDistance) const -> float
+{
+    const auto t0 = (box.min - origin) * inverseDirection;
+    const auto t1 = (box.max - origin) * inverseDirection;
+    const auto tMin = glm::min(t0, t1);
+    const auto tMax = glm::max(t0, t1);
+
+    const auto entry = std::max(std::max(tMin.x, tMin.y), std::max(tMin.z, 0.0f));
+    const auto exit = std::min(std::min(tMax.x, tMax.y), std::min(tMax.z, maxDistance));
+    return entry <= exit ? entry : -1.0f;
+}
+
+inline void AabbTree::init(const float margin)
+{
+    m_margin = margin;
+    clear();
+}
+
+inline void AabbTree::clear()
+{
+    m_nodes.clear();
+    m_root = NullProxy;
+    m_freeList = NullProxy;
+    m_proxyCount = 0;
+}
+
+inline auto AabbTree::createProxy(const Aabb& aabb, const std::uint32_t userData) -> Proxy
+{
+    const auto leaf = allocateNode();
+    m_nodes[leaf].aabb = aabb.expanded(m_margin);
+    m_nodes[leaf].userData = userData;
+    insertLeaf(leaf);
+    ++m_proxyCount;
+    return leaf;
+}
+
+inline void AabbTree::destroyProxy(const Proxy proxy)
+{
+    removeLeaf(proxy);
+    freeNode(proxy);
+    --m_proxyCount;
+}
+
+inline auto AabbTree::moveProxy(const Proxy proxy, const Aabb& aabb) -> bool
+{
+    auto& node = m_nodes[proxy];
+    if (node.aabb.contains(aabb))
+        return false;
+
+    removeLeaf(proxy);
+    m_nodes[proxy].aabb = aabb.expanded(m_margin);
+    insertLeaf(proxy);
+    return true;
+}
+
+inline auto AabbTree::userData(const Proxy proxy) const -> std::uint32_t
+{
+    return m_nodes[proxy].userData;
+}
+
+inline auto AabbTree::fatAabb(const Proxy proxy) const -> const Aabb&
+{
+    return m_nodes[proxy].aabb;
+}
+
+inline void AabbTree::rebuild()
+{
+    std::vector<std::int32_t> leaves;
+    leaves.reserve(m_proxyCount);
+    for (std::int32_t i = 0; i < static_cast<std::int32_t>(m_nodes.size()); ++i)
+    {
+        auto& node = m_nodes[i];
+        if (node.height < 0)
+            continue;
+
+        if (node.isLeaf())
+            leaves.push_back(i);
+        else
+            freeNode(i);
+    }
+
+    m_root = leaves.empty() ? NullProxy : buildRange(leaves.data(), leaves.size());
+    if (m_root != NullProxy)
+        m_nodes[m_root].parent = NullProxy;
+}
+
+template <typename F>
+void AabbTree::queryFrustum(const Frustum& frustum, F&& visit) const
+{
+    if (m_root == NullProxy)
+        return;
+
+    TraversalStack stack;
+    stack.push(m_root);
+    while (!stack.empty())
+    {
+        const auto index = stack.pop();
+        const auto& node = m_nodes[index];
+
+        if (!frustum.intersectsAabb(node.aabb.min, node.aabb.max))
+            continue;
+
+        if (node.isLeaf())
+        {
+            visit(index);
+            continue;
+        }
+        stack.push(node.child1);
+        stack.push(node.child2);
+    }
+}
+
+template <typename F>
+void AabbTree::queryOverlap(const Aabb& aabb, F&& visit) const
+{
+    if (m_root == NullProxy)
+        return;
+
+    TraversalStack stack;
+    stack.push(m_root);
+    while (!stack.empty())
+    {
+        const auto index = stack.pop();
+        const auto& node = m_nodes[index];
+
+        if (!node.aabb.overlaps(aabb))
+            continue;
+
+        if (node.isLeaf())
+        {
+            if (!visit(index))
+                return;
+            continue;
+        }
+        stack.push(node.child1);
+        stack.push(node.child2);
+    }
+}
+
+template <typename F>
+auto AabbTree::raycast(const Ray& ray, const float maxDistance, F&& hit) const -> RaycastHit
+{
+    RaycastHit closest = { NullProxy, maxDistance };
+    if (m_root == NullProxy)
+        return closest;
+
+    const auto inverseDirection = 1.0f / ray.direction;
+
+    TraversalStack stack;
+    stack.push(m_root);
+    while (!stack.empty())
+    {
+        const auto index = stack.pop();
+        const auto& node = m_nodes[index];
+
+        if (ray.intersect(node.aabb, inverseDirection, closest.distance) < 0.0f)
+            continue;
+
+        if (node.isLeaf())
+        {
+            const auto distance = hit(index, closest.distance);
+            if (distance >= 0.0f && distance <= closest.distance)
+                closest = { index, distance };
+            continue;
+        }
+
+        // Push the nearer child last so it is visited first and tightens the bound sooner
+        const auto t1 = ray.intersect(m_nodes[node.child1].aabb, inverseDirection, closest.distance);
+        const auto t2 = ray.intersect(m_nodes[node.child2].aabb, inverseDirection, closest.distance);
+        const bool firstNearer = t1 >= 0.0f && (t2 < 0.0f || t1 <= t2);
+        if (t1 >= 0.0f && t2 >= 0.0f)
+        {
+            stack.push(firstNearer ? node.child2 : node.child1);
+            stack.push(firstNearer ? node.child1 : node.child2);
+        }
+        else if (t1 >= 0.0f || t2 >= 0.0f)
+        {
+            stack.push(firstNearer ? node.child1 : node.child2);
+        }
+    }
+
+    return closest;
+}
+
+inline auto AabbTree::raycast(const Ray& ray, const float maxDistance) const -> RaycastHit
+{
+    const auto inverseDirection = 1.0f / ray.direction;
+    return raycast(ray, maxDistance, [&](const Proxy proxy, const float max) { return ray.intersect(m_nodes[proxy].aabb, inverseDirection, max); });
+}
+
+inline auto AabbTree::proxyCount() const -> std::uint32_t
+{
+    return m_proxyCount;
+}
+
+inline auto AabbTree::height() const -> std::int32_t
+{
+    return m_root == NullProxy ? 0 : m_nodes[m_root].height;
+}
+
+inline auto AabbTree::areaRatio() const -> float
+{
+    if (m_root == NullProxy)
+        return 0.0f;
+
+    float total = 0.0f;
+    for (const auto& node : m_nodes)
+    {
+        if (node.height > 0)
+            total += node.aabb.area();
+    }
+    return total / m_nodes[m_root].aabb.area();
+}
+
+inline auto AabbTree::allocateNode() -> std::int32_t
+{
+    if (m_freeList == NullProxy)
+    {
+        m_nodes.emplace_back();
+        return static_cast<std::int32_t>(m_nodes.size() - 1);
+    }
+
+    const auto node = m_freeList;
+    m_freeList = m_nodes[node].parent;
+    m_nodes[node] = {};
+    return node;
+}
+
+inline void AabbTree::freeNode(const std::int32_t node)
+{
+    m_nodes[node].parent = m_freeList;
+    m_nodes[node].height = -1;
+    m_freeList = node;
+}
+
+inline void AabbTree::insertLeaf(const std::int32_t leaf)
+{
+    if (m_root == NullProxy)
+    {
+        m_root = leaf;
+        m_nodes[leaf].parent = NullProxy;
+        return;
+    }
+
+    // Walk down towards the sibling with the lowest SAH cost. Every ancestor grows by the same amount regardless of
+    // which way we go from here, so that "inheritance" cost is added to both children.
+    const auto leafAabb = m_nodes[leaf].aabb;
+    auto index = m_root;
+    while (!m_nodes[index].isLeaf())
+    {
+        const auto& node = m_nodes[index];
+        const auto area = node.aabb.area();
+        const auto combinedArea = Aabb::merge(node.aabb, leafAabb).area();
+
+        const auto cost = 2.0f * combinedArea;
+        const auto inheritance = 2.0f * (combinedArea - area);
+
+        auto childCost = [&](const std::int32_t child) {
+            const auto& childAabb = m_nodes[child].aabb;
+            const auto merged = Aabb::merge(childAabb, leafAabb).area();
+            return (m_nodes[child].isLeaf() ? merged : merged - childAabb.area()) + inheritance;
+        };
+        const auto cost1 = childCost(node.child1);
+        const auto cost2 = childCost(node.child2);
+
+        if (cost < cost1 && cost < cost2)
+            break;
+        index = cost1 < cost2 ? node.child1 : node.child2;
+    }
+
+    const auto sibling = index;
+    const auto oldParent = m_nodes[sibling].parent;
+    const auto newParent = allocateNode();
+    auto& parent = m_nodes[newParent];
+    parent.parent = oldParent;
+    parent.aabb = Aabb::merge(leafAabb, m_nodes[sibling].aabb);
+    parent.height = m_nodes[sibling].height + 1;
+    parent.child1 = sibling;
+    parent.child2 = leaf;
+    m_nodes[sibling].parent = newParent;
+    m_nodes[leaf].parent = newParent;
+
+    if (oldParent == NullProxy)
+        m_root = newParent;
+    else if (m_nodes[oldParent].child1 == sibling)
+        m_nodes[oldParent].child1 = newParent;
+    else
+        m_nodes[oldParent].child2 = newParent;
+
+    refitAndRotateUp(oldParent);
+}
+
+inline void AabbTree::removeLeaf(const std::int32_t leaf)
+{
+    if (leaf == m_root)
+    {
+        m_root = NullProxy;
+        return;
+    }
+
+    const auto parent = m_nodes[leaf].parent;
+    const auto grandParent = m_nodes[parent].parent;
+    const auto sibling = m_nodes[parent].child1 == leaf ? m_nodes[parent].child2 : m_nodes[parent].child1;
+
+    freeNode(parent);
+    m_nodes[sibling].parent = grandParent;
+    if (grandParent == NullProxy)
+    {
+        m_root = sibling;
+        return;
+    }
+
+    if (m_nodes[grandParent].child1 == parent)
+        m_nodes[grandParent].child1 = sibling;
+    else
+        m_nodes[grandParent].child2 = sibling;
+
+    refitAndRotateUp(grandParent);
+}
+
+inline void AabbTree::refit(const std::int32_t index)
+{
+    auto& node = m_nodes[index];
+    const auto& child1 = m_nodes[node.child1];
+    const auto& child2 = m_nodes[node.child2];
+    node.aabb = Aabb::merge(child1.aabb, child2.aabb);
+    node.height = 1 + std::max(child1.height, child2.height);
+}
+
+// Tries swapping a child with one of its sibling's children (the four rotations from Kopta et al. 2012) and keeps
+// whichever shrinks the area of the node being replaced the most. Rotations never change `index`'s own bounds.
+inline void AabbTree::rotate(const std::int32_t index)
+{
+    const auto b = m_nodes[index].child1;
+    const auto c = m_nodes[index].child2;
+    if (m_nodes[index].height < 2)
+        return;
+
+    enum class Rotation
+    {
+        None,
+        BF,
+        BG,
+        CD,
+        CE,
+    };
+    auto best = Rotation::None;
+    float bestDelta = 0.0f;
+
+    if (!m_nodes[c].isLeaf())
+    {
+        const auto f = m_nodes[c].child1;
+        const auto g = m_nodes[c].child2;
+        const auto area = m_nodes[c].aabb.area();
+        const auto bf = Aabb::merge(m_nodes[b].aabb, m_nodes[g].aabb).area() - area; // B swaps with F
+        const auto bg = Aabb::merge(m_nodes[b].aabb, m_nodes[f].aabb).area() - area; // B swaps with G
+        if (bf < bestDelta)
+        {
+            best = Rotation::BF;
+            bestDelta = bf;
+        }
+        if (bg < bestDelta)
+        {
+            best = Rotation::BG;
+            bestDelta = bg;
+        }
+    }
+
+    if (!m_nodes[b].isLeaf())
+    {
+        const auto d = m_nodes[b].child1;
+        const auto e = m_nodes[b].child2;
+        const auto area = m_nodes[b].aabb.area();
+        const auto cd = Aabb::merge(m_nodes[c].aabb, m_nodes[e].aabb).area() - area; // C swaps with D
+        const auto ce = Aabb::merge(m_nodes[c].aabb, m_nodes[d].aabb).area() - area; // C swaps with E
+        if (cd < bestDelta)
+        {
+            best = Rotation::CD;
+            bestDelta = cd;
+        }
+        if (ce < bestDelta)
+        {
+            best = Rotation::CE;
+            bestDelta = ce;
+        }
+    }
+
+    // Swap `child` of `index` with `grandChild`, a child of `other` (index's other child)
+    auto swap = [&](const std::int32_t child, const std::int32_t other, const std::int32_t grandChild) {
+        auto& parent = m_nodes[index];
+        (parent.child1 == child ? parent.child1 : parent.child2) = grandChild;
+        auto& otherNode = m_nodes[other];
+        (otherNode.child1 == grandChild ? otherNode.child1 : otherNode.child2) = child;
+        m_nodes[grandChild].parent = index;
+        m_nodes[child].parent = other;
+        refit(other);
+        refit(index);
+    };
+
+    switch (best)
+    {
+    case Rotation::None:
+        break;
+    case Rotation::BF:
+        swap(b, c, m_nodes[c].child1);
+        break;
+    case Rotation::BG:
+        swap(b, c, m_nodes[c].child2);
+        break;
+    case Rotation::CD:
+        swap(c, b, m_nodes[b].child1);
+        break;
+    case Rotation::CE:
+        swap(c, b, m_nodes[b].child2);
+        break;
+    }
+}
+
+inline void AabbTree::refitAndRotateUp(std::int32_t index)
+{
+    while (index != NullProxy)
+    {
+        refit(index);
+        rotate(index);
+        index = m_nodes[index].parent;
+    }
+}
+
+inline auto AabbTree::buildRange(std::int32_t* leaves, const std::size_t count) -> std::int32_t
+{
+    if (count == 1)
+        return leaves[0];
+
+    constexpr std::size_t BinCount = 16;
+
+    Aabb centroidBounds = { m_nodes[leaves[0]].aabb.centre(), m_nodes[leaves[0]].aabb.centre() };
+    for (std::size_t i = 1; i < count; ++i)
+    {
+        const auto c = m_nodes[leaves[i]].aabb.centre();
+        centroidBounds = Aabb::merge(centroidBounds, { c, c });
+    }
+
+    const auto extent = centroidBounds.max - centroidBounds.min;
+    const int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+
+    std::size_t split = count / 2;
+    if (extent[axis] > 0.0f)
+    {
+        struct Bin
+        {
+            Aabb aabb;
+            std::size_t count = 0;
+        };
+        std::array<Bin, BinCount> bins;
+
+        const auto scale = BinCount / extent[axis];
+        auto binOf = [&](const std::int32_t leaf) {
+            const auto offset = m_nodes[leaf].aabb.centre()[axis] - centroidBounds.min[axis];
+            return std::min(BinCount - 1, static_cast<std::size_t>(offset * scale));
+        };
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            auto& bin = bins[binOf(leaves[i])];
+            bin.aabb = bin.count == 0 ? m_nodes[leaves[i]].aabb : Aabb::merge(bin.aabb, m_nodes[leaves[i]].aabb);
+            ++bin.count;
+        }
+
+        // Sweep from the right to get the cost of everything right of each plane, then from the left to pick the cheapest
+        std::array<float, BinCount> rightCost = {};
+        Aabb right;
+        std::size_t rightCount = 0;
+        for (std::size_t i = BinCount - 1; i > 0; --i)
+        {
+            if (bins[i].count > 0)
+            {
+                right = rightCount == 0 ? bins[i].aabb : Aabb::merge(right, bins[i].aabb);
+                rightCount += bins[i].count;
+            }
+            rightCost[i] = rightCount == 0 ? 0.0f : right.area() * rightCount;
+        }
+
+        Aabb left;
+        std::size_t leftCount = 0;
+        auto bestCost = std::numeric_limits<float>::max();
+        std::size_t bestPlane = 0;
+        for (std::size_t i = 0; i < BinCount - 1; ++i)
+        {
+            if (bins[i].count > 0)
+            {
+                left = leftCount == 0 ? bins[i].aabb : Aabb::merge(left, bins[i].aabb);
+                leftCount += bins[i].count;
+            }
+            const auto cost = (leftCount == 0 ? 0.0f : left.area() * leftCount) + rightCost[i + 1];
+            if (leftCount > 0 && leftCount < count && cost < bestCost)
+            {
+                bestCost = cost;
+                bestPlane = i;
+            }
+        }
+
+        if (bestCost < std::numeric_limits<float>::max())
+        {
+            auto* middle = std::partition(leaves, leaves + count, [&](const std::int32_t leaf) { return binOf(leaf) <= bestPlane; });
+            split = static_cast<std::size_t>(middle - leaves);
+        }
+    }
+
+    // Degenerate bins (eg. everything in one spot) fall back to a median split
+    if (split == 0 || split == count || extent[axis] <= 0.0f)
+    {
+        split = count / 2;
+        std::nth_element(leaves, leaves + split, leaves + count, [&](const std::int32_t lhs, const std::int32_t rhs) {
+            return m_nodes[lhs].aabb.centre()[axis] < m_nodes[rhs].aabb.centre()[axis];
+        });
+    }
+
+    const auto child1 = buildRange(leaves, split);
+    const auto child2 = buildRange(leaves + split, count - split);
+
+    const auto index = allocateNode();
+    auto& node = m_nodes[index];
+    node.child1 = child1;
+    node.child2 = child2;
+    m_nodes[child1].parent = index;
+    m_nodes[child2].parent = index;
+    refit(index);
+    return index;
+}
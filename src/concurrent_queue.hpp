@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <optional>
+
+// Bounded lock-free multi-producer/multi-consumer queue (Vyukov). Capacity must be a power of two.
+template <typename T>
+class ConcurrentQueue
+{
+public:
+    explicit ConcurrentQueue(std::size_t capacity = 256);
+
+    bool tryPush(T&& value);
+    auto tryPop() -> std::optional<T>;
+
+private:
+    struct Cell
+    {
+        std::atomic<std::size_t> sequence;
+        T value;
+    };
+
+    static constexpr std::size_t CacheLine = 64;
+
+    std::unique_ptr<Cell[]> m_cells;
+    std::size_t m_mask;
+
+    alignas(CacheLine) std::atomic<std::size_t> m_enqueuePos = 0;
+    alignas(CacheLine) std::atomic<std::size_t> m_dequeuePos = 0;
+};
+
+template <typename T>
+ConcurrentQueue<T>::ConcurrentQueue(const std::size_t capacity) : m_cells(new Cell[capacity]), m_mask(capacity - 1)
+{
+    assert(capacity >= 2 && (capacity & (capacity - 1)) == 0 && "ConcurrentQueue capacity must be a power of two!");
+
+    for (std::size_t i = 0; i < capacity; ++i)
+        m_cells[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+template <typename T>
+bool ConcurrentQueue<T>::tryPush(T&& value)
+{
+    Cell* cell;
+    auto pos = m_enqueuePos.load(std::memory_order_relaxed);
+    while (true)
+    {
+        cell = &m_cells[pos & m_mask];
+        const auto sequence = cell->sequence.load(std::memory_order_acquire);
+        const auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+
+        if (diff == 0)
+        {
+            if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (diff < 0)
+        {
+            return false; // Full
+        }
+        else
+        {
+            pos = m_enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    cell->value = std::move(value);
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+template <typename T>
+auto ConcurrentQueue<T>::tryPop() -> std::optional<T>
+{
+    Cell* cell;
+    auto pos = m_dequeuePos.load(std::memory_order_relaxed);
+    while (true)
+    {
+        cell = &m_cells[pos & m_mask];
+        const auto sequence = cell->sequence.load(std::memory_order_acquire);
+        const auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos + 1);
+
+        if (diff == 0)
+        {
+            if (m_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (diff < 0)
+        {
+            return std::nullopt; // Empty
+        }
+        else
+        {
+            pos = m_dequeuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    std::optional<T> value(std::move(cell->value));
+    cell->sequence.store(pos + m_mask + 1, std::memory_order_release);
+    return value;
+}
@@ -0,0 +1,295 @@
+#pragma once
+
+#include "frustum.hpp"
+#include "simd.hpp"
+#include "thread_pool.hpp"
+
+#include <glm/common.hpp>
+#include <glm/ext/vector_float3.hpp>
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <latch>
+#include <vector>
+
+// Object bounds stored as structure-of-arrays for the batched culling kernels. Each object has an AABB (as centre and
+// half extents) and a bounding sphere around the same centre, and is tested against whichever is tighter per plane.
+// Streams are padded to a multiple of CullingSet::Width so the kernels never need a scalar tail.
+class CullingSet
+{
+public:
+    static constexpr std::uint32_t Width = 8;
+
+    /* The sphere defaults to the one enclosing the box */
+    auto add(const glm::vec3& min, const glm::vec3& max) -> std::uint32_t;
+    auto add(const glm::vec3& min, const glm::vec3& max, float radius) -> std::uint32_t;
+    void update(std::uint32_t index, const glm::vec3& min, const glm::vec3& max);
+    void update(std::uint32_t index, const glm::vec3& min, const glm::vec3& max, float radius);
+
+    void reserve(std::uint32_t count);
+    void clear();
+
+    auto size() const -> std::uint32_t;
+
+public:
+    std::vector<float> centreX, centreY, centreZ;
+    std::vector<float> extentX, extentY, extentZ;
+    std::vector<float> radius;
+
+private:
+    std::uint32_t m_size = 0;
+};
+
+inline auto CullingSet::add(const glm::vec3& min, const glm::vec3& max) -> std::uint32_t
+{
+    return add(min, max, glm::length(max - min) * 0.5f);
+}
+
+inline auto CullingSet::add(const glm::vec3& min, const glm::vec3& max, const float sphereRadius) -> std::uint32_t
+{
+    const auto index = m_size++;
+    if (index % Width == 0)
+    {
+        for (auto* stream : { &centreX, &centreY, &centreZ, &extentX, &extentY, &extentZ, &radius })
+            stream->resize(stream->size() + Width, 0.0f);
+    }
+
+    update(index, min, max, sphereRadius);
+    return index;
+}
+
+inline void CullingSet::update(const std::uint32_t index, const glm::vec3& min, const glm::vec3& max)
+{
+    update(index, min, max, glm::length(max - min) * 0.5f);
+}
+
+inline void CullingSet::update(const std::uint32_t index, const glm::vec3& min, const glm::vec3& max, const float sphereRadius)
+{
+    const auto centre = (min + max) * 0.5f;
+    const auto extent = (max - min) * 0.5f;
+    centreX[index] = centre.x;
+    centreY[index] = centre.y;
+    centreZ[index] = centre.z;
+    extentX[index] = extent.x;
+    extentY[index] = extent.y;
+    extentZ[index] = extent.z;
+    radius[index] = sphereRadius;
+}
+
+inline void CullingSet::reserve(const std::uint32_t count)
+{
+    const auto padded = (count + Width - 1) / Width * Width;
+    for (auto* stream : { &centreX, &centreY, &centreZ, &extentX, &extentY, &extentZ, &radius })
+        stream->reserve(padded);
+}
+
+inline void CullingSet::clear()
+{
+    for (auto* stream : { &centreX, &centreY, &centreZ, &extentX, &extentY, &extentZ, &radius })
+        stream->clear();
+    m_size = 0;
+}
+
+inline auto CullingSet::size() const -> std::uint32_t
+{
+    return m_size;
+}
+
+/* Per plane: the AABB's projected radius is |n.x| * e.x + |n.y| * e.y + |n.z| * e.z. The kernels use the smaller of that and the sphere. */
+inline auto cullAbsNormals(const Frustum& frustum) -> std::array<glm::vec4, 6>
+{
+    std::array<glm::vec4, 6> absNormals;
+    for (std::size_t p = 0; p < frustum.planes.size(); ++p)
+        absNormals[p] = glm::abs(frustum.planes[p]);
+    return absNormals;
+}
+
+/* Appends the set lanes of `mask` as indices from `base`, ignoring padding lanes past `end` */
+inline void cullEmit(const std::uint32_t base, std::uint32_t mask, const std::uint32_t end, std::uint32_t* visible, std::uint32_t& visibleCount)
+{
+    if (end - base < 32)
+        mask &= (1u << (end - base)) - 1;
+    while (mask != 0)
+    {
+        visible[visibleCount++] = base + static_cast<std::uint32_t>(std::countr_zero(mask));
+        mask &= mask - 1;
+    }
+}
+
+/* The individual kernels behind cullFrustum, all with its interface and identical output. Exposed for benchmarking. */
+inline auto cullFrustumScalar(const CullingSet& set, const Frustum& frustum, const std::uint32_t first, const std::uint32_t count, std::uint32_t* visible)
+    -> std::uint32_t
+{
+    const auto absNormals = cullAbsNormals(frustum);
+    std::uint32_t visibleCount = 0;
+    for (auto i = first; i < first + count; ++i)
+    {
+        const glm::vec3 centre(set.centreX[i], set.centreY[i], set.centreZ[i]);
+        const glm::vec3 extent(set.extentX[i], set.extentY[i], set.extentZ[i]);
+
+        bool inside = true;
+        for (std::size_t p = 0; p < frustum.planes.size() && inside; ++p)
+        {
+            const auto& plane = frustum.planes[p];
+            const auto boxRadius = glm::dot(glm::vec3(absNormals[p]), extent);
+            inside = glm::dot(glm::vec3(plane), centre) + plane.w + std::min(set.radius[i], boxRadius) >= 0.0f;
+        }
+
+        if (inside)
+            visible[visibleCount++] = i;
+    }
+    return visibleCount;
+}
+
+#if defined(SIMD_SSE2)
+inline auto cullFrustumSse2(const CullingSet& set, const Frustum& frustum, const std::uint32_t first, const std::uint32_t count, std::uint32_t* visible)
+    -> std::uint32_t
+{
+    const auto absNormals = cullAbsNormals(frustum);
+    const auto end = first + count;
+    std::uint32_t visibleCount = 0;
+    for (auto i = first; i < end; i += 4)
+    {
+        const auto cx = _mm_loadu_ps(&set.centreX[i]);
+        const auto cy = _mm_loadu_ps(&set.centreY[i]);
+        const auto cz = _mm_loadu_ps(&set.centreZ[i]);
+        const auto ex = _mm_loadu_ps(&set.extentX[i]);
+        const auto ey = _mm_loadu_ps(&set.extentY[i]);
+        const auto ez = _mm_loadu_ps(&set.extentZ[i]);
+        const auto r = _mm_loadu_ps(&set.radius[i]);
+
+        auto inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (std::size_t p = 0; p < frustum.planes.size(); ++p)
+        {
+            const auto& plane = frustum.planes[p];
+            const auto& absNormal = absNormals[p];
+
+            auto d = _mm_add_ps(_mm_mul_ps(cx, _mm_set1_ps(plane.x)), _mm_mul_ps(cy, _mm_set1_ps(plane.y)));
+            d = _mm_add_ps(_mm_add_ps(d, _mm_mul_ps(cz, _mm_set1_ps(plane.z))), _mm_set1_ps(plane.w));
+
+            auto boxRadius = _mm_add_ps(_mm_mul_ps(ex, _mm_set1_ps(absNormal.x)), _mm_mul_ps(ey, _mm_set1_ps(absNormal.y)));
+            boxRadius = _mm_add_ps(boxRadius, _mm_mul_ps(ez, _mm_set1_ps(absNormal.z)));
+
+            const auto extent = _mm_min_ps(r, boxRadius);
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(d, extent), _mm_setzero_ps()));
+        }
+
+        cullEmit(i, static_cast<std::uint32_t>(_mm_movemask_ps(inside)), end, visible, visibleCount);
+    }
+    return visibleCount;
+}
+#endif
+
+#if defined(SIMD_AVX2_DISPATCH)
+/* Only call when simdHasAvx2() */
+SIMD_TARGET_AVX2 inline auto cullFrustumAvx2(const CullingSet& set,
+                                             const Frustum& frustum,
+                                             const std::uint32_t first,
+                                             const std::uint32_t count,
+                                             std::uint32_t* visible) -> std::uint32_t
+{
+    const auto absNormals = cullAbsNormals(frustum);
+    const auto end = first + count;
+    std::uint32_t visibleCount = 0;
+    for (auto i = first; i < end; i += 8)
+    {
+        const auto cx = _mm256_loadu_ps(&set.centreX[i]);
+        const auto cy = _mm256_loadu_ps(&set.centreY[i]);
+        const auto cz = _mm256_loadu_ps(&set.centreZ[i]);
+        const auto ex = _mm256_loadu_ps(&set.extentX[i]);
+        const auto ey = _mm256_loadu_ps(&set.extentY[i]);
+        const auto ez = _mm256_loadu_ps(&set.extentZ[i]);
+        const auto r = _mm256_loadu_ps(&set.radius[i]);
+
+        auto inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (std::size_t p = 0; p < frustum.planes.size(); ++p)
+        {
+            const auto& plane = frustum.planes[p];
+            const auto& absNormal = absNormals[p];
+
+            // AVX2 doesn't imply FMA, so stick to mul + add
+            auto d = _mm256_add_ps(_mm256_mul_ps(cx, _mm256_set1_ps(plane.x)), _mm256_mul_ps(cy, _mm256_set1_ps(plane.y)));
+            d = _mm256_add_ps(_mm256_add_ps(d, _mm256_mul_ps(cz, _mm256_set1_ps(plane.z))), _mm256_set1_ps(plane.w));
+
+            auto boxRadius = _mm256_add_ps(_mm256_mul_ps(ex, _mm256_set1_ps(absNormal.x)), _mm256_mul_ps(ey, _mm256_set1_ps(absNormal.y)));
+            boxRadius = _mm256_add_ps(boxRadius, _mm256_mul_ps(ez, _mm256_set1_ps(absNormal.z)));
+
+            const auto extent = _mm256_min_ps(r, boxRadius);
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(d, extent), _mm256_setzero_ps(), _CMP_GE_OQ));
+        }
+
+        cullEmit(i, static_cast<std::uint32_t>(_mm256_movemask_ps(inside)), end, visible, visibleCount);
+    }
+    return visibleCount;
+}
+#endif
+
+/* Writes the indices of the objects in [first, first + count) that intersect the frustum to `visible`, in order.
+   `first` must be a multiple of CullingSet::Width. Returns the number written. Picks AVX2 when the CPU has it (checked at
+   runtime, no compiler flag needed), otherwise SSE2, otherwise scalar. */
+inline auto cullFrustum(const CullingSet& set, const Frustum& frustum, const std::uint32_t first, const std::uint32_t count, std::uint32_t* visible)
+    -> std::uint32_t
+{
+#if defined(SIMD_AVX2_DISPATCH)
+    if (simdHasAvx2())
+        return cullFrustumAvx2(set, frustum, first, count, visible);
+#endif
+#if defined(SIMD_SSE2)
+    return cullFrustumSse2(set, frustum, first, count, visible);
+#else
+    return cullFrustumScalar(set, frustum, first, count, visible);
+#endif
+}
+
+/* Culls the whole set. `visible` is resized to the visible count. */
+inline auto cullFrustum(const CullingSet& set, const Frustum& frustum, std::vector<std::uint32_t>& visible) -> std::uint32_t
+{
+    visible.resize(set.size());
+    const auto visibleCount = cullFrustum(set, frustum, 0, set.size(), visible.data());
+    visible.resize(visibleCount);
+    return visibleCount;
+}
+
+/* Splits the set into chunks of `chunkSize` objects across `pool` and blocks until all are done. The output is
+   identical to the single threaded version. Only worth it for sets in the hundreds of thousands. Waiting on a pool
+   with no threads, or from one of its own workers, could never finish, so those cull on the calling thread instead. */
+inline auto cullFrustumParallel(const CullingSet& set,
+                                const Frustum& frustum,
+                                ThreadPool& pool,
+                                std::vector<std::uint32_t>& visible,
+                                std::uint32_t chunkSize = 64 * 1024) -> std::uint32_t
+{
+    chunkSize = std::max(CullingSet::Width, chunkSize / CullingSet::Width * CullingSet::Width);
+    const auto chunkCount = (set.size() + chunkSize - 1) / chunkSize;
+    if (chunkCount <= 1 || pool.threadCount() == 0 || pool.isWorkerThread())
+        return cullFrustum(set, frustum, visible);
+
+    // Each chunk compacts into its own slice of the output, the slices are then packed together
+    visible.resize(set.size());
+    std::vector<std::uint32_t> chunkVisible(chunkCount);
+    std::latch done(chunkCount);
+    for (std::uint32_t chunk = 0; chunk < chunkCount; ++chunk)
+    {
+        pool.submit([&, chunk] {
+            const auto first = chunk * chunkSize;
+            const auto count = std::min(chunkSize, set.size() - first);
+            chunkVisible[chunk] = cullFrustum(set, frustum, first, count, visible.data() + first);
+            done.count_down();
+        });
+    }
+    done.wait();
+
+    std::uint32_t visibleCount = chunkVisible[0];
+    for (std::uint32_t chunk = 1; chunk < chunkCount; ++chunk)
+    {
+        std::memmove(visible.data() + visibleCount, visible.data() + chunk * chunkSize, chunkVisible[chunk] * sizeof(std::uint32_t));
+        visibleCount += chunkVisible[chunk];
+    }
+    visible.resize(visibleCount);
+    return visibleCount;
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "geometry_pool.hpp"
+#include "gl_state.hpp"
+#include "stream_buffer.hpp"
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+struct DrawElementsIndirectCommand
+{
+    GLuint count = 0;
+    GLuint instanceCount = 0;
+    GLuint firstIndex = 0;
+    GLint baseVertex = 0;
+    GLuint baseInstance = 0;
+};
+
+// Collects draws sharing a program and GeometryPool into one glMultiDrawElementsIndirect.
+// Per-draw data is uploaded to an SSBO and indexed in the shader with gl_DrawID (or gl_BaseInstance, which is set to the draw index).
+template <typename Index>
+class DrawBatch
+{
+public:
+    static constexpr std::uint32_t InvalidDraw = ~0u;
+
+    void init(GLenum topology, std::size_t drawDataStride, std::uint32_t maxDraws, GLuint drawDataBinding = 0);
+
+    void clear();
+    /* Returns the draw index, or InvalidDraw if the batch already holds maxDraws. */
+    auto add(const typename GeometryPool<Index>::Range& range, const void* drawData = nullptr, std::uint32_t instanceCount = 1) -> std::uint32_t;
+
+    /* Uploads the commands & draw data and issues the draws. The pool's VAO and program must already be bound. */
+    void submit();
+
+    auto drawCount() const -> std::uint32_t;
+
+private:
+    GLenum m_topology = 0;
+    std::size_t m_drawDataStride = 0;
+    std::uint32_t m_maxDraws = 0;
+    GLuint m_drawDataBinding = 0;
+    GLint m_ssboAlignment = 1;
+
+    std::vector<DrawElementsIndirectCommand> m_commands;
+    std::vector<std::uint8_t> m_drawData;
+
+    StreamBuffer m_commandStream, m_drawDataStream;
+};
+
+template <typename Index>
+void DrawBatch<Index>::init(const GLenum topology, const std::size_t drawDataStride, const std::uint32_t maxDraws, const GLuint drawDataBinding)
+{
+    m_topology = topology;
+    m_drawDataStride = drawDataStride;
+    m_maxDraws = maxDraws;
+    m_drawDataBinding = drawDataBinding;
+
+    m_commands.reserve(maxDraws);
+    m_commandStream.init(maxDraws * sizeof(DrawElementsIndirectCommand));
+
+    if (drawDataStride > 0)
+    {
+        glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &m_ssboAlignment);
+        m_drawData.reserve(maxDraws * drawDataStride);
+        m_drawDataStream.init(maxDraws * drawDataStride + m_ssboAlignment);
+    }
+}
+
+template <typename Index>
+void DrawBatch<Index>::clear()
+{
+    m_commands.clear();
+    m_drawData.clear();
+}
+
+template <typename Index>
+auto DrawBatch<Index>::add(const typename GeometryPool<Index>::Range& range, const void* drawData, const std::uint32_t instanceCount) -> std::uint32_t
+{
+    // The streams were sized for maxDraws, so anything past that would overrun the upload in submit
+    if (m_commands.size() >= m_maxDraws)
+    {
+        std::cerr << "[DrawBatch] Batch is full (" << m_maxDraws << " draws), dropping draw" << std::endl;
+        return InvalidDraw;
+    }
+
+    const auto drawIndex = static_cast<std::uint32_t>(m_commands.size());
+    m_commands.push_back({ static_cast<GLuint>(range.indexCount), instanceCount, range.firstIndex, range.baseVertex, drawIndex });
+
+    if (m_drawDataStride > 0)
+    {
+        m_drawData.resize(m_drawData.size() + m_drawDataStride);
+        if (drawData != nullptr)
+            std::memcpy(m_drawData.data() + drawIndex * m_drawDataStride, drawData, m_drawDataStride);
+    }
+
+    return drawIndex;
+}
+
+template <typename Index>
+void DrawBatch<Index>::submit()
+{
+    if (m_commands.empty())
+        return;
+
+    m_commandStream.advance();
+    const auto commandOffset = m_commandStream.write(m_commands.data(), m_commands.size() * sizeof(DrawElementsIndirectCommand));
+    if (commandOffset == StreamBuffer::WriteFailed)
+        return;
+
+    if (m_drawDataStride > 0)
+    {
+        m_drawDataStream.advance();
+        const auto dataOffset = m_drawDataStream.write(m_drawData.data(), m_drawData.size(), m_ssboAlignment);
+        if (dataOffset == StreamBuffer::WriteFailed)
+            return;
+        GLState::bindBufferRange(GL_SHADER_STORAGE_BUFFER, m_drawDataBinding, m_drawDataStream.buffer(), dataOffset, m_drawData.size());
+    }
+
+    GLState::bindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandStream.buffer());
+    const auto* indirect = reinterpret_cast<const void*>(commandOffset);
+    glMultiDrawElementsIndirect(m_topology, IndexTraits<Index>::glType, indirect, static_cast<GLsizei>(m_commands.size()), 0);
+}
+
+template <typename Index>
+auto DrawBatch<Index>::drawCount() const -> std::uint32_t
+{
+    return static_cast<std::uint32_t>(m_commands.size());
+}
@@ -0,0 +1,401 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#if defined(_WIN32)
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+#elif defined(__linux__)
+    #include <poll.h>
+    #include <sys/eventfd.h>
+    #include <sys/inotify.h>
+    #include <unistd.h>
+#endif
+
+// Watches directory trees for modified files on a background thread (inotify on Linux, ReadDirectoryChangesW on
+// Windows). Changes are collected until the main thread takes them, and hasChanges() is a single relaxed atomic load,
+// so polling it every frame is free. Files moved into place are reported too, which covers editors that save through a
+// rename. With inotify only files written and closed are reported, and subdirectories created after watch() aren't
+// picked up. Windows watches the whole subtree but reports writes as they happen, so one save may show up over two
+// takeChanges() calls. On other platforms watch() fails and nothing is reported.
+class FileWatcher
+{
+public:
+    FileWatcher() = default;
+    FileWatcher(const FileWatcher&) = delete;
+    auto operator=(const FileWatcher&) -> FileWatcher& = delete;
+    ~FileWatcher();
+
+    /* Watches `directory` and its subdirectories. Starts the watcher thread on first use. */
+    auto watch(const std::filesystem::path& directory) -> bool;
+    void stop();
+
+    auto hasChanges() const -> bool;
+    /* Canonical paths of every file changed since the last call, without duplicates */
+    auto takeChanges() -> std::vector<std::string>;
+
+private:
+    void run();
+    void addChange(std::string path);
+
+#if defined(_WIN32)
+    struct WatchedDirectory
+    {
+        std::filesystem::path path;
+        HANDLE handle = INVALID_HANDLE_VALUE;
+        OVERLAPPED overlapped = {};
+        bool reading = false;
+        alignas(DWORD) std::uint8_t buffer[64 * 1024]; // The most ReadDirectoryChangesW takes over the network
+    };
+
+    /* Starts an overlapped read on the watcher thread. Closes the directory if it can't be watched any more. */
+    static void readChanges(WatchedDirectory& directory);
+#endif
+
+private:
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::vector<std::string> m_changes;
+    std::atomic<bool> m_dirty = false;
+
+#if defined(_WIN32)
+    std::vector<std::unique_ptr<WatchedDirectory>> m_directories; // Only appended to while the thread runs
+    HANDLE m_wake = nullptr;                                      // Auto-reset, picks up new directories or stops
+    std::atomic<bool> m_stopping = false;
+#else
+    std::unordered_map<int, std::filesystem::path> m_directories; // Watch descriptor -> directory
+    int m_inotify = -1;
+    int m_wake = -1;
+#endif
+};
+
+inline FileWatcher::~FileWatcher()
+{
+    stop();
+}
+
+#if defined(_WIN32)
+
+inline auto FileWatcher::watch(const std::filesystem::path& directory) -> bool
+{
+    std::error_code error;
+    const auto root = std::filesystem::canonical(directory, error);
+    if (error || !std::filesystem::is_directory(root))
+    {
+        std::cerr << "[FileWatcher] " << directory.string() << " is not a directory" << std::endl;
+        return false;
+    }
+
+    if (m_wake == nullptr)
+    {
+        m_wake = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+        if (m_wake == nullptr)
+        {
+            std::cerr << "[FileWatcher] Failed to create the wake event" << std::endl;
+            return false;
+        }
+    }
+
+    // The thread waits on the wake event plus one event per tree
+    {
+        std::lock_guard lock(m_mutex);
+        if (m_directories.size() + 1 >= MAXIMUM_WAIT_OBJECTS)
+        {
+            std::cerr << "[FileWatcher] Can't watch more than " << MAXIMUM_WAIT_OBJECTS - 1 << " trees, not watching " << root.string() << std::endl;
+            return false;
+        }
+    }
+
+    auto watched = std::make_unique<WatchedDirectory>();
+    watched->path = root;
+    watched->handle = CreateFileW(root.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                                  FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+    watched->overlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    if (watched->handle == INVALID_HANDLE_VALUE || watched->overlapped.hEvent == nullptr)
+    {
+        std::cerr << "[FileWatcher] Failed to open " << root.string() << std::endl;
+        if (watched->handle != INVALID_HANDLE_VALUE)
+            CloseHandle(watched->handle);
+        if (watched->overlapped.hEvent != nullptr)
+            CloseHandle(watched->overlapped.hEvent);
+        return false;
+    }
+
+    {
+        std::lock_guard lock(m_mutex);
+        m_directories.push_back(std::move(watched));
+    }
+
+    if (!m_thread.joinable())
+    {
+        m_stopping = false;
+        m_thread = std::thread(&FileWatcher::run, this);
+    }
+    else
+    {
+        SetEvent(m_wake);
+    }
+    return true;
+}
+
+inline void FileWatcher::stop()
+{
+    if (m_thread.joinable())
+    {
+        m_stopping = true;
+        SetEvent(m_wake);
+        m_thread.join();
+    }
+
+    // The thread has cancelled and waited for its reads, so the buffers are free
+    for (const auto& directory : m_directories)
+    {
+        if (directory->handle != INVALID_HANDLE_VALUE)
+            CloseHandle(directory->handle);
+        CloseHandle(directory->overlapped.hEvent);
+    }
+    m_directories.clear();
+
+    if (m_wake != nullptr)
+        CloseHandle(m_wake);
+    m_wake = nullptr;
+}
+
+inline void FileWatcher::readChanges(WatchedDirectory& directory)
+{
+    constexpr DWORD Filter = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE;
+    directory.reading = ReadDirectoryChangesW(directory.handle, directory.buffer, sizeof(directory.buffer), TRUE, Filter, nullptr, &directory.overlapped,
+                                              nullptr) != FALSE;
+    if (!directory.reading)
+    {
+        std::cerr << "[FileWatcher] Stopped watching " << directory.path.string() << std::endl;
+        CloseHandle(directory.handle);
+        directory.handle = INVALID_HANDLE_VALUE;
+    }
+}
+
+inline void FileWatcher::run()
+{
+    std::vector<HANDLE> events;
+    std::vector<WatchedDirectory*> watched;
+    while (!m_stopping)
+    {
+        // Reads are issued from this thread only, Windows cancels them when the issuing thread exits
+        events = { m_wake };
+        watched.clear();
+        {
+            std::lock_guard lock(m_mutex);
+            for (const auto& directory : m_directories)
+            {
+                if (directory->handle != INVALID_HANDLE_VALUE && !directory->reading)
+                    readChanges(*directory);
+                if (directory->reading)
+                {
+                    events.push_back(directory->overlapped.hEvent);
+                    watched.push_back(directory.get());
+                }
+            }
+        }
+
+        const auto result = WaitForMultipleObjects(static_cast<DWORD>(events.size()), events.data(), FALSE, INFINITE);
+        if (result == WAIT_FAILED)
+        {
+            std::cerr << "[FileWatcher] Waiting for changes failed, no longer watching" << std::endl;
+            break;
+        }
+        if (result <= WAIT_OBJECT_0 || result >= WAIT_OBJECT_0 + events.size())
+            continue; // Woken up to pick up new directories or stop
+
+        auto& directory = *watched[result - WAIT_OBJECT_0 - 1];
+        directory.reading = false;
+        DWORD length = 0;
+        if (!GetOverlappedResult(directory.handle, &directory.overlapped, &length, FALSE))
+            continue;
+        if (length == 0)
+        {
+            std::cerr << "[FileWatcher] Too many changes at once in " << directory.path.string() << ", some were missed" << std::endl;
+            continue;
+        }
+
+        for (DWORD offset = 0;;)
+        {
+            const auto* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(directory.buffer + offset);
+            if (info->Action == FILE_ACTION_ADDED || info->Action == FILE_ACTION_MODIFIED || info->Action == FILE_ACTION_RENAMED_NEW_NAME)
+            {
+                // Directories report modifications too when their contents change
+                const auto path = directory.path / std::wstring(info->FileName, info->FileNameLength / sizeof(WCHAR));
+                std::error_code error;
+                if (std::filesystem::is_regular_file(path, error))
+                    addChange(path.string());
+            }
+
+            if (info->NextEntryOffset == 0)
+                break;
+            offset += info->NextEntryOffset;
+        }
+    }
+
+    std::lock_guard lock(m_mutex);
+    for (const auto& directory : m_directories)
+    {
+        if (!directory->reading)
+            continue;
+
+        DWORD length = 0;
+        CancelIoEx(directory->handle, &directory->overlapped);
+        GetOverlappedResult(directory->handle, &directory->overlapped, &length, TRUE);
+        directory->reading = false;
+    }
+}
+
+#elif defined(__linux__)
+
+inline auto FileWatcher::watch(const std::filesystem::path& directory) -> bool
+{
+    std::error_code error;
+    const auto root = std::filesystem::canonical(directory, error);
+    if (error || !std::filesystem::is_directory(root))
+    {
+        std::cerr << "[FileWatcher] " << directory.string() << " is not a directory" << std::endl;
+        return false;
+    }
+
+    if (m_inotify < 0)
+    {
+        m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        m_wake = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (m_inotify < 0 || m_wake < 0)
+        {
+            std::cerr << "[FileWatcher] Failed to initialise inotify" << std::endl;
+            stop();
+            return false;
+        }
+    }
+
+    std::vector<std::filesystem::path> directories = { root };
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(root, error))
+    {
+        if (entry.is_directory())
+            directories.push_back(entry.path());
+    }
+
+    {
+        std::lock_guard lock(m_mutex);
+        for (const auto& path : directories)
+        {
+            const auto descriptor = inotify_add_watch(m_inotify, path.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+            if (descriptor >= 0)
+                m_directories[descriptor] = path;
+        }
+    }
+
+    if (!m_thread.joinable())
+        m_thread = std::thread(&FileWatcher::run, this);
+    return true;
+}
+
+inline void FileWatcher::stop()
+{
+    if (m_thread.joinable())
+    {
+        const std::uint64_t wake = 1;
+        [[maybe_unused]] const auto written = write(m_wake, &wake, sizeof(wake));
+        m_thread.join();
+    }
+
+    if (m_inotify >= 0)
+        close(m_inotify);
+    if (m_wake >= 0)
+        close(m_wake);
+    m_inotify = m_wake = -1;
+    m_directories.clear();
+}
+
+inline void FileWatcher::run()
+{
+    alignas(inotify_event) char buffer[4096];
+    pollfd fds[2] = { { m_inotify, POLLIN, 0 }, { m_wake, POLLIN, 0 } };
+    while (true)
+    {
+        if (poll(fds, 2, -1) < 0)
+            continue;
+        if (fds[1].revents & POLLIN)
+            return;
+
+        ssize_t length;
+        while ((length = read(m_inotify, buffer, sizeof(buffer))) > 0)
+        {
+            for (ssize_t offset = 0; offset < length;)
+            {
+                const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+                offset += sizeof(inotify_event) + event->len;
+                if (event->len == 0 || (event->mask & IN_ISDIR))
+                    continue;
+
+                std::filesystem::path directory;
+                {
+                    std::lock_guard lock(m_mutex);
+                    const auto it = m_directories.find(event->wd);
+                    if (it == m_directories.end())
+                        continue;
+                    directory = it->second;
+                }
+                addChange((directory / event->name).string());
+            }
+        }
+    }
+}
+
+#else
+
+inline auto FileWatcher::watch(const std::filesystem::path& directory) -> bool
+{
+    std::cerr << "[FileWatcher] File watching isn't supported on this platform, not watching " << directory.string() << std::endl;
+    return false;
+}
+
+inline void FileWatcher::stop()
+{
+}
+
+inline void FileWatcher::run()
+{
+}
+
+#endif
+
+inline auto FileWatcher::hasChanges() const -> bool
+{
+    return m_dirty.load(std::memory_order_relaxed);
+}
+
+inline auto FileWatcher::takeChanges() -> std::vector<std::string>
+{
+    std::lock_guard lock(m_mutex);
+    m_dirty.store(false, std::memory_order_relaxed);
+    return std::exchange(m_changes, {});
+}
+
+inline void FileWatcher::addChange(std::string path)
+{
+    std::lock_guard lock(m_mutex);
+    if (std::find(m_changes.begin(), m_changes.end(), path) == m_changes.end())
+        m_changes.push_back(std::move(path));
+    m_dirty.store(true, std::memory_order_relaxed);
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <glm/ext/matrix_float4x4.hpp>
+#include <glm/ext/vector_float3.hpp>
+#include <glm/ext/vector_float4.hpp>
+#include <glm/geometric.hpp>
+
+#include <array>
+
+// Six inward facing planes (left, right, bottom, top, near, far) as (normal, distance). A point p is inside when dot(n, p) + d >= 0.
+struct Frustum
+{
+    std::array<glm::vec4, 6> planes;
+
+    /* Extracts the planes of a GL clip space matrix. Pass a model-view-projection to get object space planes. */
+    static auto fromMatrix(const glm::mat4& m) -> Frustum;
+
+    bool intersectsSphere(const glm::vec3& centre, float radius) const;
+    bool intersectsAabb(const glm::vec3& min, const glm::vec3& max) const;
+};
+
+inline auto Frustum::fromMatrix(const glm::mat4& m) -> Frustum
+{
+    const glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+    const glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+    const glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+    const glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+    Frustum frustum;
+    frustum.planes = { row3 + row0, row3 - row0, row3 + row1, row3 - row1, row3 + row2, row3 - row2 };
+    for (auto& plane : frustum.planes)
+        plane /= glm::length(glm::vec3(plane));
+
+    return frustum;
+}
+
+inline bool Frustum::intersectsSphere(const glm::vec3& centre, const float radius) const
+{
+    for (const auto& plane : planes)
+    {
+        if (glm::dot(glm::vec3(plane), centre) + plane.w < -radius)
+            return false;
+    }
+    return true;
+}
+
+inline bool Frustum::intersectsAabb(const glm::vec3& min, const glm::vec3& max) const
+{
+    for (const auto& plane : planes)
+    {
+        // Test the corner furthest along the plane normal
+        const glm::vec3 corner(plane.x >= 0 ? max.x : min.x, plane.y >= 0 ? max.y : min.y, plane.z >= 0 ? max.z : min.z);
+        if (glm::dot(glm::vec3(plane), corner) + plane.w < 0)
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,272 @@
+#pragma once
+
+#include "gl_handle.hpp"
+#include "gl_state.hpp"
+#include "mesh.hpp"
+#include "range_allocator.hpp"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <span>
+#include <utility>
+#include <vector>
+
+struct GeometryPoolStats
+{
+    std::uint32_t allocations = 0;
+    std::size_t vertexBytesInUse = 0, vertexBytesCapacity = 0;
+    std::size_t indexBytesInUse = 0, indexBytesCapacity = 0;
+    float vertexFragmentation = 0.0f;
+    float indexFragmentation = 0.0f;
+    std::uint32_t compactions = 0;
+};
+
+// One shared VBO/EBO/VAO per vertex format. Meshes are suballocated from it and drawn with glDrawElementsBaseVertex,
+// so any number of them can be drawn without rebinding.
+template <typename Index>
+class GeometryPool
+{
+public:
+    using Handle = std::uint32_t;
+    static constexpr Handle InvalidHandle = ~0u;
+
+    struct Range
+    {
+        GLint baseVertex = 0;
+        GLuint firstIndex = 0;
+        GLsizei indexCount = 0;
+    };
+
+    void init(GLenum topology, std::size_t stride, std::span<const Attrib> attribs, std::uint32_t vertexCapacity, std::uint32_t indexCapacity);
+
+    template <typename V>
+    void init(GLenum topology, std::uint32_t vertexCapacity, std::uint32_t indexCapacity);
+
+    auto allocate(const void* vertices, std::uint32_t vertexCount, const Index* indices, std::uint32_t indexCount) -> Handle;
+    void free(Handle handle);
+
+    /* Repack all live allocations to the front of the buffers, removing any holes */
+    void compact();
+
+    auto range(Handle handle) const -> const Range&;
+    auto stats() const -> GeometryPoolStats;
+
+    void bind() const;
+    void draw(Handle handle) const;
+
+private:
+    struct Allocation
+    {
+        Range range;
+        std::uint32_t vertexCount = 0;
+        bool live = false;
+    };
+
+    void relocate(std::uint32_t vertexCapacity, std::uint32_t indexCapacity);
+
+private:
+    GLVertexArray m_vao;
+    GLBuffer m_vbo, m_ebo;
+    GLenum m_topology = 0;
+    std::size_t m_stride = 0;
+
+    RangeAllocator m_vertexAllocator, m_indexAllocator;
+
+    std::vector<Allocation> m_allocations;
+    std::vector<Handle> m_freeHandles;
+    std::uint32_t m_liveCount = 0;
+    std::uint32_t m_compactions = 0;
+};
+
+template <typename Index>
+void GeometryPool<Index>::init(const GLenum topology,
+                               const std::size_t stride,
+                               const std::span<const Attrib> attribs,
+                               const std::uint32_t vertexCapacity,
+                               const std::uint32_t indexCapacity)
+{
+    m_topology = topology;
+    m_stride = stride;
+
+    m_vao = GLVertexArray::create();
+    for (const auto& attrib : attribs)
+    {
+        glEnableVertexArrayAttrib(m_vao.id(), attrib.index);
+        glVertexArrayAttribBinding(m_vao.id(), attrib.index, 0);
+        glVertexArrayAttribFormat(m_vao.id(), attrib.index, attrib.size, attrib.type, attrib.normalised, attrib.offset);
+    }
+
+    relocate(vertexCapacity, indexCapacity);
+}
+
+template <typename Index>
+template <typename V>
+void GeometryPool<Index>::init(const GLenum topology, const std::uint32_t vertexCapacity, const std::uint32_t indexCapacity)
+{
+    init(topology, VertexLayout<V>::stride, VertexLayout<V>::attribs, vertexCapacity, indexCapacity);
+}
+
+template <typename Index>
+auto GeometryPool<Index>::allocate(const void* vertices, const std::uint32_t vertexCount, const Index* indices, const std::uint32_t indexCount) -> Handle
+{
+    // The allocators can't hand out empty ranges, so this would fail, compact for nothing and fail again
+    if (vertexCount == 0 || indexCount == 0)
+    {
+        std::cerr << "[GeometryPool] Refusing an empty allocation of " << vertexCount << " vertices, " << indexCount << " indices" << std::endl;
+        return InvalidHandle;
+    }
+
+    auto vertexOffset = m_vertexAllocator.allocate(vertexCount);
+    auto indexOffset = m_indexAllocator.allocate(indexCount);
+
+    if (vertexOffset == RangeAllocator::InvalidOffset || indexOffset == RangeAllocator::InvalidOffset)
+    {
+        if (vertexOffset != RangeAllocator::InvalidOffset)
+            m_vertexAllocator.free(vertexOffset, vertexCount);
+        if (indexOffset != RangeAllocator::InvalidOffset)
+            m_indexAllocator.free(indexOffset, indexCount);
+
+        // Out of contiguous space. Compact into buffers big enough for the request, growing if needed.
+        auto vertexCapacity = m_vertexAllocator.capacity();
+        while (vertexCapacity - m_vertexAllocator.used() < vertexCount)
+            vertexCapacity = std::max(vertexCapacity * 2, vertexCount);
+        auto indexCapacity = m_indexAllocator.capacity();
+        while (indexCapacity - m_indexAllocator.used() < indexCount)
+            indexCapacity = std::max(indexCapacity * 2, indexCount);
+
+        relocate(vertexCapacity, indexCapacity);
+
+        vertexOffset = m_vertexAllocator.allocate(vertexCount);
+        indexOffset = m_indexAllocator.allocate(indexCount);
+        if (vertexOffset == RangeAllocator::InvalidOffset || indexOffset == RangeAllocator::InvalidOffset)
+        {
+            std::cerr << "[GeometryPool] Failed to allocate " << vertexCount << " vertices, " << indexCount << " indices" << std::endl;
+            return InvalidHandle;
+        }
+    }
+
+    glNamedBufferSubData(m_vbo.id(), vertexOffset * m_stride, vertexCount * m_stride, vertices);
+    glNamedBufferSubData(m_ebo.id(), indexOffset * sizeof(Index), indexCount * sizeof(Index), indices);
+
+    Handle handle;
+    if (!m_freeHandles.empty())
+    {
+        handle = m_freeHandles.back();
+        m_freeHandles.pop_back();
+    }
+    else
+    {
+        handle = static_cast<Handle>(m_allocations.size());
+        m_allocations.emplace_back();
+    }
+
+    auto& allocation = m_allocations[handle];
+    allocation.range = { static_cast<GLint>(vertexOffset), indexOffset, static_cast<GLsizei>(indexCount) };
+    allocation.vertexCount = vertexCount;
+    allocation.live = true;
+    ++m_liveCount;
+
+    return handle;
+}
+
+template <typename Index>
+void GeometryPool<Index>::free(const Handle handle)
+{
+    auto& allocation = m_allocations[handle];
+    if (!allocation.live)
+        return;
+
+    m_vertexAllocator.free(allocation.range.baseVertex, allocation.vertexCount);
+    m_indexAllocator.free(allocation.range.firstIndex, allocation.range.indexCount);
+
+    allocation.live = false;
+    m_freeHandles.push_back(handle);
+    --m_liveCount;
+}
+
+template <typename Index>
+void GeometryPool<Index>::compact()
+{
+    relocate(m_vertexAllocator.capacity(), m_indexAllocator.capacity());
+}
+
+template <typename Index>
+auto GeometryPool<Index>::range(const Handle handle) const -> const Range&
+{
+    return m_allocations[handle].range;
+}
+
+template <typename Index>
+auto GeometryPool<Index>::stats() const -> GeometryPoolStats
+{
+    GeometryPoolStats stats;
+    stats.allocations = m_liveCount;
+    stats.vertexBytesInUse = m_vertexAllocator.used() * m_stride;
+    stats.vertexBytesCapacity = m_vertexAllocator.capacity() * m_stride;
+    stats.indexBytesInUse = m_indexAllocator.used() * sizeof(Index);
+    stats.indexBytesCapacity = m_indexAllocator.capacity() * sizeof(Index);
+    stats.vertexFragmentation = m_vertexAllocator.fragmentation();
+    stats.indexFragmentation = m_indexAllocator.fragmentation();
+    stats.compactions = m_compactions;
+    return stats;
+}
+
+template <typename Index>
+void GeometryPool<Index>::bind() const
+{
+    GLState::bindVertexArray(m_vao.id());
+}
+
+template <typename Index>
+void GeometryPool<Index>::draw(const Handle handle) const
+{
+    const auto& range = m_allocations[handle].range;
+    const auto* indices = reinterpret_cast<const void*>(range.firstIndex * sizeof(Index));
+    glDrawElementsBaseVertex(m_topology, range.indexCount, IndexTraits<Index>::glType, indices, range.baseVertex);
+}
+
+template <typename Index>
+void GeometryPool<Index>::relocate(const std::uint32_t vertexCapacity, const std::uint32_t indexCapacity)
+{
+    auto vbo = GLBuffer::create();
+    auto ebo = GLBuffer::create();
+    glNamedBufferStorage(vbo.id(), vertexCapacity * m_stride, nullptr, GL_DYNAMIC_STORAGE_BIT);
+    glNamedBufferStorage(ebo.id(), indexCapacity * sizeof(Index), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+    // Pack live allocations tightly into the new buffers. Indices are relative to baseVertex so need no patching.
+    std::uint32_t vertexCursor = 0, indexCursor = 0;
+    for (auto& allocation : m_allocations)
+    {
+        if (!allocation.live)
+            continue;
+
+        auto& range = allocation.range;
+        glCopyNamedBufferSubData(m_vbo.id(), vbo.id(), range.baseVertex * m_stride, vertexCursor * m_stride, allocation.vertexCount * m_stride);
+        glCopyNamedBufferSubData(m_ebo.id(), ebo.id(), range.firstIndex * sizeof(Index), indexCursor * sizeof(Index), range.indexCount * sizeof(Index));
+
+        range.baseVertex = static_cast<GLint>(vertexCursor);
+        range.firstIndex = indexCursor;
+        vertexCursor += allocation.vertexCount;
+        indexCursor += range.indexCount;
+    }
+
+    m_vertexAllocator.init(vertexCapacity);
+    m_indexAllocator.init(indexCapacity);
+    if (vertexCursor > 0)
+        m_vertexAllocator.allocate(vertexCursor);
+    if (indexCursor > 0)
+        m_indexAllocator.allocate(indexCursor);
+
+    if (m_vbo)
+        ++m_compactions;
+
+    // The old buffers are still the source of the copies above, so let the deletion queue retire them
+    m_vbo = std::move(vbo);
+    m_ebo = std::move(ebo);
+
+    glVertexArrayElementBuffer(m_vao.id(), m_ebo.id());
+    glVertexArrayVertexBuffer(m_vao.id(), 0, m_vbo.id(), 0, static_cast<GLsizei>(m_stride));
+}
@@ -0,0 +1,319 @@
+#pragma once
+
+#include "gl_state.hpp"
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+enum class GLObjectType : std::uint8_t
+{
+    Buffer,
+    VertexArray,
+    Program,
+    Texture,
+    Shader,
+};
+
+// Defers deletion of GL objects until the GPU has finished every frame that could still reference them.
+// Releases are collected per frame and fenced in endFrame(). A batch is only deleted once its fence has signalled, so
+// glDelete* never forces the driver to sync. release() may be called from any thread, everything else on the GL thread.
+class GLDeletionQueue
+{
+public:
+    static void release(GLObjectType type, GLuint id);
+
+    /* Call once per frame after the last draw (eg. after swapping buffers) */
+    static void endFrame();
+
+    /* Deletes everything immediately. Call before destroying the context. */
+    static void flush();
+
+    static auto pendingCount() -> std::size_t;
+
+private:
+    struct Object
+    {
+        GLObjectType type;
+        GLuint id;
+    };
+
+    struct Batch
+    {
+        GLsync fence = nullptr;
+        std::vector<Object> objects;
+    };
+
+    static void destroy(const std::vector<Object>& objects);
+
+private:
+    inline static std::mutex m_mutex;
+    inline static std::vector<Object> m_pending;
+    inline static std::deque<Batch> m_batches;
+};
+
+// Move-only owner of a GL object name. Destruction and reassignment hand the object to GLDeletionQueue.
+template <GLObjectType Type>
+class GLHandle
+{
+public:
+    GLHandle() = default;
+    explicit GLHandle(GLuint id);
+    GLHandle(const GLHandle&) = delete;
+    auto operator=(const GLHandle&) -> GLHandle& = delete;
+    GLHandle(GLHandle&& other) noexcept;
+    auto operator=(GLHandle&& other) noexcept -> GLHandle&;
+    ~GLHandle();
+
+    static auto create() -> GLHandle
+        requires(Type != GLObjectType::Texture && Type != GLObjectType::Shader);
+    /* Texture target or shader stage */
+    static auto create(GLenum target) -> GLHandle
+        requires(Type == GLObjectType::Texture || Type == GLObjectType::Shader);
+
+    auto id() const -> GLuint;
+    explicit operator bool() const;
+
+    /* Queues the current object for deletion and takes ownership of `id` */
+    void reset(GLuint id = 0);
+    /* Gives up ownership without deleting */
+    auto release() -> GLuint;
+
+private:
+    GLuint m_id = 0;
+};
+
+using GLBuffer = GLHandle<GLObjectType::Buffer>;
+using GLVertexArray = GLHandle<GLObjectType::VertexArray>;
+using GLProgram = GLHandle<GLObjectType::Program>;
+using GLTexture = GLHandle<GLObjectType::Texture>;
+using GLShader = GLHandle<GLObjectType::Shader>;
+
+// Move-only fence. Unlike object names a sync can be deleted while pending, so it is released immediately.
+class GLFence
+{
+public:
+    GLFence() = default;
+    GLFence(const GLFence&) = delete;
+    auto operator=(const GLFence&) -> GLFence& = delete;
+    GLFence(GLFence&& other) noexcept;
+    auto operator=(GLFence&& other) noexcept -> GLFence&;
+    ~GLFence();
+
+    /* Replaces any previous fence with one after all commands submitted so far */
+    void insert();
+    void reset();
+
+    auto get() const -> GLsync;
+    explicit operator bool() const;
+
+private:
+    GLsync m_sync = nullptr;
+};
+
+inline void GLDeletionQueue::release(const GLObjectType type, const GLuint id)
+{
+    if (id == 0)
+        return;
+
+    std::lock_guard lock(m_mutex);
+    m_pending.push_back({ type, id });
+}
+
+inline void GLDeletionQueue::endFrame()
+{
+    std::vector<Object> retired;
+    {
+        std::lock_guard lock(m_mutex);
+        if (!m_pending.empty())
+            m_batches.push_back({ glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), std::move(m_pending) });
+        m_pending.clear();
+
+        // Batches are fenced in order, so stop at the first one the GPU hasn't reached
+        while (!m_batches.empty())
+        {
+            auto& batch = m_batches.front();
+            const auto result = glClientWaitSync(batch.fence, 0, 0);
+            if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED)
+                break;
+
+            glDeleteSync(batch.fence);
+            retired.insert(retired.end(), batch.objects.begin(), batch.objects.end());
+            m_batches.pop_front();
+        }
+    }
+
+    destroy(retired);
+}
+
+inline void GLDeletionQueue::flush()
+{
+    std::lock_guard lock(m_mutex);
+    for (auto& batch : m_batches)
+    {
+        glDeleteSync(batch.fence);
+        destroy(batch.objects);
+    }
+    m_batches.clear();
+
+    destroy(m_pending);
+    m_pending.clear();
+}
+
+inline auto GLDeletionQueue::pendingCount() -> std::size_t
+{
+    std::lock_guard lock(m_mutex);
+    auto count = m_pending.size();
+    for (const auto& batch : m_batches)
+        count += batch.objects.size();
+    return count;
+}
+
+inline void GLDeletionQueue::destroy(const std::vector<Object>& objects)
+{
+    for (const auto& object : objects)
+    {
+        switch (object.type)
+        {
+        case GLObjectType::Buffer:
+            glDeleteBuffers(1, &object.id);
+            GLState::forgetBuffer(object.id);
+            break;
+        case GLObjectType::VertexArray:
+            glDeleteVertexArrays(1, &object.id);
+            GLState::forgetVertexArray(object.id);
+            break;
+        case GLObjectType::Program:
+            glDeleteProgram(object.id);
+            break;
+        case GLObjectType::Texture:
+            glDeleteTextures(1, &object.id);
+            GLState::forgetTexture(object.id);
+            break;
+        case GLObjectType::Shader:
+            glDeleteShader(object.id);
+            break;
+        }
+    }
+}
+
+template <GLObjectType Type>
+GLHandle<Type>::GLHandle(const GLuint id) : m_id(id)
+{
+}
+
+template <GLObjectType Type>
+GLHandle<Type>::GLHandle(GLHandle&& other) noexcept : m_id(std::exchange(other.m_id, 0))
+{
+}
+
+template <GLObjectType Type>
+auto GLHandle<Type>::operator=(GLHandle&& other) noexcept -> GLHandle&
+{
+    if (this != &other)
+        reset(std::exchange(other.m_id, 0));
+    return *this;
+}
+
+template <GLObjectType Type>
+GLHandle<Type>::~GLHandle()
+{
+    reset();
+}
+
+template <GLObjectType Type>
+auto GLHandle<Type>::create() -> GLHandle
+    requires(Type != GLObjectType::Texture && Type != GLObjectType::Shader)
+{
+    GLuint id = 0;
+    if constexpr (Type == GLObjectType::Buffer)
+        glCreateBuffers(1, &id);
+    else if constexpr (Type == GLObjectType::VertexArray)
+        glCreateVertexArrays(1, &id);
+    else if constexpr (Type == GLObjectType::Program)
+        id = glCreateProgram();
+    return GLHandle(id);
+}
+
+template <GLObjectType Type>
+auto GLHandle<Type>::create(const GLenum target) -> GLHandle
+    requires(Type == GLObjectType::Texture || Type == GLObjectType::Shader)
+{
+    GLuint id = 0;
+    if constexpr (Type == GLObjectType::Texture)
+        glCreateTextures(target, 1, &id);
+    else
+        id = glCreateShader(target);
+    return GLHandle(id);
+}
+
+template <GLObjectType Type>
+auto GLHandle<Type>::id() const -> GLuint
+{
+    return m_id;
+}
+
+template <GLObjectType Type>
+GLHandle<Type>::operator bool() const
+{
+    return m_id != 0;
+}
+
+template <GLObjectType Type>
+void GLHandle<Type>::reset(const GLuint id)
+{
+    GLDeletionQueue::release(Type, m_id);
+    m_id = id;
+}
+
+template <GLObjectType Type>
+auto GLHandle<Type>::release() -> GLuint
+{
+    return std::exchange(m_id, 0);
+}
+
+inline GLFence::GLFence(GLFence&& other) noexcept : m_sync(std::exchange(other.m_sync, nullptr))
+{
+}
+
+inline auto GLFence::operator=(GLFence&& other) noexcept -> GLFence&
+{
+    if (this != &other)
+    {
+        reset();
+        m_sync = std::exchange(other.m_sync, nullptr);
+    }
+    return *this;
+}
+
+inline GLFence::~GLFence()
+{
+    reset();
+}
+
+inline void GLFence::insert()
+{
+    reset();
+    m_sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+inline void GLFence::reset()
+{
+    if (m_sync != nullptr)
+        glDeleteSync(m_sync);
+    m_sync = nullptr;
+}
+
+inline auto GLFence::get() const -> GLsync
+{
+    return m_sync;
+}
+
+inline GLFence::operator bool() const
+{
+    return m_sync != nullptr;
+}
@@ -0,0 +1,539 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+enum class GLCap : std::uint8_t
+{
+    Blend,
+    CullFace,
+    DepthTest,
+    StencilTest,
+    ScissorTest,
+    PrimitiveRestart,
+    Count,
+};
+
+struct GLRect
+{
+    GLint x = 0, y = 0;
+    GLsizei width = 0, height = 0;
+
+    auto operator==(const GLRect&) const -> bool = default;
+};
+
+struct GLBlendState
+{
+    GLenum equationRgb = GL_FUNC_ADD, equationAlpha = GL_FUNC_ADD;
+    GLenum srcRgb = GL_ONE, dstRgb = GL_ZERO;
+    GLenum srcAlpha = GL_ONE, dstAlpha = GL_ZERO;
+
+    auto operator==(const GLBlendState&) const -> bool = default;
+};
+
+// Indexed uniform / shader storage binding. Size 0 means the whole buffer (glBindBufferBase).
+struct GLIndexedBinding
+{
+    GLuint buffer = 0;
+    GLintptr offset = 0;
+    GLsizeiptr size = 0;
+
+    auto operator==(const GLIndexedBinding&) const -> bool = default;
+};
+
+// Everything GLState shadows. Copyable, so backup/restore around foreign render code never needs a glGet.
+struct GLStateSnapshot
+{
+    static constexpr std::uint32_t BufferTargetCount = 10;
+    static constexpr std::uint32_t MaxTextureUnits = 16;
+    static constexpr std::uint32_t MaxIndexedBindings = 16;
+
+    GLuint program = 0;
+    GLuint vertexArray = 0;
+    std::array<GLuint, BufferTargetCount> buffers = {};
+    std::array<GLIndexedBinding, MaxIndexedBindings> uniformBuffers = {};
+    std::array<GLIndexedBinding, MaxIndexedBindings> storageBuffers = {};
+    std::array<GLuint, MaxTextureUnits> textures = {};
+    std::array<GLuint, MaxTextureUnits> samplers = {};
+
+    std::uint32_t caps = 0; // Bit per GLCap
+    GLBlendState blend;
+    GLenum depthFunc = GL_LESS;
+    GLboolean depthMask = GL_TRUE;
+    GLenum cullFace = GL_BACK;
+    GLenum polygonMode = GL_FILL;
+    GLRect viewport, scissor;
+};
+
+struct GLStateStats
+{
+    std::uint64_t issued = 0;
+    std::uint64_t skipped = 0;
+};
+
+// Shadow copy of the context's binding and fixed-function state. Setters skip the GL call when the value is unchanged.
+// All rendering code has to go through it for the shadow to stay in sync, anything that doesn't must call init() again
+// afterwards. Element array buffers are VAO state and are left untracked, as are texture units and indexed bindings past
+// the snapshot limits or the context's own, and the parameter buffer without GL 4.6 or ARB_indirect_parameters; those
+// calls are always issued. Textures are bound with glBindTextureUnit.
+class GLState
+{
+public:
+    /* Reads the context's limits and current state back once. Call after the context is created. */
+    static void init();
+
+    static void useProgram(GLuint program);
+    static void bindVertexArray(GLuint vertexArray);
+    static void bindBuffer(GLenum target, GLuint buffer);
+    static void bindBufferBase(GLenum target, GLuint index, GLuint buffer);
+    static void bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+    static void bindTexture(GLuint unit, GLuint texture);
+    static void bindSampler(GLuint unit, GLuint sampler);
+
+    static void setEnabled(GLCap cap, bool enabled);
+    static void setBlendEquation(GLenum rgb, GLenum alpha);
+    static void setBlendFunc(GLenum srcRgb, GLenum dstRgb, GLenum srcAlpha, GLenum dstAlpha);
+    static void setDepthFunc(GLenum func);
+    static void setDepthMask(GLboolean mask);
+    static void setCullFace(GLenum face);
+    static void setPolygonMode(GLenum mode);
+    static void setViewport(GLint x, GLint y, GLsizei width, GLsizei height);
+    static void setScissor(GLint x, GLint y, GLsizei width, GLsizei height);
+
+    static auto snapshot() -> const GLStateSnapshot&;
+    /* Issues only what differs from the current shadow */
+    static void restore(const GLStateSnapshot& state);
+
+    /* Deleting a bound object reverts its bindings to 0, the shadow has to follow or a reused name would be skipped.
+       Called by GLDeletionQueue, and needed after any direct glDelete*. Programs stay current until replaced. */
+    static void forgetVertexArray(GLuint vertexArray);
+    static void forgetBuffer(GLuint buffer);
+    static void forgetTexture(GLuint texture);
+
+    /* Call once per frame. stats() then reports the frame that just ended. */
+    static void endFrame();
+    static auto stats() -> const GLStateStats&;
+
+private:
+    static auto bufferSlot(GLenum target) -> int;
+    static auto indexedBindings(GLenum target) -> std::array<GLIndexedBinding, GLStateSnapshot::MaxIndexedBindings>*;
+    /* How many of the snapshot's bindings for `target` the context actually has */
+    static auto indexedBindingCount(GLenum target) -> GLuint;
+    static auto capEnum(GLCap cap) -> GLenum;
+
+    /* Updates the shadow, true if the GL call has to be made */
+    template <typename T>
+    static auto update(T& shadow, const T& value) -> bool;
+    static void passThrough();
+
+private:
+    inline static GLStateSnapshot m_state;
+    inline static GLuint m_uniformBindingCount = GLStateSnapshot::MaxIndexedBindings;
+    inline static GLuint m_storageBindingCount = GLStateSnapshot::MaxIndexedBindings;
+    inline static bool m_parameterBuffer = true;
+    inline static GLStateStats m_frame;
+    inline static GLStateStats m_lastFrame;
+};
+
+inline constexpr std::array<GLenum, GLStateSnapshot::BufferTargetCount> GLStateBufferTargets = {
+    GL_ARRAY_BUFFER,      GL_DRAW_INDIRECT_BUFFER, GL_DISPATCH_INDIRECT_BUFFER, GL_PARAMETER_BUFFER, GL_UNIFORM_BUFFER,
+    GL_SHADER_STORAGE_BUFFER, GL_COPY_READ_BUFFER,  GL_COPY_WRITE_BUFFER,        GL_PIXEL_PACK_BUFFER, GL_PIXEL_UNPACK_BUFFER,
+};
+
+inline void GLState::init()
+{
+    auto getUint = [](const GLenum name, const GLuint index = ~0u) {
+        GLint value = 0;
+        if (index == ~0u)
+            glGetIntegerv(name, &value);
+        else
+            glGetIntegeri_v(name, index, &value);
+        return static_cast<GLuint>(value);
+    };
+
+    static constexpr std::array<GLenum, GLStateSnapshot::BufferTargetCount> BindingQueries = {
+        GL_ARRAY_BUFFER_BINDING,      GL_DRAW_INDIRECT_BUFFER_BINDING, GL_DISPATCH_INDIRECT_BUFFER_BINDING, GL_PARAMETER_BUFFER_BINDING,
+        GL_UNIFORM_BUFFER_BINDING,    GL_SHADER_STORAGE_BUFFER_BINDING, GL_COPY_READ_BUFFER_BINDING,        GL_COPY_WRITE_BUFFER_BINDING,
+        GL_PIXEL_PACK_BUFFER_BINDING, GL_PIXEL_UNPACK_BUFFER_BINDING,
+    };
+
+    // Querying past the context's limits is GL_INVALID_VALUE, and the parameter buffer target doesn't exist before 4.6
+    m_uniformBindingCount = std::min(getUint(GL_MAX_UNIFORM_BUFFER_BINDINGS), GLStateSnapshot::MaxIndexedBindings);
+    m_storageBindingCount = std::min(getUint(GL_MAX_SHADER_STORAGE_BUFFER_BINDINGS), GLStateSnapshot::MaxIndexedBindings);
+    m_parameterBuffer = GLAD_GL_VERSION_4_6 != 0;
+    GLint extensionCount = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+    for (GLint i = 0; i < extensionCount && !m_parameterBuffer; ++i)
+        m_parameterBuffer = std::string_view(reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i))) == "GL_ARB_indirect_parameters";
+
+    auto& state = m_state;
+    state = {};
+    state.program = getUint(GL_CURRENT_PROGRAM);
+    state.vertexArray = getUint(GL_VERTEX_ARRAY_BINDING);
+    for (std::uint32_t i = 0; i < GLStateSnapshot::BufferTargetCount; ++i)
+        state.buffers[i] = bufferSlot(GLStateBufferTargets[i]) >= 0 ? getUint(BindingQueries[i]) : 0;
+
+    for (GLuint i = 0; i < m_uniformBindingCount; ++i)
+    {
+        GLint64 offset = 0, size = 0;
+        glGetInteger64i_v(GL_UNIFORM_BUFFER_START, i, &offset);
+        glGetInteger64i_v(GL_UNIFORM_BUFFER_SIZE, i, &size);
+        state.uniformBuffers[i] = { getUint(GL_UNIFORM_BUFFER_BINDING, i), static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size) };
+    }
+    for (GLuint i = 0; i < m_storageBindingCount; ++i)
+    {
+        GLint64 offset = 0, size = 0;
+        glGetInteger64i_v(GL_SHADER_STORAGE_BUFFER_START, i, &offset);
+        glGetInteger64i_v(GL_SHADER_STORAGE_BUFFER_SIZE, i, &size);
+        state.storageBuffers[i] = { getUint(GL_SHADER_STORAGE_BUFFER_BINDING, i), static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size) };
+    }
+
+    // Texture units can hold a texture per target, glBindTextureUnit(unit, 0) clears them all. Treat a unit as empty
+    // only when nothing is bound to the common targets.
+    const auto activeTexture = getUint(GL_ACTIVE_TEXTURE);
+    for (GLuint unit = 0; unit < GLStateSnapshot::MaxTextureUnits; ++unit)
+    {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        GLuint texture = getUint(GL_TEXTURE_BINDING_2D);
+        for (const auto binding : { GL_TEXTURE_BINDING_2D_ARRAY, GL_TEXTURE_BINDING_3D, GL_TEXTURE_BINDING_CUBE_MAP })
+            texture = texture != 0 ? texture : getUint(binding);
+        state.textures[unit] = texture;
+        state.samplers[unit] = getUint(GL_SAMPLER_BINDING);
+    }
+    glActiveTexture(activeTexture);
+
+    state.caps = 0;
+    for (std::uint8_t cap = 0; cap < static_cast<std::uint8_t>(GLCap::Count); ++cap)
+    {
+        if (glIsEnabled(capEnum(static_cast<GLCap>(cap))))
+            state.caps |= 1u << cap;
+    }
+
+    state.blend = {
+        getUint(GL_BLEND_EQUATION_RGB), getUint(GL_BLEND_EQUATION_ALPHA), getUint(GL_BLEND_SRC_RGB),
+        getUint(GL_BLEND_DST_RGB),      getUint(GL_BLEND_SRC_ALPHA),      getUint(GL_BLEND_DST_ALPHA),
+    };
+    state.depthFunc = getUint(GL_DEPTH_FUNC);
+    state.depthMask = static_cast<GLboolean>(getUint(GL_DEPTH_WRITEMASK));
+    state.cullFace = getUint(GL_CULL_FACE_MODE);
+
+    GLint polygonMode[2] = { GL_FILL, GL_FILL };
+    glGetIntegerv(GL_POLYGON_MODE, polygonMode);
+    state.polygonMode = static_cast<GLenum>(polygonMode[0]);
+
+    GLint rect[4] = {};
+    glGetIntegerv(GL_VIEWPORT, rect);
+    state.viewport = { rect[0], rect[1], rect[2], rect[3] };
+    glGetIntegerv(GL_SCISSOR_BOX, rect);
+    state.scissor = { rect[0], rect[1], rect[2], rect[3] };
+}
+
+inline void GLState::useProgram(const GLuint program)
+{
+    if (update(m_state.program, program))
+        glUseProgram(program);
+}
+
+inline void GLState::bindVertexArray(const GLuint vertexArray)
+{
+    if (update(m_state.vertexArray, vertexArray))
+        glBindVertexArray(vertexArray);
+}
+
+inline void GLState::bindBuffer(const GLenum target, const GLuint buffer)
+{
+    const auto slot = bufferSlot(target);
+    if (slot < 0)
+    {
+        passThrough();
+        glBindBuffer(target, buffer);
+    }
+    else if (update(m_state.buffers[slot], buffer))
+    {
+        glBindBuffer(target, buffer);
+    }
+}
+
+inline void GLState::bindBufferBase(const GLenum target, const GLuint index, const GLuint buffer)
+{
+    bindBufferRange(target, index, buffer, 0, 0);
+}
+
+inline void GLState::bindBufferRange(const GLenum target, const GLuint index, const GLuint buffer, const GLintptr offset, const GLsizeiptr size)
+{
+    auto* bindings = indexedBindings(target);
+    if (bindings == nullptr || index >= indexedBindingCount(target))
+        passThrough();
+    else if (!update((*bindings)[index], { buffer, offset, size }))
+        return;
+
+    // Both also replace the generic binding
+    if (const auto slot = bufferSlot(target); slot >= 0)
+        m_state.buffers[slot] = buffer;
+
+    if (size == 0)
+        glBindBufferBase(target, index, buffer);
+    else
+        glBindBufferRange(target, index, buffer, offset, size);
+}
+
+inline void GLState::bindTexture(const GLuint unit, const GLuint texture)
+{
+    if (unit >= GLStateSnapshot::MaxTextureUnits)
+        passThrough();
+    else if (!update(m_state.textures[unit], texture))
+        return;
+    glBindTextureUnit(unit, texture);
+}
+
+inline void GLState::bindSampler(const GLuint unit, const GLuint sampler)
+{
+    if (unit >= GLStateSnapshot::MaxTextureUnits)
+        passThrough();
+    else if (!update(m_state.samplers[unit], sampler))
+        return;
+    glBindSampler(unit, sampler);
+}
+
+inline void GLState::setEnabled(const GLCap cap, const bool enabled)
+{
+    const auto bit = 1u << static_cast<std::uint32_t>(cap);
+    if (!update(m_state.caps, enabled ? m_state.caps | bit : m_state.caps & ~bit))
+        return;
+
+    if (enabled)
+        glEnable(capEnum(cap));
+    else
+        glDisable(capEnum(cap));
+}
+
+inline void GLState::setBlendEquation(const GLenum rgb, const GLenum alpha)
+{
+    auto blend = m_state.blend;
+    blend.equationRgb = rgb;
+    blend.equationAlpha = alpha;
+    if (update(m_state.blend, blend))
+        glBlendEquationSeparate(rgb, alpha);
+}
+
+inline void GLState::setBlendFunc(const GLenum srcRgb, const GLenum dstRgb, const GLenum srcAlpha, const GLenum dstAlpha)
+{
+    auto blend = m_state.blend;
+    blend.srcRgb = srcRgb;
+    blend.dstRgb = dstRgb;
+    blend.srcAlpha = srcAlpha;
+    blend.dstAlpha = dstAlpha;
+    if (update(m_state.blend, blend))
+        glBlendFuncSeparate(srcRgb, dstRgb, srcAlpha, dstAlpha);
+}
+
+inline void GLState::setDepthFunc(const GLenum func)
+{
+    if (update(m_state.depthFunc, func))
+        glDepthFunc(func);
+}
+
+inline void GLState::setDepthMask(const GLboolean mask)
+{
+    if (update(m_state.depthMask, mask))
+        glDepthMask(mask);
+}
+
+inline void GLState::setCullFace(const GLenum face)
+{
+    if (update(m_state.cullFace, face))
+        glCullFace(face);
+}
+
+inline void GLState::setPolygonMode(const GLenum mode)
+{
+    if (update(m_state.polygonMode, mode))
+        glPolygonMode(GL_FRONT_AND_BACK, mode);
+}
+
+inline void GLState::setViewport(const GLint x, const GLint y, const GLsizei width, const GLsizei height)
+{
+    if (update(m_state.viewport, { x, y, width, height }))
+        glViewport(x, y, width, height);
+}
+
+inline void GLState::setScissor(const GLint x, const GLint y, const GLsizei width, const GLsizei height)
+{
+    if (update(m_state.scissor, { x, y, width, height }))
+        glScissor(x, y, width, height);
+}
+
+inline auto GLState::snapshot() -> const GLStateSnapshot&
+{
+    return m_state;
+}
+
+inline void GLState::restore(const GLStateSnapshot& state)
+{
+    // Only count what actually changes, otherwise every tracked binding would show up as a skipped call
+    const auto skipped = m_frame.skipped;
+
+    useProgram(state.program);
+    bindVertexArray(state.vertexArray);
+    for (std::uint32_t i = 0; i < GLStateSnapshot::BufferTargetCount; ++i)
+    {
+        if (bufferSlot(GLStateBufferTargets[i]) >= 0)
+            bindBuffer(GLStateBufferTargets[i], state.buffers[i]);
+    }
+
+    for (GLuint i = 0; i < m_uniformBindingCount; ++i)
+    {
+        const auto& uniform = state.uniformBuffers[i];
+        bindBufferRange(GL_UNIFORM_BUFFER, i, uniform.buffer, uniform.offset, uniform.size);
+    }
+    for (GLuint i = 0; i < m_storageBindingCount; ++i)
+    {
+        const auto& storage = state.storageBuffers[i];
+        bindBufferRange(GL_SHADER_STORAGE_BUFFER, i, storage.buffer, storage.offset, storage.size);
+    }
+
+    for (GLuint unit = 0; unit < GLStateSnapshot::MaxTextureUnits; ++unit)
+    {
+        bindTexture(unit, state.textures[unit]);
+        bindSampler(unit, state.samplers[unit]);
+    }
+
+    for (std::uint8_t cap = 0; cap < static_cast<std::uint8_t>(GLCap::Count); ++cap)
+        setEnabled(static_cast<GLCap>(cap), (state.caps >> cap) & 1u);
+
+    setBlendEquation(state.blend.equationRgb, state.blend.equationAlpha);
+    setBlendFunc(state.blend.srcRgb, state.blend.dstRgb, state.blend.srcAlpha, state.blend.dstAlpha);
+    setDepthFunc(state.depthFunc);
+    setDepthMask(state.depthMask);
+    setCullFace(state.cullFace);
+    setPolygonMode(state.polygonMode);
+    setViewport(state.viewport.x, state.viewport.y, state.viewport.width, state.viewport.height);
+    setScissor(state.scissor.x, state.scissor.y, state.scissor.width, state.scissor.height);
+
+    m_frame.skipped = skipped;
+}
+
+inline void GLState::forgetVertexArray(const GLuint vertexArray)
+{
+    if (m_state.vertexArray == vertexArray)
+        m_state.vertexArray = 0;
+}
+
+inline void GLState::forgetBuffer(const GLuint buffer)
+{
+    for (auto& bound : m_state.buffers)
+    {
+        if (bound == buffer)
+            bound = 0;
+    }
+    for (auto* bindings : { &m_state.uniformBuffers, &m_state.storageBuffers })
+    {
+        for (auto& binding : *bindings)
+        {
+            if (binding.buffer == buffer)
+                binding = {};
+        }
+    }
+}
+
+inline void GLState::forgetTexture(const GLuint texture)
+{
+    for (auto& bound : m_state.textures)
+    {
+        if (bound == texture)
+            bound = 0;
+    }
+}
+
+inline void GLState::endFrame()
+{
+    m_lastFrame = m_frame;
+    m_frame = {};
+}
+
+inline auto GLState::stats() -> const GLStateStats&
+{
+    return m_lastFrame;
+}
+
+inline auto GLState::bufferSlot(const GLenum target) -> int
+{
+    if (target == GL_PARAMETER_BUFFER && !m_parameterBuffer)
+        return -1;
+
+    for (std::uint32_t i = 0; i < GLStateSnapshot::BufferTargetCount; ++i)
+    {
+        if (GLStateBufferTargets[i] == target)
+            return static_cast<int>(i);
+    }
+    return -1;
+}
+
+inline auto GLState::indexedBindings(const GLenum target) -> std::array<GLIndexedBinding, GLStateSnapshot::MaxIndexedBindings>*
+{
+    switch (target)
+    {
+    case GL_UNIFORM_BUFFER:
+        return &m_state.uniformBuffers;
+    case GL_SHADER_STORAGE_BUFFER:
+        return &m_state.storageBuffers;
+    default:
+        return nullptr;
+    }
+}
+
+inline auto GLState::indexedBindingCount(const GLenum target) -> GLuint
+{
+    switch (target)
+    {
+    case GL_UNIFORM_BUFFER:
+        return m_uniformBindingCount;
+    case GL_SHADER_STORAGE_BUFFER:
+        return m_storageBindingCount;
+    default:
+        return 0;
+    }
+}
+
+inline auto GLState::capEnum(const GLCap cap) -> GLenum
+{
+    switch (cap)
+    {
+    case GLCap::Blend:
+        return GL_BLEND;
+    case GLCap::CullFace:
+        return GL_CULL_FACE;
+    case GLCap::DepthTest:
+        return GL_DEPTH_TEST;
+    case GLCap::StencilTest:
+        return GL_STENCIL_TEST;
+    case GLCap::ScissorTest:
+        return GL_SCISSOR_TEST;
+    case GLCap::PrimitiveRestart:
+    default:
+        return GL_PRIMITIVE_RESTART;
+    }
+}
+
+template <typename T>
+auto GLState::update(T& shadow, const T& value) -> bool
+{
+    if (shadow == value)
+    {
+        ++m_frame.skipped;
+        return false;
+    }
+
+    shadow = value;
+    ++m_frame.issued;
+    return true;
+}
+
+inline void GLState::passThrough()
+{
+    ++m_frame.issued;
+}
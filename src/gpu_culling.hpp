@@ -0,0 +1,276 @@
+#pragma once
+
+#include "draw_batch.hpp"
+#include "frustum.hpp"
+#include "gl_handle.hpp"
+#include "gl_state.hpp"
+#include "index_type.hpp"
+#include "occlusion_buffer.hpp"
+#include "shader.hpp"
+
+#include <glad/glad.h>
+#include <glm/ext/matrix_float4x4.hpp>
+#include <glm/ext/vector_float4.hpp>
+
+#include <cassert>
+#include <cstdint>
+
+// Mirrors `Instance` in GPU_CULL_COMPUTE_SRC (std430)
+struct GpuCullInstance
+{
+    glm::vec4 sphere = {}; // Centre, radius
+    GLuint indexCount = 0;
+    GLuint firstIndex = 0;
+    GLint baseVertex = 0;
+    GLuint instanceCount = 1;
+};
+
+static_assert(sizeof(GpuCullInstance) == 32);
+static_assert(sizeof(DrawElementsIndirectCommand) == 20);
+
+// Frustum (and optionally hierarchical-Z) tests one instance per invocation and appends a command for each survivor.
+// baseInstance is set to the instance index, the same convention as DrawBatch, so per-instance data can be fetched with gl_BaseInstance.
+inline const char* const GPU_CULL_COMPUTE_SRC = R"(
+#version 430 core
+layout (local_size_x = 64) in;
+
+struct Instance
+{
+    vec4 sphere;
+    uint indexCount;
+    uint firstIndex;
+    int baseVertex;
+    uint instanceCount;
+};
+
+struct Command
+{
+    uint count;
+    uint instanceCount;
+    uint firstIndex;
+    int baseVertex;
+    uint baseInstance;
+};
+
+layout (std430, binding = 0) readonly buffer Instances { Instance instances[]; };
+layout (std430, binding = 1) writeonly buffer Commands { Command commands[]; };
+layout (std430, binding = 2) buffer DrawCount { uint drawCount; };
+
+uniform uint instanceCount;
+uniform vec4 frustumPlanes[6];
+
+uniform bool occlusionEnabled;
+uniform mat4 occlusionViewProjection;
+layout (binding = 0) uniform sampler2D depthPyramid;
+
+// Same test as OcclusionBuffer::isVisible, on the sphere's bounding box
+bool isOccluded(vec3 centre, float radius)
+{
+    vec3 boxMin = centre - radius, boxMax = centre + radius;
+    vec3 screenMin = vec3(1e30), screenMax = vec3(-1e30);
+    for (int i = 0; i < 8; ++i)
+    {
+        vec3 p = vec3((i & 1) != 0 ? boxMax.x : boxMin.x, (i & 2) != 0 ? boxMax.y : boxMin.y, (i & 4) != 0 ? boxMax.z : boxMin.z);
+        vec4 clip = occlusionViewProjection * vec4(p, 1.0);
+        if (clip.z < -clip.w || clip.w <= 0.0)
+            return false;
+
+        vec3 ndc = clip.xyz / clip.w;
+        screenMin = min(screenMin, ndc);
+        screenMax = max(screenMax, ndc);
+    }
+
+    ivec2 size = textureSize(depthPyramid, 0);
+    ivec2 rectMin = clamp(ivec2(floor((screenMin.xy * 0.5 + 0.5) * vec2(size))), ivec2(0), size - 1);
+    ivec2 rectMax = clamp(ivec2(floor((screenMax.xy * 0.5 + 0.5) * vec2(size))), ivec2(0), size - 1);
+
+    int level = 0;
+    int maxLevel = textureQueryLevels(depthPyramid) - 1;
+    while (level < maxLevel && any(greaterThan((rectMax >> level) - (rectMin >> level), ivec2(1))))
+        ++level;
+
+    float farthest = 0.0;
+    for (int y = rectMin.y >> level; y <= (rectMax.y >> level); ++y)
+    {
+        for (int x = rectMin.x >> level; x <= (rectMax.x >> level); ++x)
+            farthest = max(farthest, texelFetch(depthPyramid, ivec2(x, y), level).r);
+    }
+
+    return screenMin.z * 0.5 + 0.5 > farthest;
+}
+
+void main()
+{
+    uint index = gl_GlobalInvocationID.x;
+    if (index >= instanceCount)
+        return;
+
+    Instance instance = instances[index];
+    vec3 centre = instance.sphere.xyz;
+    float radius = instance.sphere.w;
+
+    for (int i = 0; i < 6; ++i)
+    {
+        if (dot(frustumPlanes[i].xyz, centre) + frustumPlanes[i].w < -radius)
+            return;
+    }
+
+    if (occlusionEnabled && isOccluded(centre, radius))
+        return;
+
+    uint slot = atomicAdd(drawCount, 1u);
+    commands[slot] = Command(instance.indexCount, instance.instanceCount, instance.firstIndex, instance.baseVertex, index);
+}
+)";
+
+// GPU driven culling. cull() runs the compute pass and leaves a compacted command buffer and draw count on the GPU,
+// draw() consumes them with glMultiDrawElementsIndirectCount without any readback.
+// Without GL 4.6 the unused tail of the command buffer is zeroed instead, and every slot is drawn with glMultiDrawElementsIndirect.
+class GpuCuller
+{
+public:
+    static constexpr GLuint WorkGroupSize = 64;
+
+    void init(std::uint32_t maxInstances);
+
+    void setInstances(const GpuCullInstance* instances, std::uint32_t count);
+
+    /* Uploads the CPU depth hierarchy for the occlusion test. Its dimensions must be powers of two. */
+    void setOcclusion(const OcclusionBuffer& occlusion, const glm::mat4& viewProjection);
+    void disableOcclusion();
+
+    void cull(const Frustum& frustum);
+
+    /* The VAO holding the geometry and the program must already be bound */
+    template <typename Index>
+    void draw(GLenum topology) const;
+
+    auto commandBuffer() const -> GLuint;
+    auto countBuffer() const -> GLuint;
+
+    /* Stalls until the GPU has finished culling. Debugging only. */
+    auto readDrawCount() const -> std::uint32_t;
+
+private:
+    Shader m_shader;
+    GLBuffer m_instances, m_commands, m_drawCount;
+    std::uint32_t m_maxInstances = 0, m_instanceCount = 0;
+
+    GLTexture m_depthPyramid;
+    std::uint32_t m_depthWidth = 0, m_depthHeight = 0;
+    glm::mat4 m_occlusionViewProjection = glm::mat4(1.0f);
+    bool m_occlusion = false;
+};
+
+inline void GpuCuller::init(const std::uint32_t maxInstances)
+{
+    m_maxInstances = maxInstances;
+    m_shader.initCompute(GPU_CULL_COMPUTE_SRC);
+
+    m_instances = GLBuffer::create();
+    glNamedBufferStorage(m_instances.id(), maxInstances * sizeof(GpuCullInstance), nullptr, GL_DYNAMIC_STORAGE_BIT);
+    m_commands = GLBuffer::create();
+    glNamedBufferStorage(m_commands.id(), maxInstances * sizeof(DrawElementsIndirectCommand), nullptr, GL_DYNAMIC_STORAGE_BIT);
+    m_drawCount = GLBuffer::create();
+    glNamedBufferStorage(m_drawCount.id(), sizeof(GLuint), nullptr, GL_DYNAMIC_STORAGE_BIT);
+}
+
+inline void GpuCuller::setInstances(const GpuCullInstance* instances, const std::uint32_t count)
+{
+    assert(count <= m_maxInstances && "GpuCuller is full!");
+
+    m_instanceCount = count;
+    glNamedBufferSubData(m_instances.id(), 0, count * sizeof(GpuCullInstance), instances);
+}
+
+inline void GpuCuller::setOcclusion(const OcclusionBuffer& occlusion, const glm::mat4& viewProjection)
+{
+    const auto width = occlusion.width(), height = occlusion.height();
+    assert((width & (width - 1)) == 0 && (height & (height - 1)) == 0 && "GL mip sizes only match OcclusionBuffer's for powers of two!");
+
+    if (width != m_depthWidth || height != m_depthHeight)
+    {
+        m_depthPyramid = GLTexture::create(GL_TEXTURE_2D);
+        glTextureStorage2D(m_depthPyramid.id(), static_cast<GLsizei>(occlusion.levelCount()), GL_R32F, width, height);
+        m_depthWidth = width;
+        m_depthHeight = height;
+    }
+
+    for (std::uint32_t level = 0; level < occlusion.levelCount(); ++level)
+    {
+        const auto levelWidth = std::max(1u, width >> level), levelHeight = std::max(1u, height >> level);
+        glTextureSubImage2D(m_depthPyramid.id(), level, 0, 0, levelWidth, levelHeight, GL_RED, GL_FLOAT, occlusion.depth(level).data());
+    }
+
+    m_occlusionViewProjection = viewProjection;
+    m_occlusion = true;
+}
+
+inline void GpuCuller::disableOcclusion()
+{
+    m_occlusion = false;
+}
+
+inline void GpuCuller::cull(const Frustum& frustum)
+{
+    const GLuint zero = 0;
+    glClearNamedBufferData(m_drawCount.id(), GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+    if (glMultiDrawElementsIndirectCount == nullptr)
+        glClearNamedBufferData(m_commands.id(), GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+
+    if (m_instanceCount == 0)
+        return;
+
+    m_shader.setUint("instanceCount", m_instanceCount);
+    m_shader.set(m_shader.uniform<glm::vec4>("frustumPlanes"), frustum.planes.data(), static_cast<GLsizei>(frustum.planes.size()));
+
+    m_shader.setInt("occlusionEnabled", m_occlusion);
+    if (m_occlusion)
+    {
+        m_shader.setMat4("occlusionViewProjection", m_occlusionViewProjection);
+        GLState::bindTexture(0, m_depthPyramid.id());
+    }
+
+    GLState::bindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_instances.id());
+    GLState::bindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_commands.id());
+    GLState::bindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, m_drawCount.id());
+    m_shader.dispatch((m_instanceCount + WorkGroupSize - 1) / WorkGroupSize);
+
+    // Both the commands and the count are consumed by the indirect draw
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+}
+
+template <typename Index>
+void GpuCuller::draw(const GLenum topology) const
+{
+    if (m_instanceCount == 0)
+        return;
+
+    GLState::bindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commands.id());
+    if (glMultiDrawElementsIndirectCount != nullptr)
+    {
+        GLState::bindBuffer(GL_PARAMETER_BUFFER, m_drawCount.id());
+        glMultiDrawElementsIndirectCount(topology, IndexTraits<Index>::glType, nullptr, 0, static_cast<GLsizei>(m_instanceCount), 0);
+    }
+    else
+    {
+        glMultiDrawElementsIndirect(topology, IndexTraits<Index>::glType, nullptr, static_cast<GLsizei>(m_instanceCount), 0);
+    }
+}
+
+inline auto GpuCuller::commandBuffer() const -> GLuint
+{
+    return m_commands.id();
+}
+
+inline auto GpuCuller::countBuffer() const -> GLuint
+{
+    return m_drawCount.id();
+}
+
+inline auto GpuCuller::readDrawCount() const -> std::uint32_t
+{
+    GLuint count = 0;
+    glGetNamedBufferSubData(m_drawCount.id(), 0, sizeof(count), &count);
+    return count;
+}
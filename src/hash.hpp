@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// FNV-1a, usable at compile time for string literals and integral values.
+constexpr std::uint64_t Fnv1aOffset64 = 14695981039346656037ull;
+constexpr std::uint64_t Fnv1aPrime64 = 1099511628211ull;
+
+constexpr auto fnv1a64(const std::string_view str, std::uint64_t hash = Fnv1aOffset64) -> std::uint64_t
+{
+    for (const auto c : str)
+    {
+        hash ^= static_cast<std::uint8_t>(c);
+        hash *= Fnv1aPrime64;
+    }
+    return hash;
+}
+
+constexpr auto fnv1a64(const std::uint64_t value, std::uint64_t hash = Fnv1aOffset64) -> std::uint64_t
+{
+    for (std::size_t i = 0; i < sizeof(value); ++i)
+    {
+        hash ^= (value >> (i * 8)) & 0xFF;
+        hash *= Fnv1aPrime64;
+    }
+    return hash;
+}
+
+inline auto fnv1a64(const void* data, const std::size_t size, std::uint64_t hash = Fnv1aOffset64) -> std::uint64_t
+{
+    const auto* bytes = static_cast<const std::uint8_t*>(data);
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= Fnv1aPrime64;
+    }
+    return hash;
+}
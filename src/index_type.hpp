@@ -0,0 +1,180 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+template <typename Index>
+struct IndexTraits
+{
+    static_assert(sizeof(Index) == 0, "Unsupported index type. Use std::uint8_t, std::uint16_t or std::uint32_t.");
+};
+
+template <>
+struct IndexTraits<std::uint8_t>
+{
+    static constexpr GLenum glType = GL_UNSIGNED_BYTE;
+};
+
+template <>
+struct IndexTraits<std::uint16_t>
+{
+    static constexpr GLenum glType = GL_UNSIGNED_SHORT;
+};
+
+template <>
+struct IndexTraits<std::uint32_t>
+{
+    static constexpr GLenum glType = GL_UNSIGNED_INT;
+};
+
+// A 16-bit addressable piece of a larger mesh. `vertexRemap` maps chunk-local vertices back to the source vertex buffer.
+struct IndexChunk16
+{
+    std::vector<std::uint32_t> vertexRemap;
+    std::vector<std::uint16_t> indices;
+};
+
+struct IndexNarrowingReport
+{
+    std::size_t originalBytes = 0;
+    std::size_t narrowedBytes = 0;
+    std::size_t duplicatedVertices = 0;
+    std::size_t chunkCount = 0;
+
+    auto bytesSaved() const -> std::ptrdiff_t
+    {
+        return static_cast<std::ptrdiff_t>(originalBytes) - static_cast<std::ptrdiff_t>(narrowedBytes);
+    }
+};
+
+/* Returns true and fills `out` if every index fits in 16 bits. Indices past `vertexCount` are rejected. */
+inline bool narrowIndices(const std::uint32_t* indices, const std::size_t count, const std::size_t vertexCount, std::vector<std::uint16_t>& out)
+{
+    if (vertexCount > std::numeric_limits<std::uint16_t>::max() + std::size_t(1))
+        return false;
+
+    out.resize(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        if (indices[i] >= vertexCount)
+        {
+            out.clear();
+            return false;
+        }
+        out[i] = static_cast<std::uint16_t>(indices[i]);
+    }
+
+    return true;
+}
+
+/* Splits a triangle list into chunks that each reference at most 65536 unique vertices. Returns no chunks if an index is past `vertexCount`. */
+inline auto splitIndices16(const std::uint32_t* indices, const std::size_t count, const std::size_t vertexCount) -> std::vector<IndexChunk16>
+{
+    constexpr std::size_t MaxChunkVertices = std::numeric_limits<std::uint16_t>::max() + std::size_t(1);
+    constexpr std::uint32_t Unmapped = ~0u;
+
+    std::vector<IndexChunk16> chunks;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        if (indices[i] >= vertexCount)
+        {
+            std::cerr << "[IndexType] Index " << indices[i] << " at " << i << " is out of range for " << vertexCount << " vertices" << std::endl;
+            return chunks;
+        }
+    }
+
+    std::vector<std::uint32_t> localIndex(vertexCount, Unmapped);
+
+    chunks.emplace_back();
+    for (std::size_t tri = 0; tri + 2 < count; tri += 3)
+    {
+        auto* chunk = &chunks.back();
+
+        std::size_t newVertices = 0;
+        for (std::size_t i = 0; i < 3; ++i)
+        {
+            if (localIndex[indices[tri + i]] == Unmapped)
+                ++newVertices;
+        }
+
+        if (chunk->vertexRemap.size() + newVertices > MaxChunkVertices)
+        {
+            for (auto source : chunk->vertexRemap)
+                localIndex[source] = Unmapped;
+
+            chunk = &chunks.emplace_back();
+        }
+
+        for (std::size_t i = 0; i < 3; ++i)
+        {
+            const auto source = indices[tri + i];
+            if (localIndex[source] == Unmapped)
+            {
+                localIndex[source] = static_cast<std::uint32_t>(chunk->vertexRemap.size());
+                chunk->vertexRemap.push_back(source);
+            }
+            chunk->indices.push_back(static_cast<std::uint16_t>(localIndex[source]));
+        }
+    }
+
+    return chunks;
+}
+
+/* Narrows to 16-bit indices if possible, otherwise splits into 16-bit addressable chunks */
+inline auto narrowOrSplitIndices(const std::uint32_t* indices, const std::size_t count, const std::size_t vertexCount, const std::size_t vertexStride,
+                                 std::vector<IndexChunk16>& chunks) -> IndexNarrowingReport
+{
+    IndexNarrowingReport report;
+    report.originalBytes = count * sizeof(std::uint32_t);
+
+    chunks.clear();
+    auto& whole = chunks.emplace_back();
+    if (narrowIndices(indices, count, vertexCount, whole.indices))
+    {
+        whole.vertexRemap.resize(vertexCount);
+        for (std::size_t i = 0; i < vertexCount; ++i)
+            whole.vertexRemap[i] = static_cast<std::uint32_t>(i);
+    }
+    else
+    {
+        chunks = splitIndices16(indices, count, vertexCount);
+
+        // Bad indices, keep the original buffer and report nothing saved
+        if (chunks.empty())
+        {
+            report.narrowedBytes = report.originalBytes;
+            return report;
+        }
+    }
+
+    std::size_t chunkVertices = 0;
+    for (const auto& chunk : chunks)
+    {
+        report.narrowedBytes += chunk.indices.size() * sizeof(std::uint16_t);
+        chunkVertices += chunk.vertexRemap.size();
+    }
+
+    // Vertices shared across chunk boundaries have to be duplicated, which eats into the saving
+    report.duplicatedVertices = chunkVertices > vertexCount ? chunkVertices - vertexCount : 0;
+    report.narrowedBytes += report.duplicatedVertices * vertexStride;
+    report.chunkCount = chunks.size();
+
+    return report;
+}
+
+/* Builds a chunk's vertex buffer from the source vertices */
+inline auto gatherVertices(const void* vertices, const std::size_t vertexStride, const IndexChunk16& chunk) -> std::vector<std::uint8_t>
+{
+    std::vector<std::uint8_t> out(chunk.vertexRemap.size() * vertexStride);
+
+    const auto* src = static_cast<const std::uint8_t*>(vertices);
+    for (std::size_t i = 0; i < chunk.vertexRemap.size(); ++i)
+        std::memcpy(out.data() + i * vertexStride, src + chunk.vertexRemap[i] * vertexStride, vertexStride);
+
+    return out;
+}
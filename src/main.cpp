@@ -1,6 +1,9 @@
+#include "file_watcher.hpp"
+#include "gl_state.hpp"
 #include "input.hpp"
 #include "mesh.hpp"
-#include "shader.hpp"
+#include "render_queue.hpp"
+#include "shader_variants.hpp"
 #include "window.hpp"
 
 #include "imgui/imgui_impl_glfw.h"
@@ -20,33 +23,25 @@ void openglDebugCallback(GLenum source, GLenum type, GLuint id, GLenum severity,
     std::cout << "[OpenGL] type=" << type << ", severity=" << severity << ", msg=" << message << std::endl;
 }
 
-glm::vec3 vertices[] = {
-    { -0.5f, -0.5f, 0.0f },
-    { 0.5f, -0.5f, 0.0f },
-    { 0.5f, 0.5f, 0.0f },
+struct PositionVertex
+{
+    glm::vec3 pos = {};
 };
 
-int indices[] = { 0, 1, 2 };
+VERTEX_LAYOUT(PositionVertex, VERTEX_ATTRIB(0, pos));
 
-const auto* VERTEX_SRC = R"(
-#version 330 core
-layout (location = 0) in vec3 aPos;
+PositionVertex vertices[] = {
+    { { -0.5f, -0.5f, 0.0f } },
+    { { 0.5f, -0.5f, 0.0f } },
+    { { 0.5f, 0.5f, 0.0f } },
+};
 
-void main()
-{
-    gl_Position = vec4(aPos.x, aPos.y, aPos.z, 1.0);
-}
-)";
+std::uint32_t indices[] = { 0, 1, 2 };
 
-const auto* FRAGMENT_SRC = R"(
-#version 330 core
-out vec4 FragColor;
-
-void main()
-{
-    FragColor = vec4(1.0f, 0.5f, 0.2f, 1.0f);
-} 
-)";
+// Shaders are read from the source tree so edits are picked up while running
+#ifndef SHADER_DIR
+    #define SHADER_DIR "shaders"
+#endif
 
 #define WIN_WIDTH 1280
 #define WIN_HEIGHT 720
@@ -65,13 +60,18 @@ int run()
 
     Input::init(Window::get());
 
-    glViewport(0, 0, 1280, 720);
+    // Everything after this binds through GLState, including the ImGui backend
+    GLState::init();
+    GLState::setViewport(0, 0, WIN_WIDTH, WIN_HEIGHT);
 
     // OpenGL Debug Callback
     glEnable(GL_DEBUG_OUTPUT);
     glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
     glDebugMessageCallback(&openglDebugCallback, nullptr);
 
+    ProgramCache::init("shader_cache");
+    Shader::initParallelCompile((GLADloadproc)glfwGetProcAddress);
+
     /* Init ImGui */
     IMGUI_CHECKVERSION();
     ImGui::CreateContext();
@@ -88,59 +88,95 @@ int run()
     ImGui_ImplGlfw_InitForOpenGL(Window::get(), true);
     ImGui_ImplOpenGL3_Init("#version 330 core");
 
-    /* Vertex Input */
-    Mesh<int> triangleMesh;
-    triangleMesh.setVertices(vertices, sizeof(vertices));
-    triangleMesh.setIndices(indices, sizeof(indices));
-    triangleMesh.apply(GL_TRIANGLES, sizeof(glm::vec3), { { 0, 3, GL_FLOAT, GL_FALSE, 0 } });
+    // Everything owning GL objects lives in this scope, so it has all been queued for deletion before the final flush below
+    {
+        /* Vertex Input */
+        Mesh<std::uint32_t> triangleMesh;
+        triangleMesh.setVertices(vertices, sizeof(vertices));
+        triangleMesh.setIndices(indices, std::size(indices));
+        triangleMesh.apply<PositionVertex>(GL_TRIANGLES);
 
-    /* Pipeline */
-    Shader shader;
-    shader.init(VERTEX_SRC, FRAGMENT_SRC);
+        /* Pipeline */
+        ShaderPreprocessor shaderPreprocessor;
+        shaderPreprocessor.addIncludeDirectory(SHADER_DIR);
 
-    bool showDemo = false;
-    bool showDebug = true;
+        ShaderVariants triangleShader;
+        triangleShader.init(shaderPreprocessor, "triangle.vert", "triangle.frag");
 
-    glClearColor(0.3912f, 0.5843f, 0.9294f, 1.0f); // Cornflower Blue
+        FileWatcher shaderWatcher;
+        shaderWatcher.watch(SHADER_DIR);
 
-    double lastTime = glfwGetTime();
-    while (!Window::shouldClose())
-    {
-        auto time = glfwGetTime();
-        float deltaTime = time - lastTime;
-        lastTime = time;
+        RenderQueue<std::uint32_t> renderQueue;
 
-        glfwPollEvents();
+        // Builds finish asynchronously, so these keep updating over the first frames
+        const auto& programStats = ProgramCache::stats();
+        const auto& stateStats = GLState::stats();
+        const auto& queueStats = renderQueue.stats();
 
-        ImGui_ImplOpenGL3_NewFrame();
-        ImGui_ImplGlfw_NewFrame();
-        ImGui::NewFrame();
+        bool showDemo = false;
+        bool showDebug = true;
 
-        // Insert Update code here...
-        // Insert ImGui code here...
+        glClearColor(0.3912f, 0.5843f, 0.9294f, 1.0f); // Cornflower Blue
 
-        ImGui::ShowDemoWindow(&showDemo);
+        double lastTime = glfwGetTime();
+        while (!Window::shouldClose())
+        {
+            auto time = glfwGetTime();
+            float deltaTime = time - lastTime;
+            lastTime = time;
 
-        ImGui::Begin("Debug", &showDebug);
-        ImGui::Text("DeltaTime: %fs", deltaTime);
-        ImGui::Separator();
-        ImGui::End();
+            glfwPollEvents();
 
-        ImGui::Render();
+            ImGui_ImplOpenGL3_NewFrame();
+            ImGui_ImplGlfw_NewFrame();
+            ImGui::NewFrame();
 
-        glClear(GL_COLOR_BUFFER_BIT);
+            // Insert Update code here...
+            // Insert ImGui code here...
 
-        // Insert Rendering code here...
+            ImGui::ShowDemoWindow(&showDemo);
 
-        shader.bind();
-        triangleMesh.bind();
-        triangleMesh.draw();
+            ImGui::Begin("Debug", &showDebug);
+            ImGui::Text("DeltaTime: %fs", deltaTime);
+            ImGui::Text("Programs: %u cached (%.2fms), %u compiled (%.2fms)", programStats.loaded, programStats.loadMs, programStats.compiled,
+                        programStats.compileMs);
+            ImGui::Text("GL state: %llu calls issued, %llu skipped", static_cast<unsigned long long>(stateStats.issued),
+                        static_cast<unsigned long long>(stateStats.skipped));
+            ImGui::Text("Draws: %u (%u program, %u material, %u mesh changes)", queueStats.draws, queueStats.programChanges, queueStats.materialChanges,
+                        queueStats.meshChanges);
+            ImGui::Separator();
+            ImGui::End();
 
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+            ImGui::Render();
 
-        glfwSwapBuffers(Window::get());
+            glClear(GL_COLOR_BUFFER_BIT);
+
+            // Insert Rendering code here...
+
+            if (shaderWatcher.hasChanges())
+                triangleShader.reload(shaderPreprocessor, shaderWatcher.takeChanges());
+            triangleShader.update();
+
+            renderQueue.clear();
+
+            // Nothing to fall back to for a single triangle, it just appears once the program is ready
+            if (auto* shader = triangleShader.tryGet(0))
+                renderQueue.add(0, 0, Translucency::Opaque, *shader, 0, triangleMesh, 0.0f);
+
+            renderQueue.sort();
+            renderQueue.execute(nullptr);
+
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+
+            glfwSwapBuffers(Window::get());
+            GLDeletionQueue::endFrame();
+            GLState::endFrame();
+        }
     }
 
+    VertexArrayCache::shutdown();
+    GLDeletionQueue::flush();
+
     /* Shutdown ImGui */
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
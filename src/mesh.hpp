@@ -1,10 +1,21 @@
 #pragma once
 
+#include "gl_handle.hpp"
+#include "gl_state.hpp"
+#include "index_type.hpp"
+#include "stream_buffer.hpp"
+#include "vertex_layout.hpp"
+
 #include <glad/glad.h>
+#include <glm/ext/matrix_float4x4.hpp>
 #include <glm/ext/vector_float2.hpp>
 #include <glm/ext/vector_float3.hpp>
+#include <glm/ext/vector_float4.hpp>
 
-#include <vector>
+#include <cassert>
+#include <iostream>
+#include <span>
+#include <type_traits>
 
 struct Vertex
 {
@@ -13,81 +24,213 @@ struct Vertex
     glm::vec3 color = { 1, 0, 0 };
 };
 
-struct Attrib
+VERTEX_LAYOUT(Vertex, VERTEX_ATTRIB(0, pos), VERTEX_ATTRIB(1, texCoord), VERTEX_ATTRIB(2, color));
+
+// Default per-instance stream for Mesh::drawInstanced. Locations follow on from Vertex.
+struct InstanceData
 {
-    GLuint index = 0;
-    GLint size = 0;
-    GLenum type = 0;
-    GLboolean normalised = GL_FALSE;
-    GLuint offset = 0;
+    glm::mat4 transform = glm::mat4(1.0f);
+    glm::vec4 color = { 1, 1, 1, 1 };
+    glm::vec4 custom = {};
 };
 
+VERTEX_LAYOUT(InstanceData, VERTEX_ATTRIB_MAT4(3, transform), VERTEX_ATTRIB(7, color), VERTEX_ATTRIB(8, custom));
+
 template <typename Index>
 class Mesh
 {
 public:
-    ~Mesh();
+    /* Switch to a persistently mapped, fence-guarded ring. Must be called before any data is set. Uploads larger than a
+       segment are rejected and the last good data stays in use. */
+    void setStreaming(std::size_t vertexCapacity, std::size_t indexCount, std::uint32_t segmentCount = 3);
 
     void setVertices(const void* data, std::size_t size);
     void setIndices(const void* data, std::size_t count);
-    void apply(GLenum topology, const std::size_t stride, const std::vector<Attrib>& attribs);
+
+    /* Immutable, GPU-only storage. Cheaper for the driver than setVertices/setIndices when the data never changes. */
+    void setImmutableVertices(const void* data, std::size_t size);
+    void setImmutableIndices(const void* data, std::size_t count);
+
+    /* Fixed size storage that is filled in pieces with updateVertices/updateIndices, eg. to spread an upload over frames */
+    void reserveVertices(std::size_t size);
+    void reserveIndices(std::size_t count);
+    void updateVertices(std::size_t offset, const void* data, std::size_t size);
+    void updateIndices(std::size_t firstIndex, const void* data, std::size_t count);
+
+    void apply(GLenum topology, std::size_t stride, std::span<const Attrib> attribs);
+    /* Adds a per-instance stream to a VAO created by the runtime apply() */
+    void applyInstanceLayout(std::size_t instanceStride, std::span<const Attrib> instanceAttribs);
+
+    /* Uses the VAO shared by all meshes with layout `V` (and instance layout `Instance`), see VERTEX_LAYOUT */
+    template <typename V, typename Instance = void>
+    void apply(GLenum topology);
+
+    /* Instance data is streamed through a persistently mapped ring, so it can be rewritten every frame without stalling.
+       Needs an instance layout first, from apply<V, Instance>() or applyInstanceLayout(). */
+    void reserveInstances(std::uint32_t maxInstances, std::uint32_t segmentCount = 3);
+    void setInstances(const void* data, std::uint32_t count);
 
     void bind() const;
     void draw() const;
+    void draw(std::size_t firstIndex, GLsizei indexCount) const;
+    void drawInstanced(GLsizei instanceCount) const;
+
+    /* The vertex buffer's name, which identifies the mesh (eg. in sort keys) */
+    auto id() const -> GLuint;
+
+private:
+    auto vertexBuffer() const -> GLuint;
+    auto indexBuffer() const -> GLuint;
 
 private:
-    GLuint m_vao = 0;
-    GLuint m_vbo = 0, m_ebo = 0;
+    GLuint m_vao = 0; // Either m_ownedVao or one from VertexArrayCache
+    bool m_sharedVao = false;
+    GLVertexArray m_ownedVao;
+    GLBuffer m_vbo, m_ebo;
     GLsizei m_indexCount = 0;
 
     GLenum m_topology = 0;
+    GLsizei m_stride = 0;
+
+    bool m_streaming = false;
+    StreamBuffer m_vertexStream, m_indexStream;
+    std::size_t m_vertexOffset = 0, m_indexOffset = 0;
+
+    GLsizei m_instanceStride = 0;
+    StreamBuffer m_instanceStream;
+    std::size_t m_instanceOffset = 0;
 };
 
 template <typename Index>
-Mesh<Index>::~Mesh()
+void Mesh<Index>::setStreaming(const std::size_t vertexCapacity, const std::size_t indexCount, const std::uint32_t segmentCount)
 {
-    glDeleteVertexArrays(1, &m_vao);
-    glDeleteBuffers(1, &m_vbo);
-    glDeleteBuffers(1, &m_ebo);
+    m_streaming = true;
+    m_vertexStream.init(vertexCapacity, segmentCount);
+    m_indexStream.init(indexCount * sizeof(Index), segmentCount);
 }
 
 template <typename Index>
 void Mesh<Index>::setVertices(const void* data, const std::size_t size)
 {
-    if (m_vbo == 0)
+    if (m_streaming)
     {
-        glCreateBuffers(1, &m_vbo);
+        m_vertexStream.advance();
+        const auto offset = m_vertexStream.write(data, size);
+        if (offset == StreamBuffer::WriteFailed)
+            return;
+
+        m_vertexOffset = offset;
+        if (m_vao != 0 && !m_sharedVao)
+            glVertexArrayVertexBuffer(m_vao, 0, m_vertexStream.buffer(), m_vertexOffset, m_stride);
+        return;
     }
 
-    glNamedBufferData(m_vbo, size, data, GL_STATIC_DRAW);
+    if (!m_vbo)
+        m_vbo = GLBuffer::create();
+
+    glNamedBufferData(m_vbo.id(), size, data, GL_STATIC_DRAW);
 }
 
 template <typename Index>
 void Mesh<Index>::setIndices(const void* data, const std::size_t count)
 {
-    if (m_ebo == 0)
+    if (m_streaming)
     {
-        glCreateBuffers(1, &m_ebo);
+        m_indexStream.advance();
+        const auto offset = m_indexStream.write(data, count * sizeof(Index), sizeof(Index));
+        if (offset == StreamBuffer::WriteFailed)
+            return;
+
+        m_indexOffset = offset;
+        m_indexCount = count;
+        return;
     }
 
-    glNamedBufferData(m_ebo, count * sizeof(Index), data, GL_STATIC_DRAW);
+    if (!m_ebo)
+        m_ebo = GLBuffer::create();
+
+    glNamedBufferData(m_ebo.id(), count * sizeof(Index), data, GL_STATIC_DRAW);
 
     m_indexCount = count;
 }
 
 template <typename Index>
-void Mesh<Index>::apply(const GLenum topology, const std::size_t stride, const std::vector<Attrib>& attribs)
+void Mesh<Index>::setImmutableVertices(const void* data, const std::size_t size)
+{
+    // Immutable storage can't be respecified, so always start from a fresh buffer. The old one is retired once the GPU is done with it.
+    // Zero sized storage is GL_INVALID_VALUE, so an empty mesh just has no buffer.
+    m_vbo = size > 0 ? GLBuffer::create() : GLBuffer();
+    if (m_vbo)
+        glNamedBufferStorage(m_vbo.id(), size, data, 0);
+
+    if (m_vao != 0 && !m_sharedVao)
+        glVertexArrayVertexBuffer(m_vao, 0, m_vbo.id(), 0, m_stride);
+}
+
+template <typename Index>
+void Mesh<Index>::setImmutableIndices(const void* data, const std::size_t count)
+{
+    m_ebo = count > 0 ? GLBuffer::create() : GLBuffer();
+    if (m_ebo)
+        glNamedBufferStorage(m_ebo.id(), count * sizeof(Index), data, 0);
+
+    if (m_vao != 0 && !m_sharedVao)
+        glVertexArrayElementBuffer(m_vao, m_ebo.id());
+
+    m_indexCount = count;
+}
+
+template <typename Index>
+void Mesh<Index>::reserveVertices(const std::size_t size)
+{
+    m_vbo = size > 0 ? GLBuffer::create() : GLBuffer();
+    if (m_vbo)
+        glNamedBufferStorage(m_vbo.id(), size, nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+    if (m_vao != 0 && !m_sharedVao)
+        glVertexArrayVertexBuffer(m_vao, 0, m_vbo.id(), 0, m_stride);
+}
+
+template <typename Index>
+void Mesh<Index>::reserveIndices(const std::size_t count)
+{
+    m_ebo = count > 0 ? GLBuffer::create() : GLBuffer();
+    if (m_ebo)
+        glNamedBufferStorage(m_ebo.id(), count * sizeof(Index), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+    if (m_vao != 0 && !m_sharedVao)
+        glVertexArrayElementBuffer(m_vao, m_ebo.id());
+
+    m_indexCount = count;
+}
+
+template <typename Index>
+void Mesh<Index>::updateVertices(const std::size_t offset, const void* data, const std::size_t size)
+{
+    glNamedBufferSubData(m_vbo.id(), offset, size, data);
+}
+
+template <typename Index>
+void Mesh<Index>::updateIndices(const std::size_t firstIndex, const void* data, const std::size_t count)
+{
+    glNamedBufferSubData(m_ebo.id(), firstIndex * sizeof(Index), count * sizeof(Index), data);
+}
+
+template <typename Index>
+void Mesh<Index>::apply(const GLenum topology, const std::size_t stride, const std::span<const Attrib> attribs)
 {
     m_topology = topology;
+    m_stride = static_cast<GLsizei>(stride);
 
-    if (m_vao == 0)
-    {
-        glCreateVertexArrays(1, &m_vao);
-    }
+    // Never modify a shared VAO, switch to one of our own
+    if (!m_ownedVao)
+        m_ownedVao = GLVertexArray::create();
+    m_vao = m_ownedVao.id();
+    m_sharedVao = false;
 
     // Assign buffers to Vertex Buffer Object
-    glVertexArrayElementBuffer(m_vao, m_ebo);
-    glVertexArrayVertexBuffer(m_vao, 0, m_vbo, 0, stride);
+    glVertexArrayElementBuffer(m_vao, indexBuffer());
+    glVertexArrayVertexBuffer(m_vao, 0, vertexBuffer(), m_vertexOffset, m_stride);
 
     // Setup attributes
     for (const auto& attrib : attribs)
@@ -98,14 +241,104 @@ void Mesh<Index>::apply(const GLenum topology, const std::size_t stride, const s
     }
 }
 
+template <typename Index>
+void Mesh<Index>::applyInstanceLayout(const std::size_t instanceStride, const std::span<const Attrib> instanceAttribs)
+{
+    m_instanceStride = static_cast<GLsizei>(instanceStride);
+    VertexArrayCache::setupInstanceAttribs(m_vao, instanceAttribs);
+}
+
+template <typename Index>
+template <typename V, typename Instance>
+void Mesh<Index>::apply(const GLenum topology)
+{
+    using Layout = VertexLayout<V>;
+
+    m_ownedVao.reset();
+
+    m_topology = topology;
+    m_stride = static_cast<GLsizei>(Layout::stride);
+    m_vao = VertexArrayCache::get<V, Instance>();
+    m_sharedVao = true;
+
+    if constexpr (!std::is_void_v<Instance>)
+        m_instanceStride = static_cast<GLsizei>(VertexLayout<Instance>::stride);
+}
+
+template <typename Index>
+void Mesh<Index>::reserveInstances(const std::uint32_t maxInstances, const std::uint32_t segmentCount)
+{
+    assert(m_instanceStride > 0 && "Set an instance layout with apply<V, Instance>() or applyInstanceLayout() first");
+    m_instanceStream.init(static_cast<std::size_t>(maxInstances) * m_instanceStride, segmentCount);
+}
+
+template <typename Index>
+void Mesh<Index>::setInstances(const void* data, const std::uint32_t count)
+{
+    if (m_instanceStream.buffer() == 0)
+    {
+        std::cerr << "[Mesh] setInstances() called before reserveInstances()" << std::endl;
+        return;
+    }
+
+    m_instanceStream.advance();
+    const auto offset = m_instanceStream.write(data, static_cast<std::size_t>(count) * m_instanceStride);
+    if (offset == StreamBuffer::WriteFailed)
+        return;
+
+    // A shared VAO only picks up our buffers in bind(), but if it's already bound the next draw would still read the
+    // previous segment, so repoint it now
+    m_instanceOffset = offset;
+    if (!m_sharedVao || GLState::snapshot().vertexArray == m_vao)
+        glVertexArrayVertexBuffer(m_vao, VertexArrayCache::InstanceBinding, m_instanceStream.buffer(), m_instanceOffset, m_instanceStride);
+}
+
 template <typename Index>
 void Mesh<Index>::bind() const
 {
-    glBindVertexArray(m_vao);
+    GLState::bindVertexArray(m_vao);
+
+    if (m_sharedVao)
+    {
+        glVertexArrayElementBuffer(m_vao, indexBuffer());
+        glVertexArrayVertexBuffer(m_vao, 0, vertexBuffer(), m_vertexOffset, m_stride);
+        if (m_instanceStride > 0)
+            glVertexArrayVertexBuffer(m_vao, VertexArrayCache::InstanceBinding, m_instanceStream.buffer(), m_instanceOffset, m_instanceStride);
+    }
 }
 
 template <typename Index>
 void Mesh<Index>::draw() const
 {
-    glDrawElements(m_topology, m_indexCount, GL_UNSIGNED_INT, nullptr);
+    glDrawElements(m_topology, m_indexCount, IndexTraits<Index>::glType, reinterpret_cast<const void*>(m_indexOffset));
+}
+
+template <typename Index>
+void Mesh<Index>::draw(const std::size_t firstIndex, const GLsizei indexCount) const
+{
+    glDrawElements(m_topology, indexCount, IndexTraits<Index>::glType, reinterpret_cast<const void*>(m_indexOffset + firstIndex * sizeof(Index)));
+}
+
+template <typename Index>
+void Mesh<Index>::drawInstanced(const GLsizei instanceCount) const
+{
+    glDrawElementsInstanced(m_topology, m_indexCount, IndexTraits<Index>::glType, reinterpret_cast<const void*>(m_indexOffset), instanceCount);
+}
+
+template <typename Index>
+auto Mesh<Index>::id() const -> GLuint
+{
+    return vertexBuffer();
+}
+
+template <typename Index>
+auto Mesh<Index>::vertexBuffer() const -> GLuint
+{
+    return m_streaming ? m_vertexStream.buffer() : m_vbo.id();
+}
+
+template <typename Index>
+auto Mesh<Index>::indexBuffer() const -> GLuint
+{
+    return m_streaming ? m_indexStream.buffer() : m_ebo.id();
 }
@@ -0,0 +1,252 @@
+#pragma once
+
+#include "hash.hpp"
+#include "mapped_file.hpp"
+#include "mesh.hpp"
+
+#include <glad/glad.h>
+#include <glm/common.hpp>
+#include <glm/ext/vector_float3.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <span>
+#include <vector>
+
+// Binary mesh container. The file is memory mapped and the vertex/index blobs are handed straight to glNamedBufferStorage.
+//
+//   [MeshCacheHeader][pad][vertex blob][pad][index blob]
+//
+// Blobs are aligned to MeshCacheAlignment. `sourceHash` is the hash of the asset the cache was built from, so a cache is
+// stale as soon as the source content changes.
+constexpr std::array<char, 4> MeshCacheMagic = { 'G', 'L', 'M', 'C' };
+constexpr std::uint32_t MeshCacheVersion = 1;
+constexpr std::uint32_t MeshCacheAlignment = 64;
+constexpr std::uint32_t MeshCacheMaxAttribs = 16;
+
+struct MeshCacheAttrib
+{
+    std::uint32_t index = 0;
+    std::int32_t size = 0;
+    std::uint32_t type = 0;
+    std::uint32_t normalised = 0;
+    std::uint32_t offset = 0;
+};
+
+struct MeshCacheHeader
+{
+    std::array<char, 4> magic = MeshCacheMagic;
+    std::uint32_t version = MeshCacheVersion;
+    std::uint64_t sourceHash = 0;
+
+    std::uint32_t topology = 0;
+    std::uint32_t indexType = 0;
+    std::uint32_t vertexCount = 0, vertexStride = 0;
+    std::uint32_t indexCount = 0;
+
+    std::uint32_t attribCount = 0;
+    std::array<MeshCacheAttrib, MeshCacheMaxAttribs> attribs = {};
+
+    glm::vec3 boundsMin = {}, boundsMax = {};
+
+    std::uint64_t vertexOffset = 0, vertexSize = 0;
+    std::uint64_t indexOffset = 0, indexSize = 0;
+};
+
+struct MeshCacheDesc
+{
+    std::uint64_t sourceHash = 0;
+    GLenum topology = GL_TRIANGLES;
+    GLenum indexType = GL_UNSIGNED_INT;
+
+    std::span<const Attrib> attribs;
+    std::uint32_t vertexStride = 0;
+
+    const void* vertices = nullptr;
+    std::uint32_t vertexCount = 0;
+    const void* indices = nullptr;
+    std::uint32_t indexCount = 0;
+
+    /* Optional, computed from the first attribute if it is a float position when left empty */
+    glm::vec3 boundsMin = {}, boundsMax = {};
+};
+
+inline auto hashMeshSource(const void* data, const std::size_t size) -> std::uint64_t
+{
+    return fnv1a64(data, size, fnv1a64(MeshCacheVersion));
+}
+
+inline auto indexTypeSize(const GLenum indexType) -> std::uint32_t
+{
+    switch (indexType)
+    {
+    case GL_UNSIGNED_BYTE:
+        return 1;
+    case GL_UNSIGNED_SHORT:
+        return 2;
+    default:
+        return 4;
+    }
+}
+
+inline bool writeMeshCache(const char* path, const MeshCacheDesc& desc)
+{
+    if (desc.attribs.size() > MeshCacheMaxAttribs)
+    {
+        std::cerr << "[MeshCache] Too many attributes (" << desc.attribs.size() << ")" << std::endl;
+        return false;
+    }
+
+    auto align = [](const std::uint64_t value) { return (value + MeshCacheAlignment - 1) / MeshCacheAlignment * MeshCacheAlignment; };
+
+    MeshCacheHeader header;
+    header.sourceHash = desc.sourceHash;
+    header.topology = desc.topology;
+    header.indexType = desc.indexType;
+    header.vertexCount = desc.vertexCount;
+    header.vertexStride = desc.vertexStride;
+    header.indexCount = desc.indexCount;
+    header.attribCount = static_cast<std::uint32_t>(desc.attribs.size());
+    for (std::size_t i = 0; i < desc.attribs.size(); ++i)
+    {
+        const auto& attrib = desc.attribs[i];
+        header.attribs[i] = { attrib.index, attrib.size, attrib.type, attrib.normalised, attrib.offset };
+    }
+
+    header.boundsMin = desc.boundsMin;
+    header.boundsMax = desc.boundsMax;
+    if (desc.boundsMin == desc.boundsMax && !desc.attribs.empty() && desc.attribs[0].type == GL_FLOAT && desc.attribs[0].size >= 2 && desc.vertexCount > 0)
+    {
+        const auto* bytes = static_cast<const std::uint8_t*>(desc.vertices);
+        const auto components = std::min(desc.attribs[0].size, 3);
+        for (std::uint32_t v = 0; v < desc.vertexCount; ++v)
+        {
+            glm::vec3 p(0.0f);
+            std::memcpy(&p, bytes + v * desc.vertexStride + desc.attribs[0].offset, components * sizeof(float));
+            header.boundsMin = v == 0 ? p : glm::min(header.boundsMin, p);
+            header.boundsMax = v == 0 ? p : glm::max(header.boundsMax, p);
+        }
+    }
+
+    header.vertexSize = static_cast<std::uint64_t>(desc.vertexCount) * desc.vertexStride;
+    header.indexSize = static_cast<std::uint64_t>(desc.indexCount) * indexTypeSize(desc.indexType);
+    header.vertexOffset = align(sizeof(MeshCacheHeader));
+    header.indexOffset = align(header.vertexOffset + header.vertexSize);
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        std::cerr << "[MeshCache] Failed to open " << path << " for writing" << std::endl;
+        return false;
+    }
+
+    const char padding[MeshCacheAlignment] = {};
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(padding, header.vertexOffset - sizeof(header));
+    file.write(static_cast<const char*>(desc.vertices), header.vertexSize);
+    file.write(padding, header.indexOffset - header.vertexOffset - header.vertexSize);
+    file.write(static_cast<const char*>(desc.indices), header.indexSize);
+
+    return file.good();
+}
+
+class MeshCacheFile
+{
+public:
+    /* Fails if the file is missing, malformed, from another version or was built from different source content */
+    bool open(const char* path, std::uint64_t expectedSourceHash);
+
+    auto header() const -> const MeshCacheHeader&;
+    auto attribs() const -> std::vector<Attrib>;
+    auto vertexData() const -> const void*;
+    auto indexData() const -> const void*;
+
+    /* Uploads directly from the mapping into immutable buffers */
+    template <typename Index>
+    bool upload(Mesh<Index>& mesh) const;
+
+private:
+    MappedFile m_file;
+    const MeshCacheHeader* m_header = nullptr;
+};
+
+inline bool MeshCacheFile::open(const char* path, const std::uint64_t expectedSourceHash)
+{
+    m_header = nullptr;
+    if (!m_file.open(path))
+        return false;
+
+    if (m_file.size() < sizeof(MeshCacheHeader))
+        return false;
+
+    const auto* header = reinterpret_cast<const MeshCacheHeader*>(m_file.data());
+    if (header->magic != MeshCacheMagic || header->version != MeshCacheVersion || header->sourceHash != expectedSourceHash)
+        return false;
+
+    // Sizes must match the counts exactly, and ranges are checked as size <= fileSize && offset <= fileSize - size so a
+    // corrupt 64-bit offset can't wrap around
+    const auto fileSize = static_cast<std::uint64_t>(m_file.size());
+    auto inFile = [fileSize](const std::uint64_t offset, const std::uint64_t size) { return size <= fileSize && offset <= fileSize - size; };
+    const auto validIndexType = header->indexType == GL_UNSIGNED_BYTE || header->indexType == GL_UNSIGNED_SHORT || header->indexType == GL_UNSIGNED_INT;
+
+    if (header->attribCount > MeshCacheMaxAttribs || !validIndexType ||
+        header->vertexSize != static_cast<std::uint64_t>(header->vertexCount) * header->vertexStride ||
+        header->indexSize != static_cast<std::uint64_t>(header->indexCount) * indexTypeSize(header->indexType) ||
+        !inFile(header->vertexOffset, header->vertexSize) || !inFile(header->indexOffset, header->indexSize))
+    {
+        std::cerr << "[MeshCache] " << path << " is truncated or corrupt" << std::endl;
+        return false;
+    }
+
+    m_header = header;
+    return true;
+}
+
+inline auto MeshCacheFile::header() const -> const MeshCacheHeader&
+{
+    return *m_header;
+}
+
+inline auto MeshCacheFile::attribs() const -> std::vector<Attrib>
+{
+    std::vector<Attrib> attribs(m_header->attribCount);
+    for (std::uint32_t i = 0; i < m_header->attribCount; ++i)
+    {
+        const auto& attrib = m_header->attribs[i];
+        attribs[i] = { attrib.index, attrib.size, attrib.type, static_cast<GLboolean>(attrib.normalised), attrib.offset };
+    }
+    return attribs;
+}
+
+inline auto MeshCacheFile::vertexData() const -> const void*
+{
+    return m_file.data() + m_header->vertexOffset;
+}
+
+inline auto MeshCacheFile::indexData() const -> const void*
+{
+    return m_file.data() + m_header->indexOffset;
+}
+
+template <typename Index>
+bool MeshCacheFile::upload(Mesh<Index>& mesh) const
+{
+    if (m_header == nullptr)
+        return false;
+
+    if (m_header->indexType != IndexTraits<Index>::glType)
+    {
+        std::cerr << "[MeshCache] Index type mismatch" << std::endl;
+        return false;
+    }
+
+    // Counts come from the sizes open() validated against the file
+    mesh.setImmutableVertices(vertexData(), m_header->vertexSize);
+    mesh.setImmutableIndices(indexData(), static_cast<std::size_t>(m_header->indexSize / sizeof(Index)));
+    mesh.apply(m_header->topology, m_header->vertexStride, attribs());
+    return true;
+}
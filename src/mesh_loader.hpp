@@ -0,0 +1,302 @@
+#pragma once
+
+#include "concurrent_queue.hpp"
+#include "mesh.hpp"
+#include "thread_pool.hpp"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+// CPU side mesh produced by a loader on a worker thread
+struct MeshData
+{
+    GLenum topology = GL_TRIANGLES;
+    std::uint32_t vertexStride = 0;
+    std::vector<Attrib> attribs;
+    std::vector<std::uint8_t> vertices;
+    std::vector<std::uint32_t> indices;
+};
+
+struct AssetTimings
+{
+    double loadMs = 0.0;
+    double processMs = 0.0;
+    double uploadMs = 0.0;  // GL thread time, summed over every frame the upload was spread across
+    double latencyMs = 0.0; // Request to drawable
+    std::uint32_t uploadFrames = 0;
+};
+
+enum class AssetState
+{
+    Loading,
+    Uploading,
+    Ready,
+    Failed,
+};
+
+class AsyncMesh
+{
+public:
+    auto state() const -> AssetState;
+    bool ready() const;
+
+    /* Only drawable once ready() */
+    auto mesh() -> Mesh<std::uint32_t>&;
+
+    auto name() const -> const std::string&;
+    auto timings() const -> const AssetTimings&;
+
+private:
+    friend class MeshLoader;
+
+    std::string m_name;
+    std::atomic<AssetState> m_state = AssetState::Loading;
+    Mesh<std::uint32_t> m_mesh;
+
+    AssetTimings m_timings;
+    std::chrono::steady_clock::time_point m_requestTime;
+};
+
+using AsyncMeshHandle = std::shared_ptr<AsyncMesh>;
+
+// Parses and processes meshes on a worker pool, then uploads them on the GL thread under a per-frame byte budget.
+class MeshLoader
+{
+public:
+    using LoadFunc = std::function<bool(MeshData&)>;
+    using ProcessFunc = std::function<void(MeshData&)>;
+
+    ~MeshLoader();
+
+    void init(std::uint32_t threadCount = 0);
+    void shutdown();
+
+    /* `load` and `process` run on a worker thread and must not touch GL */
+    auto load(std::string name, LoadFunc load, ProcessFunc process = {}) -> AsyncMeshHandle;
+
+    /* Call on the GL thread once per frame. Uploads at most `byteBudget` bytes, splitting large meshes across frames. */
+    void pumpUploads(std::size_t byteBudget);
+
+    auto pendingCount() const -> std::uint32_t;
+
+private:
+    struct Upload
+    {
+        AsyncMeshHandle handle;
+        MeshData data;
+        std::size_t vertexBytesDone = 0;
+        std::size_t indicesDone = 0;
+        bool started = false;
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    static auto millisecondsSince(Clock::time_point start) -> double;
+
+private:
+    ThreadPool m_pool;
+    ConcurrentQueue<Upload> m_finished{ 256 };
+    std::deque<Upload> m_uploads;
+    std::atomic<std::uint32_t> m_pending = 0;
+    std::atomic<bool> m_stopping = false;
+
+    // Loads submitted but not yet picked up by a worker, so shutdown can fail the ones the pool drops
+    std::mutex m_queuedMutex;
+    std::unordered_set<AsyncMesh*> m_queued;
+};
+
+inline auto AsyncMesh::state() const -> AssetState
+{
+    return m_state.load(std::memory_order_acquire);
+}
+
+inline bool AsyncMesh::ready() const
+{
+    return state() == AssetState::Ready;
+}
+
+inline auto AsyncMesh::mesh() -> Mesh<std::uint32_t>&
+{
+    return m_mesh;
+}
+
+inline auto AsyncMesh::name() const -> const std::string&
+{
+    return m_name;
+}
+
+inline auto AsyncMesh::timings() const -> const AssetTimings&
+{
+    return m_timings;
+}
+
+inline MeshLoader::~MeshLoader()
+{
+    shutdown();
+}
+
+inline void MeshLoader::init(const std::uint32_t threadCount)
+{
+    m_stopping = false;
+    m_pool.init(threadCount);
+}
+
+/* Must be called on the GL thread, as it releases any in-flight meshes. Every load that hasn't finished is marked Failed. */
+inline void MeshLoader::shutdown()
+{
+    m_stopping = true;
+
+    m_pending -= static_cast<std::uint32_t>(m_uploads.size());
+    for (auto& upload : m_uploads)
+        upload.handle->m_state.store(AssetState::Failed, std::memory_order_release);
+    m_uploads.clear();
+
+    // Keep draining so no worker is left spinning on a full queue. Without workers nothing will ever finish, the pool
+    // drops the queued loads instead.
+    while (m_pending > 0 && m_pool.threadCount() > 0)
+    {
+        while (auto finished = m_finished.tryPop())
+        {
+            finished->handle->m_state.store(AssetState::Failed, std::memory_order_release);
+            --m_pending;
+        }
+        std::this_thread::yield();
+    }
+
+    {
+        std::lock_guard lock(m_queuedMutex);
+        for (auto* mesh : m_queued)
+            mesh->m_state.store(AssetState::Failed, std::memory_order_release);
+        m_queued.clear();
+    }
+
+    m_pool.shutdown();
+    m_pending = 0;
+}
+
+inline auto MeshLoader::load(std::string name, LoadFunc load, ProcessFunc process) -> AsyncMeshHandle
+{
+    auto handle = std::make_shared<AsyncMesh>();
+    handle->m_name = std::move(name);
+    handle->m_requestTime = Clock::now();
+    ++m_pending;
+
+    {
+        std::lock_guard lock(m_queuedMutex);
+        m_queued.insert(handle.get());
+    }
+
+    m_pool.submit([this, handle, load = std::move(load), process = std::move(process)]() mutable {
+        {
+            std::lock_guard lock(m_queuedMutex);
+            m_queued.erase(handle.get());
+        }
+
+        Upload upload;
+
+        auto start = Clock::now();
+        const auto loaded = !m_stopping && load(upload.data);
+        handle->m_timings.loadMs = millisecondsSince(start);
+
+        if (loaded && process && !m_stopping)
+        {
+            start = Clock::now();
+            process(upload.data);
+            handle->m_timings.processMs = millisecondsSince(start);
+        }
+
+        // Meshes are always indexed, and GL can't allocate empty buffers
+        const auto empty = loaded && (upload.data.vertices.empty() || upload.data.indices.empty());
+        if (empty)
+            std::cerr << "[MeshLoader] " << handle->m_name << " has no vertices or indices" << std::endl;
+
+        handle->m_state.store(loaded && !empty ? AssetState::Uploading : AssetState::Failed, std::memory_order_release);
+
+        // Hand over our reference too, the handle must only ever be destroyed on the GL thread
+        upload.handle = std::move(handle);
+        while (!m_finished.tryPush(std::move(upload)))
+            std::this_thread::yield();
+    });
+
+    return handle;
+}
+
+inline void MeshLoader::pumpUploads(std::size_t byteBudget)
+{
+    while (auto finished = m_finished.tryPop())
+    {
+        if (finished->handle->state() == AssetState::Failed)
+        {
+            --m_pending;
+            continue;
+        }
+        m_uploads.push_back(std::move(*finished));
+    }
+
+    while (!m_uploads.empty() && byteBudget > 0)
+    {
+        auto& upload = m_uploads.front();
+        auto& mesh = upload.handle->m_mesh;
+        const auto& data = upload.data;
+        const auto start = Clock::now();
+
+        if (!upload.started)
+        {
+            mesh.reserveVertices(data.vertices.size());
+            mesh.reserveIndices(data.indices.size());
+            upload.started = true;
+        }
+
+        const auto vertexBytes = std::min(byteBudget, data.vertices.size() - upload.vertexBytesDone);
+        if (vertexBytes > 0)
+        {
+            mesh.updateVertices(upload.vertexBytesDone, data.vertices.data() + upload.vertexBytesDone, vertexBytes);
+            upload.vertexBytesDone += vertexBytes;
+            byteBudget -= vertexBytes;
+        }
+
+        const auto indexCount = std::min(byteBudget / sizeof(std::uint32_t), data.indices.size() - upload.indicesDone);
+        if (indexCount > 0)
+        {
+            mesh.updateIndices(upload.indicesDone, data.indices.data() + upload.indicesDone, indexCount);
+            upload.indicesDone += indexCount;
+            byteBudget -= indexCount * sizeof(std::uint32_t);
+        }
+
+        auto& timings = upload.handle->m_timings;
+        timings.uploadMs += millisecondsSince(start);
+        ++timings.uploadFrames;
+
+        if (upload.vertexBytesDone < data.vertices.size() || upload.indicesDone < data.indices.size())
+            break; // Out of budget, continue next frame
+
+        mesh.apply(data.topology, data.vertexStride, data.attribs);
+        timings.latencyMs = millisecondsSince(upload.handle->m_requestTime);
+        upload.handle->m_state.store(AssetState::Ready, std::memory_order_release);
+
+        m_uploads.pop_front();
+        --m_pending;
+    }
+}
+
+inline auto MeshLoader::pendingCount() const -> std::uint32_t
+{
+    return m_pending.load(std::memory_order_relaxed);
+}
+
+inline auto MeshLoader::millisecondsSince(const Clock::time_point start) -> double
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
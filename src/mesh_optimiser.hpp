@@ -0,0 +1,311 @@
+#pragma once
+
+#include <glm/ext/vector_float3.hpp>
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Triangle list optimisation passes, run in this order:
+//   1. optimiseVertexCache  - Forsyth's linear-speed vertex cache optimisation
+//   2. optimiseOverdraw     - reorders cache-friendly clusters to draw outward facing ones first
+//   3. optimiseVertexFetch  - remaps vertices into first-use order for fetch locality
+
+struct VertexCacheStats
+{
+    float acmr = 0.0f; // Average cache miss ratio, transformed vertices per triangle (0.5 - 3.0)
+    float atvr = 0.0f; // Average transform to vertex ratio (1.0 is perfect)
+};
+
+/* Simulates a FIFO post-transform cache of `cacheSize` entries */
+inline auto analyseVertexCache(const std::uint32_t* indices, const std::size_t indexCount, const std::size_t vertexCount, const std::uint32_t cacheSize = 16)
+    -> VertexCacheStats
+{
+    std::vector<std::uint32_t> timestamps(vertexCount, 0);
+    std::uint32_t time = cacheSize + 1;
+    std::size_t misses = 0;
+
+    for (std::size_t i = 0; i < indexCount; ++i)
+    {
+        const auto index = indices[i];
+        if (time - timestamps[index] > cacheSize)
+        {
+            timestamps[index] = time++;
+            ++misses;
+        }
+    }
+
+    std::size_t usedVertices = 0;
+    for (auto stamp : timestamps)
+        usedVertices += stamp != 0;
+
+    VertexCacheStats stats;
+    if (indexCount >= 3)
+        stats.acmr = static_cast<float>(misses) / static_cast<float>(indexCount / 3);
+    if (usedVertices > 0)
+        stats.atvr = static_cast<float>(misses) / static_cast<float>(usedVertices);
+    return stats;
+}
+
+inline void optimiseVertexCache(std::uint32_t* dst, const std::uint32_t* indices, const std::size_t indexCount, const std::size_t vertexCount)
+{
+    constexpr std::uint32_t CacheSize = 32;
+    constexpr std::uint32_t MaxValence = 32;
+    constexpr float CacheDecayPower = 1.5f;
+    constexpr float LastTriScore = 0.75f;
+    constexpr float ValenceBoostScale = 2.0f;
+    constexpr float ValenceBoostPower = 0.5f;
+
+    const auto triangleCount = indexCount / 3;
+    if (triangleCount == 0)
+        return;
+
+    // Precomputed score tables
+    float cacheScores[CacheSize + 1];
+    for (std::uint32_t i = 0; i < CacheSize; ++i)
+    {
+        if (i < 3)
+            cacheScores[i] = LastTriScore;
+        else
+            cacheScores[i] = std::pow(1.0f - static_cast<float>(i - 3) / static_cast<float>(CacheSize - 3), CacheDecayPower);
+    }
+    cacheScores[CacheSize] = 0.0f;
+
+    float valenceScores[MaxValence + 1];
+    valenceScores[0] = 0.0f;
+    for (std::uint32_t i = 1; i <= MaxValence; ++i)
+        valenceScores[i] = ValenceBoostScale * std::pow(static_cast<float>(i), -ValenceBoostPower);
+
+    // Vertex -> triangle adjacency
+    std::vector<std::uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+    for (std::size_t i = 0; i < indexCount; ++i)
+        ++adjacencyOffsets[indices[i] + 1];
+    for (std::size_t v = 0; v < vertexCount; ++v)
+        adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+
+    std::vector<std::uint32_t> adjacency(indexCount);
+    std::vector<std::uint32_t> liveTriangles(vertexCount, 0);
+    for (std::size_t i = 0; i < indexCount; ++i)
+    {
+        const auto v = indices[i];
+        adjacency[adjacencyOffsets[v] + liveTriangles[v]++] = static_cast<std::uint32_t>(i / 3);
+    }
+
+    std::vector<std::int32_t> cachePositions(vertexCount, -1);
+    std::vector<float> vertexScores(vertexCount);
+    auto vertexScore = [&](const std::uint32_t v) {
+        const auto live = liveTriangles[v];
+        if (live == 0)
+            return -1.0f;
+
+        const auto position = cachePositions[v];
+        const auto cacheScore = position < 0 ? 0.0f : cacheScores[position];
+        return cacheScore + valenceScores[std::min(live, MaxValence)];
+    };
+    for (std::uint32_t v = 0; v < vertexCount; ++v)
+        vertexScores[v] = vertexScore(v);
+
+    std::vector<float> triangleScores(triangleCount);
+    for (std::size_t t = 0; t < triangleCount; ++t)
+        triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+
+    std::vector<bool> emitted(triangleCount, false);
+    std::uint32_t cache[CacheSize + 3];
+    std::uint32_t cacheCount = 0;
+
+    std::size_t bestTriangle = 0;
+    for (std::size_t t = 1; t < triangleCount; ++t)
+    {
+        if (triangleScores[t] > triangleScores[bestTriangle])
+            bestTriangle = t;
+    }
+
+    std::size_t scanCursor = 0;
+    for (std::size_t out = 0; out < triangleCount; ++out)
+    {
+        const auto* tri = indices + bestTriangle * 3;
+        std::memcpy(dst + out * 3, tri, sizeof(std::uint32_t) * 3);
+        emitted[bestTriangle] = true;
+
+        // Remove the triangle from its vertices' live adjacency
+        for (std::uint32_t i = 0; i < 3; ++i)
+        {
+            const auto v = tri[i];
+            auto* begin = adjacency.data() + adjacencyOffsets[v];
+            auto* end = begin + liveTriangles[v];
+            *std::find(begin, end, static_cast<std::uint32_t>(bestTriangle)) = *(end - 1);
+            --liveTriangles[v];
+        }
+
+        // Push the triangle's vertices to the front of the LRU cache
+        std::uint32_t newCache[CacheSize + 3];
+        std::uint32_t newCount = 0;
+        for (std::uint32_t i = 0; i < 3; ++i)
+            newCache[newCount++] = tri[i];
+        for (std::uint32_t i = 0; i < cacheCount; ++i)
+        {
+            const auto v = cache[i];
+            if (v != tri[0] && v != tri[1] && v != tri[2])
+                newCache[newCount++] = v;
+        }
+
+        for (std::uint32_t i = 0; i < newCount; ++i)
+        {
+            const auto v = newCache[i];
+            cachePositions[v] = i < CacheSize ? static_cast<std::int32_t>(i) : -1;
+            cache[i] = v;
+        }
+        cacheCount = std::min(newCount, CacheSize);
+
+        // Rescore every vertex that moved and the triangles touching it, tracking the best candidate
+        float bestScore = -1.0f;
+        for (std::uint32_t i = 0; i < newCount; ++i)
+        {
+            const auto v = newCache[i];
+            const auto score = vertexScore(v);
+            const auto delta = score - vertexScores[v];
+            vertexScores[v] = score;
+
+            for (std::uint32_t a = 0; a < liveTriangles[v]; ++a)
+            {
+                const auto t = adjacency[adjacencyOffsets[v] + a];
+                triangleScores[t] += delta;
+                if (triangleScores[t] > bestScore)
+                {
+                    bestScore = triangleScores[t];
+                    bestTriangle = t;
+                }
+            }
+        }
+
+        if (bestScore < 0.0f)
+        {
+            // Nothing adjacent to the cache, fall back to the next unemitted triangle
+            while (scanCursor < triangleCount && emitted[scanCursor])
+                ++scanCursor;
+            bestTriangle = scanCursor;
+        }
+    }
+}
+
+/* `indices` must already be cache optimised. Positions are read as a vec3 at `positionOffset` within each vertex. */
+inline void optimiseOverdraw(std::uint32_t* indices,
+                             const std::size_t indexCount,
+                             const void* vertices,
+                             const std::size_t vertexCount,
+                             const std::size_t vertexStride,
+                             const std::size_t positionOffset = 0,
+                             const std::uint32_t minClusterTriangles = 64)
+{
+    const auto* vertexBytes = static_cast<const std::uint8_t*>(vertices);
+    auto position = [&](const std::uint32_t v) {
+        glm::vec3 p;
+        std::memcpy(&p, vertexBytes + v * vertexStride + positionOffset, sizeof(p));
+        return p;
+    };
+
+    const auto triangleCount = indexCount / 3;
+    if (triangleCount == 0)
+        return;
+
+    // Split into clusters at cache breaks, so reordering clusters preserves most of the cache efficiency
+    std::vector<std::size_t> clusterStarts = { 0 };
+    {
+        constexpr std::uint32_t CacheSize = 16;
+        std::vector<std::uint32_t> timestamps(vertexCount, 0);
+        std::uint32_t time = CacheSize + 1;
+
+        for (std::size_t t = 0; t < triangleCount; ++t)
+        {
+            std::uint32_t misses = 0;
+            for (std::uint32_t i = 0; i < 3; ++i)
+            {
+                const auto v = indices[t * 3 + i];
+                if (time - timestamps[v] > CacheSize)
+                {
+                    timestamps[v] = time++;
+                    ++misses;
+                }
+            }
+
+            if (misses == 3 && t - clusterStarts.back() >= minClusterTriangles)
+                clusterStarts.push_back(t);
+        }
+    }
+    clusterStarts.push_back(triangleCount);
+
+    glm::vec3 meshCentroid(0.0f);
+    for (std::size_t i = 0; i < indexCount; ++i)
+        meshCentroid += position(indices[i]);
+    meshCentroid /= static_cast<float>(indexCount);
+
+    struct Cluster
+    {
+        std::size_t start, end;
+        float sortKey;
+    };
+
+    std::vector<Cluster> clusters;
+    clusters.reserve(clusterStarts.size() - 1);
+    for (std::size_t c = 0; c + 1 < clusterStarts.size(); ++c)
+    {
+        glm::vec3 centroid(0.0f), normal(0.0f);
+        float area = 0.0f;
+        for (auto t = clusterStarts[c]; t < clusterStarts[c + 1]; ++t)
+        {
+            const auto a = position(indices[t * 3]), b = position(indices[t * 3 + 1]), c2 = position(indices[t * 3 + 2]);
+            const auto n = glm::cross(b - a, c2 - a);
+            const auto triArea = glm::length(n);
+            centroid += (a + b + c2) * (triArea / 3.0f);
+            normal += n;
+            area += triArea;
+        }
+
+        centroid = area > 0.0f ? centroid / area : position(indices[clusterStarts[c] * 3]);
+        const auto normalLength = glm::length(normal);
+        normal = normalLength > 0.0f ? normal / normalLength : glm::vec3(0.0f);
+
+        // Clusters facing away from the mesh centre are likely to occlude the others, so draw them first
+        clusters.push_back({ clusterStarts[c], clusterStarts[c + 1], glm::dot(centroid - meshCentroid, normal) });
+    }
+
+    std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& lhs, const Cluster& rhs) { return lhs.sortKey > rhs.sortKey; });
+
+    std::vector<std::uint32_t> sorted;
+    sorted.reserve(indexCount);
+    for (const auto& cluster : clusters)
+        sorted.insert(sorted.end(), indices + cluster.start * 3, indices + cluster.end * 3);
+    std::memcpy(indices, sorted.data(), sorted.size() * sizeof(std::uint32_t));
+}
+
+/* Reorders `vertices` into first-use order and rewrites `indices` to match. Unreferenced vertices are dropped.
+   Returns the new vertex count. */
+inline auto optimiseVertexFetch(
+    void* vertices, std::uint32_t* indices, const std::size_t indexCount, const std::size_t vertexCount, const std::size_t vertexStride) -> std::size_t
+{
+    constexpr std::uint32_t Unmapped = ~0u;
+
+    std::vector<std::uint32_t> remap(vertexCount, Unmapped);
+    std::uint32_t nextVertex = 0;
+    for (std::size_t i = 0; i < indexCount; ++i)
+    {
+        auto& mapped = remap[indices[i]];
+        if (mapped == Unmapped)
+            mapped = nextVertex++;
+        indices[i] = mapped;
+    }
+
+    auto* vertexBytes = static_cast<std::uint8_t*>(vertices);
+    std::vector<std::uint8_t> reordered(nextVertex * vertexStride);
+    for (std::size_t v = 0; v < vertexCount; ++v)
+    {
+        if (remap[v] != Unmapped)
+            std::memcpy(reordered.data() + remap[v] * vertexStride, vertexBytes + v * vertexStride, vertexStride);
+    }
+    std::memcpy(vertexBytes, reordered.data(), reordered.size());
+
+    return nextVertex;
+}
@@ -0,0 +1,355 @@
+#pragma once
+
+#include <glm/ext/vector_double3.hpp>
+#include <glm/ext/vector_float3.hpp>
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <future>
+#include <queue>
+#include <vector>
+
+// Garland-Heckbert quadric error edge collapse. Vertices are only ever collapsed onto existing vertices, so every LOD
+// shares the source vertex buffer and only the index data differs.
+
+struct LodLevel
+{
+    std::uint32_t firstIndex = 0;
+    std::uint32_t indexCount = 0;
+    float error = 0.0f; // Approximate object space deviation from the source mesh
+};
+
+// All levels packed into one index buffer, finest first. Switching LOD only changes the index offset and count.
+struct LodChain
+{
+    std::vector<std::uint32_t> indices;
+    std::vector<LodLevel> levels;
+};
+
+struct Quadric
+{
+    double a2 = 0, ab = 0, ac = 0, ad = 0;
+    double b2 = 0, bc = 0, bd = 0;
+    double c2 = 0, cd = 0;
+    double d2 = 0;
+    double weight = 0;
+
+    static auto fromPlane(const glm::dvec3& n, const double d, const double weight) -> Quadric
+    {
+        return { n.x * n.x * weight, n.x * n.y * weight, n.x * n.z * weight, n.x * d * weight, n.y * n.y * weight, n.y * n.z * weight,
+                 n.y * d * weight,   n.z * n.z * weight, n.z * d * weight,   d * d * weight,   weight };
+    }
+
+    auto operator+=(const Quadric& q) -> Quadric&
+    {
+        a2 += q.a2, ab += q.ab, ac += q.ac, ad += q.ad;
+        b2 += q.b2, bc += q.bc, bd += q.bd;
+        c2 += q.c2, cd += q.cd;
+        d2 += q.d2;
+        weight += q.weight;
+        return *this;
+    }
+
+    auto evaluate(const glm::dvec3& p) const -> double
+    {
+        const auto result = a2 * p.x * p.x + 2 * ab * p.x * p.y + 2 * ac * p.x * p.z + 2 * ad * p.x + b2 * p.y * p.y + 2 * bc * p.y * p.z + 2 * bd * p.y +
+                             c2 * p.z * p.z + 2 * cd * p.z + d2;
+        return std::max(result, 0.0);
+    }
+};
+
+struct SimplifyResult
+{
+    std::vector<std::uint32_t> indices;
+    float error = 0.0f;
+};
+
+/* Positions are read as a vec3 at `positionOffset` within each vertex.
+   Stops at `targetIndexCount` or once a collapse would exceed `maxError`. */
+inline auto simplifyMesh(const std::uint32_t* indices,
+                         const std::size_t indexCount,
+                         const void* vertices,
+                         const std::size_t vertexCount,
+                         const std::size_t vertexStride,
+                         const std::size_t positionOffset,
+                         const std::size_t targetIndexCount,
+                         const float maxError = 1e30f) -> SimplifyResult
+{
+    constexpr std::uint32_t Invalid = ~0u;
+    constexpr double BorderWeight = 10.0;
+
+    const auto* vertexBytes = static_cast<const std::uint8_t*>(vertices);
+    std::vector<glm::dvec3> positions(vertexCount);
+    for (std::size_t v = 0; v < vertexCount; ++v)
+    {
+        glm::vec3 p;
+        std::memcpy(&p, vertexBytes + v * vertexStride + positionOffset, sizeof(p));
+        positions[v] = p;
+    }
+
+    const auto triangleCount = indexCount / 3;
+    std::vector<std::uint32_t> triangles(indices, indices + triangleCount * 3);
+    std::vector<bool> triangleAlive(triangleCount, true);
+    std::vector<std::vector<std::uint32_t>> adjacency(vertexCount);
+    std::vector<Quadric> quadrics(vertexCount);
+
+    auto triangleNormal = [&](const std::uint32_t a, const std::uint32_t b, const std::uint32_t c) {
+        return glm::cross(positions[b] - positions[a], positions[c] - positions[a]);
+    };
+
+    for (std::uint32_t t = 0; t < triangleCount; ++t)
+    {
+        const auto* tri = &triangles[t * 3];
+        const auto n = triangleNormal(tri[0], tri[1], tri[2]);
+        const auto area = glm::length(n);
+        if (area > 0.0)
+        {
+            const auto unit = n / area;
+            const auto plane = Quadric::fromPlane(unit, -glm::dot(unit, positions[tri[0]]), area);
+            for (std::uint32_t i = 0; i < 3; ++i)
+                quadrics[tri[i]] += plane;
+        }
+
+        for (std::uint32_t i = 0; i < 3; ++i)
+            adjacency[tri[i]].push_back(t);
+    }
+
+    // Border edges are used by a single triangle. Pin them with a plane perpendicular to the face so outlines don't erode.
+    {
+        std::vector<std::uint64_t> edges;
+        edges.reserve(triangleCount * 3);
+        for (std::uint32_t t = 0; t < triangleCount; ++t)
+        {
+            for (std::uint32_t i = 0; i < 3; ++i)
+            {
+                const auto a = triangles[t * 3 + i], b = triangles[t * 3 + (i + 1) % 3];
+                edges.push_back(static_cast<std::uint64_t>(std::min(a, b)) << 32 | std::max(a, b));
+            }
+        }
+
+        std::vector<std::uint64_t> sorted = edges;
+        std::sort(sorted.begin(), sorted.end());
+
+        for (std::uint32_t t = 0; t < triangleCount; ++t)
+        {
+            for (std::uint32_t i = 0; i < 3; ++i)
+            {
+                const auto key = edges[t * 3 + i];
+                const auto [first, last] = std::equal_range(sorted.begin(), sorted.end(), key);
+                if (last - first != 1)
+                    continue;
+
+                const auto a = triangles[t * 3 + i], b = triangles[t * 3 + (i + 1) % 3];
+                const auto edge = positions[b] - positions[a];
+                const auto edgeLength = glm::length(edge);
+                const auto n = glm::cross(edge, triangleNormal(triangles[t * 3], triangles[t * 3 + 1], triangles[t * 3 + 2]));
+                const auto nLength = glm::length(n);
+                if (nLength <= 0.0)
+                    continue;
+
+                const auto unit = n / nLength;
+                const auto plane = Quadric::fromPlane(unit, -glm::dot(unit, positions[a]), edgeLength * edgeLength * BorderWeight);
+                quadrics[a] += plane;
+                quadrics[b] += plane;
+            }
+        }
+    }
+
+    struct Collapse
+    {
+        double cost;
+        std::uint32_t from, to;
+        std::uint32_t fromVersion, toVersion;
+
+        bool operator>(const Collapse& other) const
+        {
+            return cost > other.cost;
+        }
+    };
+
+    std::vector<std::uint32_t> versions(vertexCount, 0);
+    std::vector<std::uint32_t> collapsedInto(vertexCount, Invalid);
+    std::priority_queue<Collapse, std::vector<Collapse>, std::greater<>> heap;
+
+    auto pushEdge = [&](const std::uint32_t a, const std::uint32_t b) {
+        auto q = quadrics[a];
+        q += quadrics[b];
+        const auto costToB = q.evaluate(positions[b]);
+        const auto costToA = q.evaluate(positions[a]);
+        const auto weight = std::max(q.weight, 1e-12);
+
+        if (costToB <= costToA)
+            heap.push({ costToB / weight, a, b, versions[a], versions[b] });
+        else
+            heap.push({ costToA / weight, b, a, versions[b], versions[a] });
+    };
+
+    for (std::uint32_t t = 0; t < triangleCount; ++t)
+    {
+        for (std::uint32_t i = 0; i < 3; ++i)
+        {
+            const auto a = triangles[t * 3 + i], b = triangles[t * 3 + (i + 1) % 3];
+            if (a < b)
+                pushEdge(a, b);
+        }
+    }
+
+    auto liveIndexCount = triangleCount * 3;
+    double worstError = 0.0;
+    const auto maxErrorSq = static_cast<double>(maxError) * maxError;
+
+    while (liveIndexCount > targetIndexCount && !heap.empty())
+    {
+        const auto collapse = heap.top();
+        heap.pop();
+
+        const auto from = collapse.from, to = collapse.to;
+        if (collapsedInto[from] != Invalid || collapsedInto[to] != Invalid)
+            continue;
+        if (versions[from] != collapse.fromVersion || versions[to] != collapse.toVersion)
+            continue;
+        if (collapse.cost > maxErrorSq)
+            break;
+
+        // Reject collapses that would flip a surviving triangle
+        bool flips = false;
+        for (const auto t : adjacency[from])
+        {
+            if (!triangleAlive[t])
+                continue;
+
+            const auto* tri = &triangles[t * 3];
+            if (tri[0] == to || tri[1] == to || tri[2] == to)
+                continue;
+
+            const auto before = triangleNormal(tri[0], tri[1], tri[2]);
+            const auto after = triangleNormal(tri[0] == from ? to : tri[0], tri[1] == from ? to : tri[1], tri[2] == from ? to : tri[2]);
+            if (glm::dot(before, after) <= 0.0)
+            {
+                flips = true;
+                break;
+            }
+        }
+        if (flips)
+            continue;
+
+        collapsedInto[from] = to;
+        quadrics[to] += quadrics[from];
+        ++versions[to];
+        worstError = std::max(worstError, collapse.cost);
+
+        for (const auto t : adjacency[from])
+        {
+            if (!triangleAlive[t])
+                continue;
+
+            auto* tri = &triangles[t * 3];
+            if (tri[0] == to || tri[1] == to || tri[2] == to)
+            {
+                triangleAlive[t] = false;
+                liveIndexCount -= 3;
+                continue;
+            }
+
+            for (std::uint32_t i = 0; i < 3; ++i)
+            {
+                if (tri[i] == from)
+                    tri[i] = to;
+            }
+            adjacency[to].push_back(t);
+        }
+        adjacency[from] = {};
+
+        auto& toAdjacency = adjacency[to];
+        toAdjacency.erase(std::remove_if(toAdjacency.begin(), toAdjacency.end(), [&](const std::uint32_t t) { return !triangleAlive[t]; }), toAdjacency.end());
+
+        for (const auto t : toAdjacency)
+        {
+            for (std::uint32_t i = 0; i < 3; ++i)
+            {
+                const auto neighbour = triangles[t * 3 + i];
+                if (neighbour != to)
+                    pushEdge(to, neighbour);
+            }
+        }
+    }
+
+    SimplifyResult result;
+    result.indices.reserve(liveIndexCount);
+    for (std::uint32_t t = 0; t < triangleCount; ++t)
+    {
+        if (triangleAlive[t])
+            result.indices.insert(result.indices.end(), triangles.begin() + t * 3, triangles.begin() + t * 3 + 3);
+    }
+    result.error = static_cast<float>(std::sqrt(worstError));
+
+    return result;
+}
+
+/* Each level targets `reduction` times the previous level's index count, until `minIndexCount` or no further progress */
+inline auto generateLodChain(const std::uint32_t* indices,
+                             const std::size_t indexCount,
+                             const void* vertices,
+                             const std::size_t vertexCount,
+                             const std::size_t vertexStride,
+                             const std::size_t positionOffset = 0,
+                             const std::uint32_t maxLevels = 8,
+                             const float reduction = 0.5f,
+                             const std::size_t minIndexCount = 192) -> LodChain
+{
+    LodChain chain;
+    chain.indices.assign(indices, indices + indexCount);
+    chain.levels.push_back({ 0, static_cast<std::uint32_t>(indexCount), 0.0f });
+
+    std::vector<std::uint32_t> previous(indices, indices + indexCount);
+    float accumulatedError = 0.0f;
+
+    while (chain.levels.size() < maxLevels && previous.size() > minIndexCount)
+    {
+        const auto target = static_cast<std::size_t>(static_cast<float>(previous.size()) * reduction) / 3 * 3;
+        auto result = simplifyMesh(previous.data(), previous.size(), vertices, vertexCount, vertexStride, positionOffset, target);
+
+        // Stop once simplification stalls, eg. everything left is locked by flip checks
+        if (result.indices.size() > previous.size() * 0.9f || result.indices.empty())
+            break;
+
+        // Errors are measured against the previous level, so accumulate for a conservative bound against the source
+        accumulatedError += result.error;
+        chain.levels.push_back({ static_cast<std::uint32_t>(chain.indices.size()), static_cast<std::uint32_t>(result.indices.size()), accumulatedError });
+        chain.indices.insert(chain.indices.end(), result.indices.begin(), result.indices.end());
+
+        previous = std::move(result.indices);
+    }
+
+    return chain;
+}
+
+/* Runs generateLodChain on a worker thread. The input data is copied so the caller may release it immediately. */
+inline auto generateLodChainAsync(std::vector<std::uint32_t> indices,
+                                  std::vector<std::uint8_t> vertices,
+                                  const std::size_t vertexStride,
+                                  const std::size_t positionOffset = 0,
+                                  const std::uint32_t maxLevels = 8) -> std::future<LodChain>
+{
+    return std::async(std::launch::async, [indices = std::move(indices), vertices = std::move(vertices), vertexStride, positionOffset, maxLevels]() {
+        return generateLodChain(indices.data(), indices.size(), vertices.data(), vertices.size() / vertexStride, vertexStride, positionOffset, maxLevels);
+    });
+}
+
+/* Picks the coarsest level whose error projects to at most `maxPixelError` pixels at `distance` from the camera */
+inline auto selectLod(const LodChain& chain, const float distance, const float fovY, const float screenHeight, const float maxPixelError = 1.0f) -> std::size_t
+{
+    const auto pixelsPerUnit = screenHeight / (2.0f * std::tan(fovY * 0.5f) * std::max(distance, 1e-4f));
+
+    std::size_t selected = 0;
+    for (std::size_t i = 1; i < chain.levels.size(); ++i)
+    {
+        if (chain.levels[i].error * pixelsPerUnit > maxPixelError)
+            break;
+        selected = i;
+    }
+    return selected;
+}
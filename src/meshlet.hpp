@@ -0,0 +1,264 @@
+#pragma once
+
+#include "draw_batch.hpp"
+#include "frustum.hpp"
+#include "simd.hpp"
+
+#include <glm/ext/vector_float3.hpp>
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+struct Meshlet
+{
+    std::uint32_t firstIndex = 0;
+    std::uint32_t indexCount = 0;
+    std::uint32_t vertexCount = 0;
+};
+
+// Meshlets index into `indices`, which is the source index buffer reordered so each meshlet is contiguous.
+// Bounds are stored as structure-of-arrays, padded to a multiple of 4 for the SIMD culling pass.
+struct MeshletSet
+{
+    std::vector<std::uint32_t> indices;
+    std::vector<Meshlet> meshlets;
+
+    // Bounding sphere
+    std::vector<float> centreX, centreY, centreZ, radius;
+    // Normal cone. The meshlet is back facing when dot(centre - camera, axis) >= cutoff * |centre - camera| + radius.
+    std::vector<float> axisX, axisY, axisZ, cutoff;
+};
+
+struct MeshletCullStats
+{
+    std::uint32_t meshlets = 0, visibleMeshlets = 0;
+    std::uint64_t triangles = 0, visibleTriangles = 0;
+};
+
+/* Greedily packs triangles, in order, into meshlets. Run optimiseVertexCache first for tighter meshlets. */
+inline auto buildMeshlets(const std::uint32_t* indices,
+                          const std::size_t indexCount,
+                          const void* vertices,
+                          const std::size_t vertexCount,
+                          const std::size_t vertexStride,
+                          const std::size_t positionOffset = 0,
+                          const std::uint32_t maxVertices = 64,
+                          const std::uint32_t maxTriangles = 124) -> MeshletSet
+{
+    const auto* vertexBytes = static_cast<const std::uint8_t*>(vertices);
+    auto position = [&](const std::uint32_t v) {
+        glm::vec3 p;
+        std::memcpy(&p, vertexBytes + v * vertexStride + positionOffset, sizeof(p));
+        return p;
+    };
+
+    MeshletSet set;
+    set.indices.assign(indices, indices + indexCount / 3 * 3);
+
+    // Partition into meshlets
+    {
+        std::vector<std::uint32_t> stamp(vertexCount, ~0u);
+        Meshlet current;
+        for (std::size_t t = 0; t < set.indices.size() / 3; ++t)
+        {
+            const auto* tri = &set.indices[t * 3];
+
+            // Stamps from earlier meshlets go stale as soon as the meshlet id moves on
+            auto meshletId = static_cast<std::uint32_t>(set.meshlets.size());
+            auto newVertices = 0u;
+            for (std::uint32_t i = 0; i < 3; ++i)
+                newVertices += stamp[tri[i]] != meshletId;
+
+            if (current.vertexCount + newVertices > maxVertices || current.indexCount / 3 + 1 > maxTriangles)
+            {
+                set.meshlets.push_back(current);
+                current = { static_cast<std::uint32_t>(t * 3), 0, 0 };
+                ++meshletId;
+                newVertices = 3;
+            }
+
+            for (std::uint32_t i = 0; i < 3; ++i)
+                stamp[tri[i]] = meshletId;
+            current.vertexCount += newVertices;
+            current.indexCount += 3;
+        }
+
+        if (current.indexCount > 0)
+            set.meshlets.push_back(current);
+    }
+
+    const auto paddedCount = (set.meshlets.size() + 3) / 4 * 4;
+    for (auto* stream : { &set.centreX, &set.centreY, &set.centreZ, &set.axisX, &set.axisY, &set.axisZ })
+        stream->assign(paddedCount, 0.0f);
+    set.radius.assign(paddedCount, -1.0f); // Padding lanes always fail the frustum test
+    set.cutoff.assign(paddedCount, 1.0f);
+
+    std::vector<glm::vec3> points;
+    for (std::size_t m = 0; m < set.meshlets.size(); ++m)
+    {
+        const auto& meshlet = set.meshlets[m];
+        const auto* meshletIndices = &set.indices[meshlet.firstIndex];
+
+        points.clear();
+        for (std::uint32_t i = 0; i < meshlet.indexCount; ++i)
+            points.push_back(position(meshletIndices[i]));
+
+        // Ritter's bounding sphere
+        auto farthestFrom = [&](const glm::vec3& p) {
+            auto closer = [&](const glm::vec3& lhs, const glm::vec3& rhs) { return glm::dot(lhs - p, lhs - p) < glm::dot(rhs - p, rhs - p); };
+            return *std::max_element(points.begin(), points.end(), closer);
+        };
+        const auto a = farthestFrom(points[0]);
+        const auto b = farthestFrom(a);
+        auto centre = (a + b) * 0.5f;
+        auto radius = glm::length(b - a) * 0.5f;
+        for (const auto& p : points)
+        {
+            const auto distance = glm::length(p - centre);
+            if (distance > radius)
+            {
+                const auto newRadius = (radius + distance) * 0.5f;
+                centre += (p - centre) * ((newRadius - radius) / distance);
+                radius = newRadius;
+            }
+        }
+
+        // Normal cone from the average of the triangle normals
+        glm::vec3 axis(0.0f);
+        std::vector<glm::vec3> normals;
+        normals.reserve(meshlet.indexCount / 3);
+        for (std::uint32_t t = 0; t < meshlet.indexCount; t += 3)
+        {
+            const auto n = glm::cross(points[t + 1] - points[t], points[t + 2] - points[t]);
+            const auto length = glm::length(n);
+            if (length > 0.0f)
+            {
+                normals.push_back(n / length);
+                axis += normals.back();
+            }
+        }
+
+        float cutoff = 1.0f;
+        const auto axisLength = glm::length(axis);
+        if (axisLength > 0.0f)
+        {
+            axis /= axisLength;
+
+            float minDot = 1.0f;
+            for (const auto& n : normals)
+                minDot = std::min(minDot, glm::dot(n, axis));
+
+            // Wide cones are practically never back facing, so don't bother testing them
+            if (minDot > 0.1f)
+                cutoff = std::sqrt(1.0f - minDot * minDot);
+        }
+
+        set.centreX[m] = centre.x;
+        set.centreY[m] = centre.y;
+        set.centreZ[m] = centre.z;
+        set.radius[m] = radius;
+        set.axisX[m] = axis.x;
+        set.axisY[m] = axis.y;
+        set.axisZ[m] = axis.z;
+        set.cutoff[m] = cutoff;
+    }
+
+    return set;
+}
+
+/* Returns a bit per meshlet in [first, first + 4) that survives both the frustum and cone tests */
+inline auto cullMeshlets4(const MeshletSet& set, const std::size_t first, const Frustum& frustum, const glm::vec3& cameraPos) -> std::uint32_t
+{
+#if defined(SIMD_SSE2)
+    const auto cx = _mm_loadu_ps(&set.centreX[first]);
+    const auto cy = _mm_loadu_ps(&set.centreY[first]);
+    const auto cz = _mm_loadu_ps(&set.centreZ[first]);
+    const auto r = _mm_loadu_ps(&set.radius[first]);
+    const auto negR = _mm_sub_ps(_mm_setzero_ps(), r);
+
+    auto visible = _mm_cmpge_ps(r, _mm_setzero_ps());
+    for (const auto& plane : frustum.planes)
+    {
+        auto d = _mm_add_ps(_mm_mul_ps(cx, _mm_set1_ps(plane.x)), _mm_mul_ps(cy, _mm_set1_ps(plane.y)));
+        d = _mm_add_ps(_mm_add_ps(d, _mm_mul_ps(cz, _mm_set1_ps(plane.z))), _mm_set1_ps(plane.w));
+        visible = _mm_and_ps(visible, _mm_cmpge_ps(d, negR));
+    }
+
+    const auto vx = _mm_sub_ps(cx, _mm_set1_ps(cameraPos.x));
+    const auto vy = _mm_sub_ps(cy, _mm_set1_ps(cameraPos.y));
+    const auto vz = _mm_sub_ps(cz, _mm_set1_ps(cameraPos.z));
+    auto coneDot = _mm_add_ps(_mm_mul_ps(vx, _mm_loadu_ps(&set.axisX[first])), _mm_mul_ps(vy, _mm_loadu_ps(&set.axisY[first])));
+    coneDot = _mm_add_ps(coneDot, _mm_mul_ps(vz, _mm_loadu_ps(&set.axisZ[first])));
+    const auto distance = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz)));
+    const auto backFacing = _mm_cmpge_ps(coneDot, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&set.cutoff[first]), distance), r));
+
+    return static_cast<std::uint32_t>(_mm_movemask_ps(_mm_andnot_ps(backFacing, visible)));
+#else
+    std::uint32_t mask = 0;
+    for (std::size_t lane = 0; lane < 4; ++lane)
+    {
+        const auto i = first + lane;
+        const glm::vec3 centre(set.centreX[i], set.centreY[i], set.centreZ[i]);
+        if (set.radius[i] < 0.0f || !frustum.intersectsSphere(centre, set.radius[i]))
+            continue;
+
+        const auto view = centre - cameraPos;
+        const glm::vec3 axis(set.axisX[i], set.axisY[i], set.axisZ[i]);
+        if (glm::dot(view, axis) >= set.cutoff[i] * glm::length(view) + set.radius[i])
+            continue;
+
+        mask |= 1u << lane;
+    }
+    return mask;
+#endif
+}
+
+/* Appends one indirect command per run of contiguous visible meshlets. `frustum` and `cameraPos` must be in the mesh's object space
+   (eg. build the frustum from the model-view-projection). `firstIndex`/`baseVertex` locate `set.indices` in the index buffer. */
+inline auto cullMeshlets(const MeshletSet& set,
+                         const Frustum& frustum,
+                         const glm::vec3& cameraPos,
+                         const GLuint firstIndex,
+                         const GLint baseVertex,
+                         const GLuint baseInstance,
+                         std::vector<DrawElementsIndirectCommand>& commands) -> MeshletCullStats
+{
+    MeshletCullStats stats;
+    stats.meshlets = static_cast<std::uint32_t>(set.meshlets.size());
+    stats.triangles = set.indices.size() / 3;
+
+    DrawElementsIndirectCommand* run = nullptr;
+    for (std::size_t first = 0; first < set.meshlets.size(); first += 4)
+    {
+        const auto mask = cullMeshlets4(set, first, frustum, cameraPos);
+        const auto laneCount = std::min<std::size_t>(4, set.meshlets.size() - first);
+
+        for (std::size_t lane = 0; lane < laneCount; ++lane)
+        {
+            if ((mask & (1u << lane)) == 0)
+            {
+                run = nullptr;
+                continue;
+            }
+
+            const auto& meshlet = set.meshlets[first + lane];
+            ++stats.visibleMeshlets;
+            stats.visibleTriangles += meshlet.indexCount / 3;
+
+            if (run != nullptr)
+            {
+                run->count += meshlet.indexCount;
+                continue;
+            }
+
+            commands.push_back({ meshlet.indexCount, 1, firstIndex + meshlet.firstIndex, baseVertex, baseInstance });
+            run = &commands.back();
+        }
+    }
+
+    return stats;
+}
@@ -0,0 +1,384 @@
+#pragma once
+
+#include "simd.hpp"
+#include "thread_pool.hpp"
+
+#include <glm/common.hpp>
+#include <glm/ext/matrix_float4x4.hpp>
+#include <glm/ext/vector_float3.hpp>
+#include <glm/ext/vector_float4.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <latch>
+#include <limits>
+#include <vector>
+
+// Low resolution software depth buffer for occlusion culling. Occluders (ideally simplified, eg. a coarse LOD from
+// generateLodChain) are rasterised on the CPU, then a max-depth hierarchy is built so object bounds can be tested against
+// it in a handful of texel reads. Depth is window space [0, 1], nearer is smaller, and the buffer's row 0 is the bottom.
+class OcclusionBuffer
+{
+public:
+    /* Width must be a multiple of 4 */
+    void init(std::uint32_t width = 256, std::uint32_t height = 128);
+
+    /* Resets the depth buffer and drops all queued occluders */
+    void clear();
+
+    /* Clips, projects and queues front facing (CCW) triangles. `modelViewProjection` maps the positions to clip space. */
+    void addOccluder(const void* vertices,
+                     std::size_t vertexCount,
+                     std::size_t vertexStride,
+                     std::size_t positionOffset,
+                     const std::uint32_t* indices,
+                     std::size_t indexCount,
+                     const glm::mat4& modelViewProjection);
+
+    /* Rasterises the queued occluders, split into horizontal bands across `pool` if given, and builds the hierarchy */
+    void rasterise(ThreadPool* pool = nullptr);
+
+    /* False only if the box is entirely behind the occluders or entirely off screen. Boxes crossing the near plane are always visible. */
+    bool isVisible(const glm::vec3& min, const glm::vec3& max, const glm::mat4& modelViewProjection) const;
+
+    auto width() const -> std::uint32_t;
+    auto height() const -> std::uint32_t;
+    auto levelCount() const -> std::uint32_t;
+    /* Level 0 is the full resolution depth buffer, each level above holds the farthest depth of 2x2 texels below */
+    auto depth(std::uint32_t level) const -> const std::vector<float>&;
+    auto triangleCount() const -> std::uint32_t;
+
+private:
+    // Edge functions and depth plane in pixel space, evaluated at pixel centres
+    struct Triangle
+    {
+        std::array<float, 3> edgeA, edgeB, edgeC;
+        std::array<bool, 3> topLeft;
+        float depthA, depthB, depthC;
+        std::int32_t minX, maxX, minY, maxY;
+    };
+
+    struct Level
+    {
+        std::uint32_t width = 0, height = 0;
+        std::vector<float> depth;
+    };
+
+    static constexpr std::uint32_t BandHeight = 16;
+
+    void setupTriangle(const glm::vec4& c0, const glm::vec4& c1, const glm::vec4& c2);
+    void rasteriseBand(std::int32_t firstRow, std::int32_t lastRow);
+    void buildHierarchy();
+
+private:
+    std::uint32_t m_width = 0, m_height = 0;
+    std::vector<Level> m_levels;
+    std::vector<Triangle> m_triangles;
+};
+
+inline void OcclusionBuffer::init(const std::uint32_t width, const std::uint32_t height)
+{
+    assert(width % 4 == 0 && "OcclusionBuffer width must be a multiple of 4!");
+
+    m_width = width;
+    m_height = height;
+
+    m_levels.clear();
+    auto levelWidth = width, levelHeight = height;
+    while (true)
+    {
+        m_levels.push_back({ levelWidth, levelHeight, std::vector<float>(levelWidth * levelHeight, 1.0f) });
+        if (levelWidth == 1 && levelHeight == 1)
+            break;
+        levelWidth = std::max(1u, (levelWidth + 1) / 2);
+        levelHeight = std::max(1u, (levelHeight + 1) / 2);
+    }
+
+    clear();
+}
+
+inline void OcclusionBuffer::clear()
+{
+    for (auto& level : m_levels)
+        std::fill(level.depth.begin(), level.depth.end(), 1.0f);
+    m_triangles.clear();
+}
+
+inline void OcclusionBuffer::addOccluder(const void* vertices,
+                                         const std::size_t vertexCount,
+                                         const std::size_t vertexStride,
+                                         const std::size_t positionOffset,
+                                         const std::uint32_t* indices,
+                                         const std::size_t indexCount,
+                                         const glm::mat4& modelViewProjection)
+{
+    const auto* vertexBytes = static_cast<const std::uint8_t*>(vertices);
+    std::vector<glm::vec4> clip(vertexCount);
+    for (std::size_t v = 0; v < vertexCount; ++v)
+    {
+        glm::vec3 p;
+        std::memcpy(&p, vertexBytes + v * vertexStride + positionOffset, sizeof(p));
+        clip[v] = modelViewProjection * glm::vec4(p, 1.0f);
+    }
+
+    for (std::size_t i = 0; i + 2 < indexCount; i += 3)
+    {
+        const std::array<glm::vec4, 3> triangle = { clip[indices[i]], clip[indices[i + 1]], clip[indices[i + 2]] };
+
+        // Only the near plane needs clipping (z >= -w), everything else is handled by the screen bounds
+        const auto inside = [](const glm::vec4& c) { return c.z + c.w; };
+        if (inside(triangle[0]) >= 0.0f && inside(triangle[1]) >= 0.0f && inside(triangle[2]) >= 0.0f)
+        {
+            setupTriangle(triangle[0], triangle[1], triangle[2]);
+            continue;
+        }
+
+        std::array<glm::vec4, 4> polygon;
+        std::size_t polygonSize = 0;
+        for (std::size_t e = 0; e < 3; ++e)
+        {
+            const auto& a = triangle[e];
+            const auto& b = triangle[(e + 1) % 3];
+            const auto da = inside(a), db = inside(b);
+            if (da >= 0.0f)
+                polygon[polygonSize++] = a;
+            if ((da >= 0.0f) != (db >= 0.0f))
+                polygon[polygonSize++] = a + (b - a) * (da / (da - db));
+        }
+
+        for (std::size_t v = 2; v < polygonSize; ++v)
+            setupTriangle(polygon[0], polygon[v - 1], polygon[v]);
+    }
+}
+
+inline void OcclusionBuffer::rasterise(ThreadPool* pool)
+{
+    const auto bandCount = (m_height + BandHeight - 1) / BandHeight;
+    auto band = [&](const std::uint32_t b) {
+        const auto firstRow = static_cast<std::int32_t>(b * BandHeight);
+        rasteriseBand(firstRow, std::min(firstRow + static_cast<std::int32_t>(BandHeight), static_cast<std::int32_t>(m_height)) - 1);
+    };
+
+    // Bands own disjoint rows, so they can be rasterised concurrently without any synchronisation
+    if (pool == nullptr || bandCount <= 1)
+    {
+        for (std::uint32_t b = 0; b < bandCount; ++b)
+            band(b);
+    }
+    else
+    {
+        std::latch done(bandCount);
+        for (std::uint32_t b = 0; b < bandCount; ++b)
+        {
+            pool->submit([&, b] {
+                band(b);
+                done.count_down();
+            });
+        }
+        done.wait();
+    }
+
+    buildHierarchy();
+}
+
+inline bool OcclusionBuffer::isVisible(const glm::vec3& min, const glm::vec3& max, const glm::mat4& modelViewProjection) const
+{
+    glm::vec3 screenMin(std::numeric_limits<float>::max());
+    glm::vec3 screenMax(-std::numeric_limits<float>::max());
+    for (std::uint32_t corner = 0; corner < 8; ++corner)
+    {
+        const glm::vec3 p(corner & 1 ? max.x : min.x, corner & 2 ? max.y : min.y, corner & 4 ? max.z : min.z);
+        const auto clip = modelViewProjection * glm::vec4(p, 1.0f);
+        if (clip.z < -clip.w || clip.w <= 0.0f)
+            return true;
+
+        const auto ndc = glm::vec3(clip) / clip.w;
+        screenMin = glm::min(screenMin, ndc);
+        screenMax = glm::max(screenMax, ndc);
+    }
+
+    const auto toPixelX = [&](const float x) { return (x * 0.5f + 0.5f) * m_width; };
+    const auto toPixelY = [&](const float y) { return (y * 0.5f + 0.5f) * m_height; };
+    auto x0 = static_cast<std::int32_t>(std::floor(toPixelX(screenMin.x)));
+    auto x1 = static_cast<std::int32_t>(std::floor(toPixelX(screenMax.x)));
+    auto y0 = static_cast<std::int32_t>(std::floor(toPixelY(screenMin.y)));
+    auto y1 = static_cast<std::int32_t>(std::floor(toPixelY(screenMax.y)));
+    if (x1 < 0 || y1 < 0 || x0 >= static_cast<std::int32_t>(m_width) || y0 >= static_cast<std::int32_t>(m_height))
+        return false;
+
+    x0 = std::max(x0, 0);
+    y0 = std::max(y0, 0);
+    x1 = std::min(x1, static_cast<std::int32_t>(m_width) - 1);
+    y1 = std::min(y1, static_cast<std::int32_t>(m_height) - 1);
+
+    // Go up the hierarchy until the rect covers at most 2x2 texels
+    std::uint32_t level = 0;
+    while (level + 1 < m_levels.size() && ((x1 >> level) - (x0 >> level) > 1 || (y1 >> level) - (y0 >> level) > 1))
+        ++level;
+
+    const auto& depthLevel = m_levels[level];
+    float farthest = 0.0f;
+    for (auto y = y0 >> level; y <= (y1 >> level); ++y)
+    {
+        for (auto x = x0 >> level; x <= (x1 >> level); ++x)
+            farthest = std::max(farthest, depthLevel.depth[y * depthLevel.width + x]);
+    }
+
+    return screenMin.z * 0.5f + 0.5f <= farthest;
+}
+
+inline auto OcclusionBuffer::width() const -> std::uint32_t
+{
+    return m_width;
+}
+
+inline auto OcclusionBuffer::height() const -> std::uint32_t
+{
+    return m_height;
+}
+
+inline auto OcclusionBuffer::levelCount() const -> std::uint32_t
+{
+    return static_cast<std::uint32_t>(m_levels.size());
+}
+
+inline auto OcclusionBuffer::depth(const std::uint32_t level) const -> const std::vector<float>&
+{
+    return m_levels[level].depth;
+}
+
+inline auto OcclusionBuffer::triangleCount() const -> std::uint32_t
+{
+    return static_cast<std::uint32_t>(m_triangles.size());
+}
+
+inline void OcclusionBuffer::setupTriangle(const glm::vec4& c0, const glm::vec4& c1, const glm::vec4& c2)
+{
+    auto toScreen = [&](const glm::vec4& c) {
+        const auto ndc = glm::vec3(c) / c.w;
+        return glm::vec3((ndc.x * 0.5f + 0.5f) * m_width, (ndc.y * 0.5f + 0.5f) * m_height, ndc.z * 0.5f + 0.5f);
+    };
+    const std::array<glm::vec3, 3> v = { toScreen(c0), toScreen(c1), toScreen(c2) };
+
+    const auto area = (v[1].x - v[0].x) * (v[2].y - v[0].y) - (v[1].y - v[0].y) * (v[2].x - v[0].x);
+    if (!(area > 0.0f))
+        return; // Back facing, degenerate or NaN
+
+    Triangle triangle;
+    triangle.minX = std::max(0, static_cast<std::int32_t>(std::floor(std::min({ v[0].x, v[1].x, v[2].x }))));
+    triangle.maxX = std::min(static_cast<std::int32_t>(m_width) - 1, static_cast<std::int32_t>(std::ceil(std::max({ v[0].x, v[1].x, v[2].x }))));
+    triangle.minY = std::max(0, static_cast<std::int32_t>(std::floor(std::min({ v[0].y, v[1].y, v[2].y }))));
+    triangle.maxY = std::min(static_cast<std::int32_t>(m_height) - 1, static_cast<std::int32_t>(std::ceil(std::max({ v[0].y, v[1].y, v[2].y }))));
+    if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+        return;
+
+    // Edge i is opposite vertex i and is positive on the inside, so edge i / area is vertex i's barycentric weight
+    for (std::size_t i = 0; i < 3; ++i)
+    {
+        const auto& a = v[(i + 1) % 3];
+        const auto& b = v[(i + 2) % 3];
+        triangle.edgeA[i] = a.y - b.y;
+        triangle.edgeB[i] = b.x - a.x;
+        triangle.edgeC[i] = a.x * b.y - a.y * b.x;
+        // A shared edge has exactly negated coefficients in its two triangles, so this picks one owner for pixels on it
+        triangle.topLeft[i] = triangle.edgeA[i] > 0.0f || (triangle.edgeA[i] == 0.0f && triangle.edgeB[i] < 0.0f);
+    }
+
+    const auto invArea = 1.0f / area;
+    triangle.depthA = (triangle.edgeA[0] * v[0].z + triangle.edgeA[1] * v[1].z + triangle.edgeA[2] * v[2].z) * invArea;
+    triangle.depthB = (triangle.edgeB[0] * v[0].z + triangle.edgeB[1] * v[1].z + triangle.edgeB[2] * v[2].z) * invArea;
+    triangle.depthC = (triangle.edgeC[0] * v[0].z + triangle.edgeC[1] * v[1].z + triangle.edgeC[2] * v[2].z) * invArea;
+
+    m_triangles.push_back(triangle);
+}
+
+inline void OcclusionBuffer::rasteriseBand(const std::int32_t firstRow, const std::int32_t lastRow)
+{
+    auto* depth = m_levels[0].depth.data();
+
+    for (const auto& triangle : m_triangles)
+    {
+        const auto minY = std::max(triangle.minY, firstRow);
+        const auto maxY = std::min(triangle.maxY, lastRow);
+        // Pixels are processed in aligned groups of 4. Lanes outside the bounding box are still inside the row and are
+        // only written if the edge functions put them inside the triangle, so they need no extra masking.
+        const auto minX = triangle.minX & ~3;
+
+        for (auto y = minY; y <= maxY; ++y)
+        {
+            const auto py = static_cast<float>(y) + 0.5f;
+            auto* row = depth + static_cast<std::size_t>(y) * m_width;
+
+#if defined(SIMD_SSE2)
+            __m128 edgeA[3], edgeRow[3], topLeft[3];
+            for (std::size_t i = 0; i < 3; ++i)
+            {
+                edgeA[i] = _mm_set1_ps(triangle.edgeA[i]);
+                edgeRow[i] = _mm_set1_ps(triangle.edgeB[i] * py + triangle.edgeC[i]);
+                topLeft[i] = _mm_castsi128_ps(_mm_set1_epi32(triangle.topLeft[i] ? -1 : 0));
+            }
+            const auto depthA = _mm_set1_ps(triangle.depthA);
+            const auto depthRow = _mm_set1_ps(triangle.depthB * py + triangle.depthC);
+
+            for (auto x = minX; x <= triangle.maxX; x += 4)
+            {
+                const auto px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f));
+
+                // Top-left fill rule, otherwise pixels centred on shared edges are left as holes that poison the max hierarchy
+                auto inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+                for (std::size_t i = 0; i < 3; ++i)
+                {
+                    const auto edge = _mm_add_ps(_mm_mul_ps(edgeA[i], px), edgeRow[i]);
+                    const auto onEdge = _mm_and_ps(topLeft[i], _mm_cmpeq_ps(edge, _mm_setzero_ps()));
+                    inside = _mm_and_ps(inside, _mm_or_ps(_mm_cmpgt_ps(edge, _mm_setzero_ps()), onEdge));
+                }
+                if (_mm_movemask_ps(inside) == 0)
+                    continue;
+
+                const auto z = _mm_add_ps(_mm_mul_ps(depthA, px), depthRow);
+                const auto current = _mm_loadu_ps(row + x);
+                const auto nearest = _mm_min_ps(current, z);
+                _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, current)));
+            }
+#else
+            for (auto x = minX; x <= triangle.maxX; ++x)
+            {
+                const auto px = static_cast<float>(x) + 0.5f;
+                bool inside = true;
+                for (std::size_t i = 0; i < 3; ++i)
+                {
+                    const auto edge = triangle.edgeA[i] * px + triangle.edgeB[i] * py + triangle.edgeC[i];
+                    inside = inside && (edge > 0.0f || (edge == 0.0f && triangle.topLeft[i]));
+                }
+
+                if (inside)
+                    row[x] = std::min(row[x], triangle.depthA * px + triangle.depthB * py + triangle.depthC);
+            }
+#endif
+        }
+    }
+}
+
+inline void OcclusionBuffer::buildHierarchy()
+{
+    for (std::size_t l = 1; l < m_levels.size(); ++l)
+    {
+        const auto& source = m_levels[l - 1];
+        auto& level = m_levels[l];
+        for (std::uint32_t y = 0; y < level.height; ++y)
+        {
+            const auto y0 = std::min(y * 2, source.height - 1), y1 = std::min(y * 2 + 1, source.height - 1);
+            for (std::uint32_t x = 0; x < level.width; ++x)
+            {
+                const auto x0 = std::min(x * 2, source.width - 1), x1 = std::min(x * 2 + 1, source.width - 1);
+                const auto& d = source.depth;
+                level.depth[y * level.width + x] = std::max(std::max(d[y0 * source.width + x0], d[y0 * source.width + x1]),
+                                                            std::max(d[y1 * source.width + x0], d[y1 * source.width + x1]));
+            }
+        }
+    }
+}
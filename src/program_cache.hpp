@@ -0,0 +1,204 @@
+#pragma once
+
+#include "hash.hpp"
+#include "mapped_file.hpp"
+
+#include <glad/glad.h>
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// On-disk cache of linked program binaries, one file per program:
+//
+//   [ProgramCacheHeader][glGetProgramBinary blob]
+//
+// The key covers the full source of every stage (so defines injected into the source are included) and the driver's
+// vendor, renderer and version strings, so a driver update invalidates the whole cache. Drivers may still reject a
+// binary, in which case the caller compiles from source and the entry is rewritten.
+constexpr std::array<char, 4> ProgramCacheMagic = { 'G', 'L', 'P', 'C' };
+constexpr std::uint32_t ProgramCacheVersion = 1;
+
+struct ProgramCacheHeader
+{
+    std::array<char, 4> magic = ProgramCacheMagic;
+    std::uint32_t version = ProgramCacheVersion;
+    std::uint64_t key = 0;
+    std::uint32_t binaryFormat = 0;
+    std::uint32_t binarySize = 0;
+};
+
+struct ProgramCacheStats
+{
+    std::uint32_t loaded = 0;   // Programs restored from a binary
+    std::uint32_t compiled = 0; // Programs built from source
+    std::uint32_t rejected = 0; // Binaries the driver refused
+    double loadMs = 0.0, compileMs = 0.0;
+};
+
+class ProgramCache
+{
+public:
+    /* Enables the cache. Requires a current context, and stays disabled if the driver exposes no binary formats. */
+    static void init(const char* directory);
+
+    static auto enabled() -> bool;
+
+    /* Mixes the driver identity into a hash of the program's sources */
+    static auto makeKey(std::uint64_t sourceHash) -> std::uint64_t;
+
+    /* Restores `program` from the cache. False on a miss or if the driver rejects the binary. */
+    static auto load(GLuint program, std::uint64_t key) -> bool;
+    /* `program` must be linked, with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set before linking */
+    static void store(GLuint program, std::uint64_t key);
+
+    static void recordLoad(double ms);
+    static void recordCompile(double ms);
+    static auto stats() -> const ProgramCacheStats&;
+
+private:
+    static auto path(std::uint64_t key) -> std::filesystem::path;
+
+private:
+    inline static std::filesystem::path m_directory;
+    inline static std::uint64_t m_driverHash = 0;
+    inline static bool m_enabled = false;
+    inline static ProgramCacheStats m_stats;
+};
+
+inline void ProgramCache::init(const char* directory)
+{
+    GLint formatCount = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+    if (formatCount == 0)
+    {
+        std::cerr << "[ProgramCache] Driver supports no program binary formats, cache disabled" << std::endl;
+        return;
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (error)
+    {
+        std::cerr << "[ProgramCache] Failed to create " << directory << ": " << error.message() << std::endl;
+        return;
+    }
+
+    auto hash = fnv1a64(ProgramCacheVersion);
+    for (const auto name : { GL_VENDOR, GL_RENDERER, GL_VERSION })
+    {
+        const auto* value = reinterpret_cast<const char*>(glGetString(name));
+        hash = fnv1a64(std::string_view(value != nullptr ? value : ""), hash);
+    }
+
+    m_directory = directory;
+    m_driverHash = hash;
+    m_enabled = true;
+}
+
+inline auto ProgramCache::enabled() -> bool
+{
+    return m_enabled;
+}
+
+inline auto ProgramCache::makeKey(const std::uint64_t sourceHash) -> std::uint64_t
+{
+    return fnv1a64(sourceHash, m_driverHash);
+}
+
+inline auto ProgramCache::load(const GLuint program, const std::uint64_t key) -> bool
+{
+    if (!m_enabled)
+        return false;
+
+    MappedFile file;
+    if (!file.open(path(key).string().c_str()) || file.size() < sizeof(ProgramCacheHeader))
+        return false;
+
+    const auto* header = reinterpret_cast<const ProgramCacheHeader*>(file.data());
+    if (header->magic != ProgramCacheMagic || header->version != ProgramCacheVersion || header->key != key ||
+        sizeof(ProgramCacheHeader) + header->binarySize > file.size())
+        return false;
+
+    glProgramBinary(program, header->binaryFormat, file.data() + sizeof(ProgramCacheHeader), static_cast<GLsizei>(header->binarySize));
+
+    GLint success = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        ++m_stats.rejected;
+        return false;
+    }
+    return true;
+}
+
+inline void ProgramCache::store(const GLuint program, const std::uint64_t key)
+{
+    if (!m_enabled)
+        return;
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+
+    std::vector<char> binary(static_cast<std::size_t>(length));
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &length, &format, binary.data());
+
+    ProgramCacheHeader header;
+    header.key = key;
+    header.binaryFormat = format;
+    header.binarySize = static_cast<std::uint32_t>(length);
+
+    // Write to a temporary and rename, so a crash mid-write never leaves a truncated entry behind
+    const auto target = path(key);
+    auto temporary = target;
+    temporary += ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file)
+        {
+            std::cerr << "[ProgramCache] Failed to open " << temporary.string() << " for writing" << std::endl;
+            return;
+        }
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(binary.data(), length);
+        if (!file.good())
+            return;
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporary, target, error);
+}
+
+inline void ProgramCache::recordLoad(const double ms)
+{
+    ++m_stats.loaded;
+    m_stats.loadMs += ms;
+}
+
+inline void ProgramCache::recordCompile(const double ms)
+{
+    ++m_stats.compiled;
+    m_stats.compileMs += ms;
+}
+
+inline auto ProgramCache::stats() -> const ProgramCacheStats&
+{
+    return m_stats;
+}
+
+inline auto ProgramCache::path(const std::uint64_t key) -> std::filesystem::path
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+    return m_directory / name;
+}
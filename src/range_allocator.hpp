@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <map>
+
+// Best-fit free-list allocator over an abstract [0, capacity) range. Adjacent free blocks are coalesced on free().
+class RangeAllocator
+{
+public:
+    static constexpr std::uint32_t InvalidOffset = ~0u;
+
+    void init(std::uint32_t capacity);
+
+    auto allocate(std::uint32_t size) -> std::uint32_t;
+    void free(std::uint32_t offset, std::uint32_t size);
+
+    auto capacity() const -> std::uint32_t;
+    auto used() const -> std::uint32_t;
+    auto largestFreeBlock() const -> std::uint32_t;
+    auto freeBlockCount() const -> std::size_t;
+
+    /* 0 when all free space is one contiguous block, approaching 1 as it splinters */
+    auto fragmentation() const -> float;
+
+private:
+    void insertFree(std::uint32_t offset, std::uint32_t size);
+    void eraseFree(std::map<std::uint32_t, std::uint32_t>::iterator it);
+
+private:
+    std::uint32_t m_capacity = 0;
+    std::uint32_t m_used = 0;
+
+    // offset -> size, and size -> offset for best-fit lookups
+    std::map<std::uint32_t, std::uint32_t> m_freeByOffset;
+    std::multimap<std::uint32_t, std::uint32_t> m_freeBySize;
+};
+
+inline void RangeAllocator::init(const std::uint32_t capacity)
+{
+    m_capacity = capacity;
+    m_used = 0;
+    m_freeByOffset.clear();
+    m_freeBySize.clear();
+
+    if (capacity > 0)
+        insertFree(0, capacity);
+}
+
+inline auto RangeAllocator::allocate(const std::uint32_t size) -> std::uint32_t
+{
+    if (size == 0)
+        return InvalidOffset;
+
+    auto bySize = m_freeBySize.lower_bound(size);
+    if (bySize == m_freeBySize.end())
+        return InvalidOffset;
+
+    const auto offset = bySize->second;
+    const auto blockSize = bySize->first;
+    eraseFree(m_freeByOffset.find(offset));
+
+    if (blockSize > size)
+        insertFree(offset + size, blockSize - size);
+
+    m_used += size;
+    return offset;
+}
+
+inline void RangeAllocator::free(std::uint32_t offset, std::uint32_t size)
+{
+    assert(offset + size <= m_capacity);
+    m_used -= size;
+
+    // Merge with following block
+    auto next = m_freeByOffset.find(offset + size);
+    if (next != m_freeByOffset.end())
+    {
+        size += next->second;
+        eraseFree(next);
+    }
+
+    // Merge with preceding block
+    auto prev = m_freeByOffset.lower_bound(offset);
+    if (prev != m_freeByOffset.begin())
+    {
+        --prev;
+        if (prev->first + prev->second == offset)
+        {
+            offset = prev->first;
+            size += prev->second;
+            eraseFree(prev);
+        }
+    }
+
+    insertFree(offset, size);
+}
+
+inline auto RangeAllocator::capacity() const -> std::uint32_t
+{
+    return m_capacity;
+}
+
+inline auto RangeAllocator::used() const -> std::uint32_t
+{
+    return m_used;
+}
+
+inline auto RangeAllocator::largestFreeBlock() const -> std::uint32_t
+{
+    return m_freeBySize.empty() ? 0 : m_freeBySize.rbegin()->first;
+}
+
+inline auto RangeAllocator::freeBlockCount() const -> std::size_t
+{
+    return m_freeByOffset.size();
+}
+
+inline auto RangeAllocator::fragmentation() const -> float
+{
+    const auto totalFree = m_capacity - m_used;
+    if (totalFree == 0)
+        return 0.0f;
+
+    return 1.0f - static_cast<float>(largestFreeBlock()) / static_cast<float>(totalFree);
+}
+
+inline void RangeAllocator::insertFree(const std::uint32_t offset, const std::uint32_t size)
+{
+    m_freeByOffset.emplace(offset, size);
+    m_freeBySize.emplace(size, offset);
+}
+
+inline void RangeAllocator::eraseFree(const std::map<std::uint32_t, std::uint32_t>::iterator it)
+{
+    auto [first, last] = m_freeBySize.equal_range(it->second);
+    for (; first != last; ++first)
+    {
+        if (first->second == it->first)
+        {
+            m_freeBySize.erase(first);
+            break;
+        }
+    }
+    m_freeByOffset.erase(it);
+}
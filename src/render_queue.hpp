@@ -0,0 +1,307 @@
+#pragma once
+
+#include "gl_state.hpp"
+#include "mesh.hpp"
+#include "shader.hpp"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+// 64-bit draw sort key, ordered as an unsigned integer. Most significant bits first:
+//
+//   opaque:      [pass:4][layer:4][0][program:12][material:12][mesh:15][depth:16]
+//   translucent: [pass:4][layer:4][1][far-to-near depth:24][program:12][material:12][mesh:7]
+//
+// Opaque draws are grouped by state and go front-to-back within a group, translucent draws go back-to-front and are
+// only grouped between draws at the same depth. Program and mesh are GL names truncated to their field, a collision just
+// costs a redundant bind. Depth is normalised to [0, 1], eg. view depth over the far plane.
+enum class Translucency : std::uint8_t
+{
+    Opaque,
+    Translucent,
+};
+
+constexpr std::uint32_t RenderKeyPassShift = 60;
+constexpr std::uint32_t RenderKeyLayerShift = 56;
+constexpr std::uint32_t RenderKeyTranslucentShift = 55;
+
+constexpr auto quantiseDepth(const float depth, const std::uint32_t bits) -> std::uint64_t
+{
+    const auto maxValue = static_cast<float>((1ull << bits) - 1);
+    return static_cast<std::uint64_t>(std::clamp(depth, 0.0f, 1.0f) * maxValue);
+}
+
+constexpr auto makeRenderKey(const std::uint8_t pass,
+                             const std::uint8_t layer,
+                             const Translucency translucency,
+                             const GLuint program,
+                             const std::uint16_t material,
+                             const GLuint mesh,
+                             const float depth) -> std::uint64_t
+{
+    auto field = [](const std::uint64_t value, const std::uint32_t bits, const std::uint32_t shift) { return (value & ((1ull << bits) - 1)) << shift; };
+
+    const auto key = field(pass, 4, RenderKeyPassShift) | field(layer, 4, RenderKeyLayerShift);
+    if (translucency == Translucency::Opaque)
+        return key | field(program, 12, 43) | field(material, 12, 31) | field(mesh, 15, 16) | quantiseDepth(depth, 16);
+
+    const auto farToNear = ((1ull << 24) - 1) - quantiseDepth(depth, 24);
+    return key | field(1, 1, RenderKeyTranslucentShift) | field(farToNear, 24, 31) | field(program, 12, 19) | field(material, 12, 7) | field(mesh, 7, 0);
+}
+
+constexpr auto renderKeyPass(const std::uint64_t key) -> std::uint8_t
+{
+    return static_cast<std::uint8_t>(key >> RenderKeyPassShift);
+}
+
+constexpr auto renderKeyTranslucent(const std::uint64_t key) -> bool
+{
+    return (key >> RenderKeyTranslucentShift) & 1;
+}
+
+struct RenderSortEntry
+{
+    std::uint64_t key = 0;
+    std::uint32_t index = 0;
+};
+
+// Stable LSD radix sort on the key, 8 bits per pass. All histograms are built in one read, and digits every key shares
+// (typically the pass and layer bytes) are skipped, so a frame usually needs far fewer than 8 scatter passes.
+// `scratch` is resized to match and left holding garbage.
+inline void radixSort(std::vector<RenderSortEntry>& entries, std::vector<RenderSortEntry>& scratch)
+{
+    constexpr std::uint32_t Digits = 8;
+    const auto count = entries.size();
+    if (count < 2)
+        return;
+
+    std::array<std::array<std::uint32_t, 256>, Digits> histograms = {};
+    for (const auto& entry : entries)
+    {
+        for (std::uint32_t digit = 0; digit < Digits; ++digit)
+            ++histograms[digit][(entry.key >> (digit * 8)) & 0xFF];
+    }
+
+    scratch.resize(count);
+    auto* source = entries.data();
+    auto* target = scratch.data();
+    for (std::uint32_t digit = 0; digit < Digits; ++digit)
+    {
+        const auto shift = digit * 8;
+        auto& histogram = histograms[digit];
+        if (histogram[(source[0].key >> shift) & 0xFF] == count)
+            continue;
+
+        // Counts to starting offsets
+        std::uint32_t offset = 0;
+        for (auto& bucket : histogram)
+            offset += std::exchange(bucket, offset);
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            const auto entry = source[i];
+            target[histogram[(entry.key >> shift) & 0xFF]++] = entry;
+        }
+        std::swap(source, target);
+    }
+
+    if (source != entries.data())
+        entries.swap(scratch);
+}
+
+template <typename Index>
+struct RenderCommand
+{
+    const Shader* shader = nullptr;
+    const Mesh<Index>* mesh = nullptr;
+    std::uint16_t material = 0;
+    GLsizei instanceCount = 1; // Above 1 uses Mesh::drawInstanced
+};
+
+struct RenderQueueStats
+{
+    std::uint32_t draws = 0;
+    std::uint32_t programChanges = 0;
+    std::uint32_t materialChanges = 0;
+    std::uint32_t meshChanges = 0;
+};
+
+// Records draws as compact commands with a sort key, sorts them once per frame and executes them binding only what
+// changes between consecutive draws. Passes run in order of their index. Materials are app-defined ids, bound through a
+// callback after the draw's program, and rebound whenever the program changes since their uniforms are per program.
+// The queue sets blending and depth writes itself when switching between opaque and translucent draws, and restores
+// opaque state (blending off, depth writes on) after the last draw.
+template <typename Index>
+class RenderQueue
+{
+public:
+    using MaterialBinder = std::function<void(std::uint16_t material)>;
+
+    void reserve(std::size_t drawCount);
+    void clear();
+
+    /* `depth` in [0, 1], see makeRenderKey */
+    void add(std::uint8_t pass,
+             std::uint8_t layer,
+             Translucency translucency,
+             const Shader& shader,
+             std::uint16_t material,
+             const Mesh<Index>& mesh,
+             float depth,
+             GLsizei instanceCount = 1);
+    /* With a key built by the caller, eg. to reuse keys that didn't change since the last frame */
+    void add(std::uint64_t key, const RenderCommand<Index>& command);
+
+    void sort();
+
+    /* Call after sort(). Commands, shaders and meshes must stay alive until then. */
+    void execute(const MaterialBinder& bindMaterial);
+    void execute(std::uint8_t pass, const MaterialBinder& bindMaterial);
+
+    auto size() const -> std::size_t;
+    /* Of the last execute() calls since clear() */
+    auto stats() const -> const RenderQueueStats&;
+
+private:
+    void execute(std::size_t first, std::size_t last, const MaterialBinder& bindMaterial);
+
+private:
+    std::vector<RenderCommand<Index>> m_commands;
+    std::vector<RenderSortEntry> m_entries, m_scratch;
+    RenderQueueStats m_stats;
+};
+
+template <typename Index>
+void RenderQueue<Index>::reserve(const std::size_t drawCount)
+{
+    m_commands.reserve(drawCount);
+    m_entries.reserve(drawCount);
+    m_scratch.reserve(drawCount);
+}
+
+template <typename Index>
+void RenderQueue<Index>::clear()
+{
+    m_commands.clear();
+    m_entries.clear();
+    m_stats = {};
+}
+
+template <typename Index>
+void RenderQueue<Index>::add(const std::uint8_t pass,
+                             const std::uint8_t layer,
+                             const Translucency translucency,
+                             const Shader& shader,
+                             const std::uint16_t material,
+                             const Mesh<Index>& mesh,
+                             const float depth,
+                             const GLsizei instanceCount)
+{
+    add(makeRenderKey(pass, layer, translucency, shader.id(), material, mesh.id(), depth), { &shader, &mesh, material, instanceCount });
+}
+
+template <typename Index>
+void RenderQueue<Index>::add(const std::uint64_t key, const RenderCommand<Index>& command)
+{
+    m_entries.push_back({ key, static_cast<std::uint32_t>(m_commands.size()) });
+    m_commands.push_back(command);
+}
+
+template <typename Index>
+void RenderQueue<Index>::sort()
+{
+    radixSort(m_entries, m_scratch);
+}
+
+template <typename Index>
+void RenderQueue<Index>::execute(const MaterialBinder& bindMaterial)
+{
+    execute(0, m_entries.size(), bindMaterial);
+}
+
+template <typename Index>
+void RenderQueue<Index>::execute(const std::uint8_t pass, const MaterialBinder& bindMaterial)
+{
+    // The pass is the top of the key, so it's one contiguous range of the sorted entries
+    auto byPass = [](const RenderSortEntry& entry, const std::uint8_t value) { return renderKeyPass(entry.key) < value; };
+    const auto first = std::lower_bound(m_entries.begin(), m_entries.end(), pass, byPass);
+    const auto last = std::lower_bound(first, m_entries.end(), static_cast<std::uint8_t>(pass + 1), byPass);
+    execute(first - m_entries.begin(), last - m_entries.begin(), bindMaterial);
+}
+
+template <typename Index>
+void RenderQueue<Index>::execute(const std::size_t first, const std::size_t last, const MaterialBinder& bindMaterial)
+{
+    const Shader* shader = nullptr;
+    const Mesh<Index>* mesh = nullptr;
+    std::uint32_t material = ~0u;
+    int translucent = -1;
+
+    for (auto i = first; i < last; ++i)
+    {
+        const auto& entry = m_entries[i];
+        const auto& command = m_commands[entry.index];
+
+        if (const int isTranslucent = renderKeyTranslucent(entry.key); isTranslucent != translucent)
+        {
+            translucent = isTranslucent;
+            GLState::setEnabled(GLCap::Blend, isTranslucent);
+            GLState::setDepthMask(isTranslucent ? GL_FALSE : GL_TRUE);
+            if (isTranslucent)
+                GLState::setBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+        }
+
+        // Material state (uniforms, usually) belongs to the program, so a new program needs its material bound again
+        if (command.shader != shader)
+        {
+            shader = command.shader;
+            shader->bind();
+            material = ~0u;
+            ++m_stats.programChanges;
+        }
+        if (command.material != material)
+        {
+            material = command.material;
+            if (bindMaterial)
+                bindMaterial(command.material);
+            ++m_stats.materialChanges;
+        }
+        if (command.mesh != mesh)
+        {
+            mesh = command.mesh;
+            mesh->bind();
+            ++m_stats.meshChanges;
+        }
+
+        if (command.instanceCount > 1)
+            mesh->drawInstanced(command.instanceCount);
+        else
+            mesh->draw();
+        ++m_stats.draws;
+    }
+
+    // Leave blending off and depth writes on for whatever renders next, eg. a clear
+    if (translucent == 1)
+    {
+        GLState::setEnabled(GLCap::Blend, false);
+        GLState::setDepthMask(GL_TRUE);
+    }
+}
+
+template <typename Index>
+auto RenderQueue<Index>::size() const -> std::size_t
+{
+    return m_commands.size();
+}
+
+template <typename Index>
+auto RenderQueue<Index>::stats() const -> const RenderQueueStats&
+{
+    return m_stats;
+}
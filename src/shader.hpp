@@ -1,5 +1,12 @@
 #pragma once
 
+#include "gl_handle.hpp"
+#include "gl_state.hpp"
+#include "hash.hpp"
+#include "program_cache.hpp"
+#include "uniform_block.hpp"
+#include "uniform_cache.hpp"
+
 #include <glad/glad.h>
 #include <glm/ext/matrix_float4x4.hpp>
 #include <glm/ext/vector_float2.hpp>
@@ -7,7 +14,14 @@
 #include <glm/ext/vector_float4.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <cassert>
+#include <chrono>
+#include <initializer_list>
 #include <iostream>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #define CHECK_SHADER(id)                                                                                                                                       \
     do                                                                                                                                                         \
@@ -22,92 +36,355 @@
         }                                                                                                                                                      \
     } while (false)
 
+// GL_KHR_parallel_shader_compile isn't part of the generated loader
+#ifndef GL_MAX_SHADER_COMPILER_THREADS_KHR
+    #define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#endif
+#ifndef GL_COMPLETION_STATUS_KHR
+    #define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+enum class ShaderStatus
+{
+    Empty,
+    Pending,
+    Ready,
+    Failed,
+};
+
 class Shader
 {
 public:
-    ~Shader();
+    /* Call once after loading GL. Uses GL_KHR_parallel_shader_compile when the driver exposes it. */
+    static void initParallelCompile(GLADloadproc loader);
+    static auto parallelCompile() -> bool;
 
+    /* Blocking builds */
     void init(const char* vertexSrc, const char* fragmentSrc);
+    void initCompute(const char* computeSrc);
+
+    /* Submit the compile and link without querying any status, so the driver can build many programs at once.
+       Submit every program first, then poll() each frame and keep drawing with a fallback until the program is ready. */
+    void initAsync(const char* vertexSrc, const char* fragmentSrc);
+    void initComputeAsync(const char* computeSrc);
+
+    /* Finishes a pending build once the driver reports it complete. Only blocks without parallel compile support. */
+    auto poll() -> ShaderStatus;
+    /* Blocks until a pending build is finished */
+    auto wait() -> ShaderStatus;
+    auto status() const -> ShaderStatus;
 
     void bind() const;
+    /* Binds and dispatches. Issue the glMemoryBarrier matching how the results are consumed afterwards. */
+    void dispatch(GLuint groupsX, GLuint groupsY = 1, GLuint groupsZ = 1) const;
+
+    /* Looks the name up in the table reflected at link time. Resolve once and keep the handle for per-frame updates. */
+    template <typename T>
+    auto uniform(UniformName name) const -> UniformHandle<T>;
+
+    /* DSA updates, the program doesn't need to be bound */
+    template <typename T>
+    void set(UniformHandle<T> handle, const T& value) const;
+    template <typename T>
+    void set(UniformHandle<T> handle, const T* values, GLsizei count) const;
+
+    void setInt(UniformName name, int value) const;
+    void setUint(UniformName name, GLuint value) const;
+    void setFloat(UniformName name, float value) const;
+    void setFloat2(UniformName name, const glm::vec2& value) const;
+    void setFloat3(UniformName name, const glm::vec3& value) const;
+    void setFloat4(UniformName name, const glm::vec4& value) const;
+    void setMat4(UniformName name, const glm::mat4& value) const;
+
+    /* Checks the program's declaration of T's block against UNIFORM_BLOCK and assigns it to `binding`. False (and nothing
+       assigned) on a mismatch. */
+    template <typename T>
+    auto bindBlock(GLuint binding) const -> bool;
+
+    auto uniforms() const -> const UniformCache&;
+    auto id() const -> GLuint;
 
-    void setFloat(const char* name, float value) const;
-    void setFloat2(const char* name, const glm::vec2& value) const;
-    void setFloat3(const char* name, const glm::vec3& value) const;
-    void setFloat4(const char* name, const glm::vec4& value) const;
-    void setMat4(const char* name, const glm::mat4& value) const;
+private:
+    struct StageSource
+    {
+        GLenum type = 0;
+        const char* src = nullptr;
+    };
+
+    /* Restores the program from ProgramCache when possible, otherwise starts compiling and linking it */
+    void submit(std::initializer_list<StageSource> stages);
+    /* Checks the compile and link results, then reflects and caches the program */
+    void finish();
 
 private:
-    GLuint m_program = 0;
+    GLProgram m_program;
+    UniformCache m_uniforms;
+
+    ShaderStatus m_status = ShaderStatus::Empty;
+    std::vector<GLShader> m_stages; // Only held while pending
+    std::uint64_t m_cacheKey = 0;
+    double m_submitMs = 0.0;
+
+    inline static bool m_parallelCompile = false;
 };
 
-inline Shader::~Shader()
+inline void Shader::initParallelCompile(const GLADloadproc loader)
+{
+    GLint extensionCount = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+    for (GLint i = 0; i < extensionCount && !m_parallelCompile; ++i)
+    {
+        const std::string_view extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+        m_parallelCompile = extension == "GL_KHR_parallel_shader_compile" || extension == "GL_ARB_parallel_shader_compile";
+    }
+
+    if (!m_parallelCompile)
+        return;
+
+    // Let the driver pick its own thread count
+    using MaxShaderCompilerThreads = void(APIENTRYP)(GLuint);
+    auto* maxThreads = reinterpret_cast<MaxShaderCompilerThreads>(loader("glMaxShaderCompilerThreadsKHR"));
+    if (maxThreads == nullptr)
+        maxThreads = reinterpret_cast<MaxShaderCompilerThreads>(loader("glMaxShaderCompilerThreadsARB"));
+    if (maxThreads != nullptr)
+        maxThreads(0xFFFFFFFF);
+}
+
+inline auto Shader::parallelCompile() -> bool
 {
-    glDeleteProgram(m_program);
+    return m_parallelCompile;
 }
 
 inline void Shader::init(const char* vertexSrc, const char* fragmentSrc)
 {
-    GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexSrc, nullptr);
-    glCompileShader(vertexShader);
-    CHECK_SHADER(vertexShader);
+    initAsync(vertexSrc, fragmentSrc);
+    wait();
+}
+
+inline void Shader::initCompute(const char* computeSrc)
+{
+    initComputeAsync(computeSrc);
+    wait();
+}
+
+inline void Shader::initAsync(const char* vertexSrc, const char* fragmentSrc)
+{
+    submit({ { GL_VERTEX_SHADER, vertexSrc }, { GL_FRAGMENT_SHADER, fragmentSrc } });
+}
+
+inline void Shader::initComputeAsync(const char* computeSrc)
+{
+    submit({ { GL_COMPUTE_SHADER, computeSrc } });
+}
 
-    GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentSrc, nullptr);
-    glCompileShader(fragmentShader);
-    CHECK_SHADER(fragmentShader);
+inline auto Shader::poll() -> ShaderStatus
+{
+    if (m_status != ShaderStatus::Pending)
+        return m_status;
 
-    m_program = glCreateProgram();
-    glAttachShader(m_program, vertexShader);
-    glAttachShader(m_program, fragmentShader);
-    glLinkProgram(m_program);
+    if (m_parallelCompile)
     {
-        int success;
-        glGetProgramiv(m_program, GL_LINK_STATUS, &success);
-        if (!success)
-        {
-            char infoLog[512];
-            glGetProgramInfoLog(m_program, 512, nullptr, infoLog);
-            std::cerr << "[OpenGL][Shader] " << infoLog << std::endl;
-        }
+        GLint complete = GL_FALSE;
+        glGetProgramiv(m_program.id(), GL_COMPLETION_STATUS_KHR, &complete);
+        if (!complete)
+            return m_status;
     }
 
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
+    finish();
+    return m_status;
+}
+
+inline auto Shader::wait() -> ShaderStatus
+{
+    if (m_status == ShaderStatus::Pending)
+        finish();
+    return m_status;
+}
+
+inline auto Shader::status() const -> ShaderStatus
+{
+    return m_status;
 }
 
 inline void Shader::bind() const
 {
-    glUseProgram(m_program);
+    GLState::useProgram(m_program.id());
+}
+
+inline void Shader::dispatch(const GLuint groupsX, const GLuint groupsY, const GLuint groupsZ) const
+{
+    bind();
+    glDispatchCompute(groupsX, groupsY, groupsZ);
+}
+
+template <typename T>
+auto Shader::uniform(const UniformName name) const -> UniformHandle<T>
+{
+    const auto* entry = m_uniforms.find(name.hash);
+    if (entry == nullptr)
+        return {};
+
+    // Booleans and samplers are set through int
+    assert((entry->type == UniformType<T>::glType || std::is_same_v<T, int>) && "Uniform type mismatch!");
+    return { entry->location };
+}
+
+template <typename T>
+void Shader::set(const UniformHandle<T> handle, const T& value) const
+{
+    set(handle, &value, 1);
+}
+
+template <typename T>
+void Shader::set(const UniformHandle<T> handle, const T* values, const GLsizei count) const
+{
+    const auto program = m_program.id();
+    if constexpr (std::is_same_v<T, int>)
+        glProgramUniform1iv(program, handle.location, count, values);
+    else if constexpr (std::is_same_v<T, GLuint>)
+        glProgramUniform1uiv(program, handle.location, count, values);
+    else if constexpr (std::is_same_v<T, float>)
+        glProgramUniform1fv(program, handle.location, count, values);
+    else if constexpr (std::is_same_v<T, glm::vec2>)
+        glProgramUniform2fv(program, handle.location, count, glm::value_ptr(*values));
+    else if constexpr (std::is_same_v<T, glm::vec3>)
+        glProgramUniform3fv(program, handle.location, count, glm::value_ptr(*values));
+    else if constexpr (std::is_same_v<T, glm::vec4>)
+        glProgramUniform4fv(program, handle.location, count, glm::value_ptr(*values));
+    else if constexpr (std::is_same_v<T, glm::mat4>)
+        glProgramUniformMatrix4fv(program, handle.location, count, GL_FALSE, glm::value_ptr(*values));
+    else
+        static_assert(sizeof(T) == 0, "Unsupported uniform type.");
+}
+
+inline void Shader::setInt(const UniformName name, const int value) const
+{
+    set(uniform<int>(name), value);
+}
+
+inline void Shader::setUint(const UniformName name, const GLuint value) const
+{
+    set(uniform<GLuint>(name), value);
+}
+
+inline void Shader::setFloat(const UniformName name, const float value) const
+{
+    set(uniform<float>(name), value);
+}
+
+inline void Shader::setFloat2(const UniformName name, const glm::vec2& value) const
+{
+    set(uniform<glm::vec2>(name), value);
+}
+
+inline void Shader::setFloat3(const UniformName name, const glm::vec3& value) const
+{
+    set(uniform<glm::vec3>(name), value);
+}
+
+inline void Shader::setFloat4(const UniformName name, const glm::vec4& value) const
+{
+    set(uniform<glm::vec4>(name), value);
+}
+
+inline void Shader::setMat4(const UniformName name, const glm::mat4& value) const
+{
+    set(uniform<glm::mat4>(name), value);
 }
 
-inline void Shader::setFloat(const char* name, const float value) const
+template <typename T>
+auto Shader::bindBlock(const GLuint binding) const -> bool
 {
-    auto loc = glGetUniformLocation(m_program, name);
-    glUniform1f(loc, value);
+    if (!checkBlockLayout<T>(m_program.id()))
+        return false;
+
+    const std::string name(UniformBlock<T>::name);
+    if constexpr (UniformBlock<T>::layout == BlockLayout::Std140)
+        glUniformBlockBinding(m_program.id(), glGetUniformBlockIndex(m_program.id(), name.c_str()), binding);
+    else
+        glShaderStorageBlockBinding(m_program.id(), glGetProgramResourceIndex(m_program.id(), GL_SHADER_STORAGE_BLOCK, name.c_str()), binding);
+    return true;
 }
 
-inline void Shader::setFloat2(const char* name, const glm::vec2& value) const
+inline auto Shader::uniforms() const -> const UniformCache&
 {
-    auto loc = glGetUniformLocation(m_program, name);
-    glUniform2f(loc, value.x, value.y);
+    return m_uniforms;
 }
 
-inline void Shader::setFloat3(const char* name, const glm::vec3& value) const
+inline auto Shader::id() const -> GLuint
 {
-    auto loc = glGetUniformLocation(m_program, name);
-    glUniform3f(loc, value.x, value.y, value.z);
+    return m_program.id();
 }
 
-inline void Shader::setFloat4(const char* name, const glm::vec4& value) const
+inline void Shader::submit(const std::initializer_list<StageSource> stages)
 {
-    auto loc = glGetUniformLocation(m_program, name);
-    glUniform4f(loc, value.x, value.y, value.z, value.w);
+    using Clock = std::chrono::steady_clock;
+    const auto start = Clock::now();
+    auto elapsedMs = [&] { return std::chrono::duration<double, std::milli>(Clock::now() - start).count(); };
+
+    auto sourceHash = Fnv1aOffset64;
+    for (const auto& stage : stages)
+        sourceHash = fnv1a64(std::string_view(stage.src), fnv1a64(stage.type, sourceHash));
+    m_cacheKey = ProgramCache::makeKey(sourceHash);
+    m_uniforms.clear();
+
+    if (ProgramCache::enabled())
+    {
+        auto program = GLProgram::create();
+        if (ProgramCache::load(program.id(), m_cacheKey))
+        {
+            m_program = std::move(program);
+            m_uniforms.reflect(m_program.id());
+            m_status = ShaderStatus::Ready;
+            ProgramCache::recordLoad(elapsedMs());
+            return;
+        }
+    }
+
+    m_program = GLProgram::create();
+    if (ProgramCache::enabled())
+        glProgramParameteri(m_program.id(), GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+    // No status queries here, they would force the driver to finish compiling before returning
+    m_stages.clear();
+    for (const auto& stage : stages)
+    {
+        auto shader = GLShader::create(stage.type);
+        glShaderSource(shader.id(), 1, &stage.src, nullptr);
+        glCompileShader(shader.id());
+        glAttachShader(m_program.id(), shader.id());
+        m_stages.push_back(std::move(shader));
+    }
+    glLinkProgram(m_program.id());
+
+    m_status = ShaderStatus::Pending;
+    m_submitMs = elapsedMs();
 }
 
-inline void Shader::setMat4(const char* name, const glm::mat4& value) const
+inline void Shader::finish()
 {
-    auto loc = glGetUniformLocation(m_program, name);
-    glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(value));
+    using Clock = std::chrono::steady_clock;
+    const auto start = Clock::now();
+
+    for (const auto& stage : m_stages)
+        CHECK_SHADER(stage.id());
+    m_stages.clear();
+
+    int success;
+    glGetProgramiv(m_program.id(), GL_LINK_STATUS, &success);
+    if (success)
+    {
+        m_uniforms.reflect(m_program.id());
+        ProgramCache::store(m_program.id(), m_cacheKey);
+        m_status = ShaderStatus::Ready;
+    }
+    else
+    {
+        char infoLog[512];
+        glGetProgramInfoLog(m_program.id(), 512, nullptr, infoLog);
+        std::cerr << "[OpenGL][Shader] " << infoLog << std::endl;
+        m_status = ShaderStatus::Failed;
+    }
+
+    ProgramCache::recordCompile(m_submitMs + std::chrono::duration<double, std::milli>(Clock::now() - start).count());
 }
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <span>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+struct PreprocessedSource
+{
+    std::string text;
+    /* Every file that contributed, the root first. Compiler messages "N:line" refer to files[N]. Files read from disk
+       are canonical paths, in-memory sources keep their names. */
+    std::vector<std::string> files;
+    bool valid = false;
+};
+
+// Resolves `#include "file"` in GLSL sources. Files are looked up relative to the including file, then in each include
+// directory. Sources registered with addSource() shadow files on disk, so built-in shaders need no files at all.
+// Each file is included at most once per expansion, which also breaks cycles. #line directives keep compiler messages
+// pointing at the original file and line.
+class ShaderPreprocessor
+{
+public:
+    void addIncludeDirectory(const std::filesystem::path& directory);
+    void addSource(const std::string& name, std::string source);
+
+    auto expand(const std::string& name) const -> PreprocessedSource;
+
+    /* Inserts a #define per entry after the #version line. Entries are "NAME" or "NAME VALUE". */
+    static auto injectDefines(std::string_view source, std::span<const std::string> defines) -> std::string;
+
+    /* The path of `name` as expand() would resolve it, empty for in-memory sources or missing files */
+    auto resolve(const std::string& name, const std::filesystem::path& from = {}) const -> std::filesystem::path;
+
+private:
+    auto read(const std::string& name, const std::filesystem::path& from, std::string& source, std::string& resolved) const -> bool;
+    auto expandFile(const std::string& name, const std::filesystem::path& from, PreprocessedSource& out, std::unordered_set<std::string>& included) const
+        -> bool;
+
+private:
+    std::vector<std::filesystem::path> m_includeDirectories;
+    std::unordered_map<std::string, std::string> m_sources;
+};
+
+inline void ShaderPreprocessor::addIncludeDirectory(const std::filesystem::path& directory)
+{
+    m_includeDirectories.push_back(directory);
+}
+
+inline void ShaderPreprocessor::addSource(const std::string& name, std::string source)
+{
+    m_sources[name] = std::move(source);
+}
+
+inline auto ShaderPreprocessor::expand(const std::string& name) const -> PreprocessedSource
+{
+    PreprocessedSource out;
+    std::unordered_set<std::string> included;
+    out.valid = expandFile(name, {}, out, included);
+    return out;
+}
+
+inline auto ShaderPreprocessor::injectDefines(const std::string_view source, const std::span<const std::string> defines) -> std::string
+{
+    if (defines.empty())
+        return std::string(source);
+
+    // #version has to stay the first statement
+    std::size_t insertAt = 0;
+    std::size_t versionLine = 0;
+    if (const auto version = source.find("#version"); version != std::string_view::npos)
+    {
+        const auto end = source.find('\n', version);
+        insertAt = end == std::string_view::npos ? source.size() : end + 1;
+        versionLine = static_cast<std::size_t>(std::count(source.begin(), source.begin() + version, '\n')) + 1;
+    }
+
+    std::string result(source.substr(0, insertAt));
+    if (!result.empty() && result.back() != '\n')
+        result += '\n';
+    for (const auto& define : defines)
+        result += "#define " + define + "\n";
+    result += "#line " + std::to_string(versionLine + 1) + " 0\n";
+    result += source.substr(insertAt);
+    return result;
+}
+
+inline auto ShaderPreprocessor::resolve(const std::string& name, const std::filesystem::path& from) const -> std::filesystem::path
+{
+    if (m_sources.contains(name))
+        return {};
+
+    if (!from.empty())
+    {
+        auto candidate = from.parent_path() / name;
+        if (std::filesystem::is_regular_file(candidate))
+            return candidate;
+    }
+
+    for (const auto& directory : m_includeDirectories)
+    {
+        auto candidate = directory / name;
+        if (std::filesystem::is_regular_file(candidate))
+            return candidate;
+    }
+
+    return std::filesystem::is_regular_file(name) ? std::filesystem::path(name) : std::filesystem::path();
+}
+
+inline auto ShaderPreprocessor::read(const std::string& name, const std::filesystem::path& from, std::string& source, std::string& resolved) const
+    -> bool
+{
+    if (const auto it = m_sources.find(name); it != m_sources.end())
+    {
+        source = it->second;
+        resolved = name;
+        return true;
+    }
+
+    const auto path = resolve(name, from);
+    if (path.empty())
+        return false;
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+
+    std::stringstream stream;
+    stream << file.rdbuf();
+    source = stream.str();
+    resolved = std::filesystem::weakly_canonical(path).string();
+    return true;
+}
+
+inline auto ShaderPreprocessor::expandFile(const std::string& name,
+                                           const std::filesystem::path& from,
+                                           PreprocessedSource& out,
+                                           std::unordered_set<std::string>& included) const -> bool
+{
+    std::string source, resolved;
+    if (!read(name, from, source, resolved))
+    {
+        std::cerr << "[ShaderPreprocessor] Can't find " << name << (from.empty() ? "" : " included from " + from.string()) << std::endl;
+        return false;
+    }
+
+    if (!included.insert(resolved).second)
+        return true;
+
+    const auto fileIndex = out.files.size();
+    out.files.push_back(resolved);
+    const std::filesystem::path path = m_sources.contains(name) ? std::filesystem::path(name) : std::filesystem::path(resolved);
+
+    bool valid = true;
+    std::size_t lineNumber = 0;
+    std::string_view remaining = source;
+    while (!remaining.empty())
+    {
+        const auto end = remaining.find('\n');
+        const auto line = remaining.substr(0, end);
+        remaining = end == std::string_view::npos ? std::string_view() : remaining.substr(end + 1);
+        ++lineNumber;
+
+        auto directive = line.substr(std::min(line.find_first_not_of(" \t"), line.size()));
+        if (!directive.starts_with("#include"))
+        {
+            out.text.append(line);
+            out.text += '\n';
+            continue;
+        }
+
+        const auto open = directive.find_first_of("\"<");
+        const auto close = open == std::string_view::npos ? open : directive.find_first_of("\">", open + 1);
+        if (close == std::string_view::npos)
+        {
+            std::cerr << "[ShaderPreprocessor] " << resolved << ":" << lineNumber << " malformed #include" << std::endl;
+            valid = false;
+            continue;
+        }
+
+        const std::string includeName(directive.substr(open + 1, close - open - 1));
+        out.text += "#line 1 " + std::to_string(out.files.size()) + "\n";
+        valid &= expandFile(includeName, path, out, included);
+        out.text += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(fileIndex) + "\n";
+    }
+
+    return valid;
+}
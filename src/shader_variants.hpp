@@ -0,0 +1,327 @@
+#pragma once
+
+#include "shader.hpp"
+#include "shader_preprocessor.hpp"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <initializer_list>
+#include <iostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+struct ShaderVariantStats
+{
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    double compileMs = 0.0; // Spent in get() misses and warmUp()
+};
+
+// Permutations of one program, selected by a bitmask over a list of feature names. Bit i adds `#define features[i] 1`
+// to every stage. Sources are expanded once at init(). A variant is only compiled the first time it is requested, or
+// ahead of time with warmUp(), which submits every build before waiting on any so the driver can compile them in parallel.
+class ShaderVariants
+{
+public:
+    static constexpr std::size_t MaxFeatures = 64;
+
+    /* `defines` are added to every variant */
+    void init(const ShaderPreprocessor& preprocessor,
+              const std::string& vertexFile,
+              const std::string& fragmentFile,
+              std::vector<std::string> features = {},
+              std::vector<std::string> defines = {});
+    void initCompute(const ShaderPreprocessor& preprocessor,
+                     const std::string& computeFile,
+                     std::vector<std::string> features = {},
+                     std::vector<std::string> defines = {});
+
+    /* Bit for a feature name, 0 if the name is unknown */
+    auto feature(std::string_view name) const -> std::uint64_t;
+
+    /* Compiles the variant on first use, which blocks. The reference stays valid until the next init(). */
+    auto get(std::uint64_t mask) -> Shader&;
+    /* Non-blocking get(). Starts the build on first use and returns nullptr until it's ready, so callers can fall back. */
+    auto tryGet(std::uint64_t mask) -> Shader*;
+    void warmUp(std::span<const std::uint64_t> masks);
+
+    /* If any of `changedFiles` (canonical paths) is a source or include of this program, re-expands the sources and
+       rebuilds every existing variant in the background. Returns whether a reload started. */
+    auto reload(const ShaderPreprocessor& preprocessor, std::span<const std::string> changedFiles) -> bool;
+    /* Call at a frame boundary. Swaps in the rebuilt variants once all of them are ready. If any fails (or the sources
+       fail to preprocess), the last good programs are kept. Free when no reload is in flight. */
+    void update();
+
+    auto variantCount() const -> std::size_t;
+    auto stats() const -> const ShaderVariantStats&;
+
+private:
+    struct Stage
+    {
+        GLenum type = 0;
+        std::string file;
+        PreprocessedSource source;
+    };
+
+    void expandStages(const ShaderPreprocessor& preprocessor, std::initializer_list<std::pair<GLenum, const std::string*>> stages);
+    auto defines(std::uint64_t mask) const -> std::vector<std::string>;
+    void submit(Shader& shader, std::uint64_t mask) const;
+    void submit(Shader& shader, std::uint64_t mask, const std::vector<Stage>& stages) const;
+
+private:
+    std::vector<Stage> m_stages;
+    std::vector<std::string> m_features;
+    std::vector<std::string> m_defines;
+
+    std::unordered_map<std::uint64_t, Shader> m_variants;
+    ShaderVariantStats m_stats;
+
+    // In-flight reload, built from m_reloadStages
+    std::vector<Stage> m_reloadStages;
+    std::unordered_map<std::uint64_t, Shader> m_reloads;
+};
+
+inline void ShaderVariants::init(const ShaderPreprocessor& preprocessor,
+                                 const std::string& vertexFile,
+                                 const std::string& fragmentFile,
+                                 std::vector<std::string> features,
+                                 std::vector<std::string> defines)
+{
+    assert(features.size() <= MaxFeatures && "Too many shader features!");
+
+    m_features = std::move(features);
+    m_defines = std::move(defines);
+    expandStages(preprocessor, { { GL_VERTEX_SHADER, &vertexFile }, { GL_FRAGMENT_SHADER, &fragmentFile } });
+}
+
+inline void ShaderVariants::initCompute(const ShaderPreprocessor& preprocessor,
+                                        const std::string& computeFile,
+                                        std::vector<std::string> features,
+                                        std::vector<std::string> defines)
+{
+    assert(features.size() <= MaxFeatures && "Too many shader features!");
+
+    m_features = std::move(features);
+    m_defines = std::move(defines);
+    expandStages(preprocessor, { { GL_COMPUTE_SHADER, &computeFile } });
+}
+
+inline auto ShaderVariants::feature(const std::string_view name) const -> std::uint64_t
+{
+    for (std::size_t i = 0; i < m_features.size(); ++i)
+    {
+        if (m_features[i] == name)
+            return 1ull << i;
+    }
+    return 0;
+}
+
+inline auto ShaderVariants::get(const std::uint64_t mask) -> Shader&
+{
+    if (const auto it = m_variants.find(mask); it != m_variants.end())
+    {
+        ++m_stats.hits;
+        // A warmUp() build may still be in flight
+        if (it->second.status() == ShaderStatus::Pending)
+            it->second.wait();
+        return it->second;
+    }
+
+    ++m_stats.misses;
+    using Clock = std::chrono::steady_clock;
+    const auto start = Clock::now();
+
+    auto& shader = m_variants[mask];
+    submit(shader, mask);
+    shader.wait();
+
+    m_stats.compileMs += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    return shader;
+}
+
+inline auto ShaderVariants::tryGet(const std::uint64_t mask) -> Shader*
+{
+    auto it = m_variants.find(mask);
+    if (it == m_variants.end())
+    {
+        ++m_stats.misses;
+        it = m_variants.try_emplace(mask).first;
+        submit(it->second, mask);
+    }
+
+    // Polling a build that's still in flight is neither, only lookups that hand out a program count as hits
+    if (it->second.poll() != ShaderStatus::Ready)
+        return nullptr;
+
+    ++m_stats.hits;
+    return &it->second;
+}
+
+inline void ShaderVariants::warmUp(const std::span<const std::uint64_t> masks)
+{
+    using Clock = std::chrono::steady_clock;
+    const auto start = Clock::now();
+
+    std::vector<Shader*> submitted;
+    for (const auto mask : masks)
+    {
+        if (m_variants.contains(mask))
+            continue;
+
+        auto& shader = m_variants[mask];
+        submit(shader, mask);
+        submitted.push_back(&shader);
+    }
+
+    for (auto* shader : submitted)
+        shader->wait();
+
+    m_stats.compileMs += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+inline auto ShaderVariants::reload(const ShaderPreprocessor& preprocessor, const std::span<const std::string> changedFiles) -> bool
+{
+    auto dependsOn = [&](const Stage& stage) {
+        return std::any_of(stage.source.files.begin(), stage.source.files.end(), [&](const std::string& file) {
+            return std::find(changedFiles.begin(), changedFiles.end(), file) != changedFiles.end();
+        });
+    };
+    if (std::none_of(m_stages.begin(), m_stages.end(), dependsOn))
+        return false;
+
+    // A newer change supersedes any reload still in flight
+    m_reloads.clear();
+    m_reloadStages.clear();
+    for (const auto& stage : m_stages)
+    {
+        auto& reloaded = m_reloadStages.emplace_back();
+        reloaded.type = stage.type;
+        reloaded.file = stage.file;
+        reloaded.source = preprocessor.expand(stage.file);
+        if (!reloaded.source.valid)
+        {
+            std::cerr << "[ShaderVariants] Reloading " << stage.file << " failed, keeping the last good program" << std::endl;
+            m_reloadStages.clear();
+            return false;
+        }
+    }
+
+    for (const auto& [mask, shader] : m_variants)
+        submit(m_reloads[mask], mask, m_reloadStages);
+    return true;
+}
+
+inline void ShaderVariants::update()
+{
+    if (m_reloads.empty())
+        return;
+
+    bool failed = false;
+    for (auto& [mask, shader] : m_reloads)
+    {
+        const auto status = shader.poll();
+        if (status == ShaderStatus::Pending)
+            return;
+        failed |= status != ShaderStatus::Ready;
+    }
+
+    if (failed)
+    {
+        std::cerr << "[ShaderVariants] Reloading " << m_stages.front().file << " failed, keeping the last good program" << std::endl;
+    }
+    else
+    {
+        // Variants first requested while the reload was in flight were built from the old sources
+        bool missing = false;
+        for (const auto& [mask, shader] : m_variants)
+        {
+            if (!m_reloads.contains(mask))
+            {
+                submit(m_reloads[mask], mask, m_reloadStages);
+                missing = true;
+            }
+        }
+        if (missing)
+            return;
+
+        // Swapping keeps references handed out by get() valid
+        for (auto& [mask, shader] : m_reloads)
+            std::swap(m_variants[mask], shader);
+        m_stages = std::move(m_reloadStages);
+    }
+
+    m_reloads.clear();
+    m_reloadStages.clear();
+}
+
+inline auto ShaderVariants::variantCount() const -> std::size_t
+{
+    return m_variants.size();
+}
+
+inline auto ShaderVariants::stats() const -> const ShaderVariantStats&
+{
+    return m_stats;
+}
+
+inline void ShaderVariants::expandStages(const ShaderPreprocessor& preprocessor,
+                                         const std::initializer_list<std::pair<GLenum, const std::string*>> stages)
+{
+    m_variants.clear();
+    m_reloads.clear();
+    m_reloadStages.clear();
+    m_stages.clear();
+    for (const auto& [type, file] : stages)
+    {
+        auto& stage = m_stages.emplace_back();
+        stage.type = type;
+        stage.file = *file;
+        stage.source = preprocessor.expand(*file);
+    }
+}
+
+inline auto ShaderVariants::defines(const std::uint64_t mask) const -> std::vector<std::string>
+{
+    auto defines = m_defines;
+    for (std::size_t i = 0; i < m_features.size(); ++i)
+    {
+        if (mask & (1ull << i))
+            defines.push_back(m_features[i] + " 1");
+    }
+    return defines;
+}
+
+inline void ShaderVariants::submit(Shader& shader, const std::uint64_t mask) const
+{
+    submit(shader, mask, m_stages);
+}
+
+inline void ShaderVariants::submit(Shader& shader, const std::uint64_t mask, const std::vector<Stage>& stages) const
+{
+    for (const auto& stage : stages)
+    {
+        if (!stage.source.valid)
+        {
+            std::cerr << "[ShaderVariants] Not compiling variant " << mask << ", " << stage.file << " failed to preprocess" << std::endl;
+            return;
+        }
+    }
+
+    const auto variantDefines = defines(mask);
+    std::vector<std::string> sources;
+    for (const auto& stage : stages)
+        sources.push_back(ShaderPreprocessor::injectDefines(stage.source.text, variantDefines));
+
+    if (stages.size() == 1)
+        shader.initComputeAsync(sources[0].c_str());
+    else
+        shader.initAsync(sources[0].c_str(), sources[1].c_str());
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+// Instruction sets available to the hand-vectorised paths. Everything has a scalar fallback.
+#if defined(__AVX2__)
+    #define SIMD_AVX2 1
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define SIMD_SSE2 1
+    #include <emmintrin.h>
+#endif
+
+// AVX2 kernels that don't need the whole build to target AVX2. SIMD_TARGET_AVX2 marks a function as compiled for AVX2
+// regardless of the command line, and the caller must check simdHasAvx2() before calling it. MSVC allows the intrinsics
+// anywhere so needs no attribute.
+#if defined(SIMD_AVX2)
+    #define SIMD_AVX2_DISPATCH 1
+    #define SIMD_TARGET_AVX2
+#elif defined(SIMD_SSE2) && (defined(__GNUC__) || defined(__clang__))
+    #define SIMD_AVX2_DISPATCH 1
+    #define SIMD_TARGET_AVX2 __attribute__((target("avx2")))
+#elif defined(SIMD_SSE2) && defined(_MSC_VER)
+    #define SIMD_AVX2_DISPATCH 1
+    #define SIMD_TARGET_AVX2
+    #include <intrin.h>
+#endif
+
+#if defined(SIMD_AVX2_DISPATCH)
+    #include <immintrin.h>
+#endif
+
+/* Whether the CPU (and OS) support AVX2, checked once */
+inline auto simdHasAvx2() -> bool
+{
+#if defined(SIMD_AVX2)
+    return true;
+#elif defined(SIMD_AVX2_DISPATCH) && defined(_MSC_VER) && !defined(__clang__)
+    static const bool hasAvx2 = [] {
+        int info[4];
+        __cpuid(info, 1);
+        const bool osSavesYmm = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 6) == 6;
+        __cpuidex(info, 7, 0);
+        return osSavesYmm && (info[1] & (1 << 5)) != 0;
+    }();
+    return hasAvx2;
+#elif defined(SIMD_AVX2_DISPATCH)
+    static const bool hasAvx2 = __builtin_cpu_supports("avx2");
+    return hasAvx2;
+#else
+    return false;
+#endif
+}
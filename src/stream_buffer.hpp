@@ -0,0 +1,133 @@
+#pragma once
+
+#include "gl_handle.hpp"
+
+#include <glad/glad.h>
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+// Persistently mapped ring buffer split into fence-guarded segments.
+// advance() fences the segment just used and only blocks if the GPU is still reading the next one.
+class StreamBuffer
+{
+public:
+    static constexpr std::size_t WriteFailed = ~std::size_t(0);
+
+    void init(std::size_t segmentSize, std::uint32_t segmentCount = 3);
+
+    /* Fence the current segment and move to the next, waiting for the GPU to release it if necessary. A no-op before init(). */
+    void advance();
+
+    /* Copy `size` bytes into the current segment. Returns the absolute offset of the data within the buffer, or
+       WriteFailed (and writes nothing) if it doesn't fit in what's left of the segment. */
+    [[nodiscard]] auto write(const void* data, std::size_t size, std::size_t alignment = 1) -> std::size_t;
+
+    auto buffer() const -> GLuint;
+    auto segmentSize() const -> std::size_t;
+    auto segmentOffset() const -> std::size_t;
+
+    /* Number of times advance() had to block on the GPU */
+    auto stallCount() const -> std::uint64_t;
+
+private:
+    GLBuffer m_buffer; // Stays mapped until deleted, which also unmaps it
+    std::uint8_t* m_mapped = nullptr;
+
+    std::size_t m_segmentSize = 0;
+    std::uint32_t m_segment = 0;
+    std::size_t m_cursor = 0;
+    std::vector<GLFence> m_fences;
+
+    std::uint64_t m_stallCount = 0;
+};
+
+inline void StreamBuffer::init(const std::size_t segmentSize, const std::uint32_t segmentCount)
+{
+    assert(!m_buffer && "StreamBuffer already initialised!");
+    assert(segmentCount > 0);
+
+    m_segmentSize = segmentSize;
+    m_segment = 0;
+    m_cursor = 0;
+    m_fences.clear();
+    m_fences.resize(segmentCount);
+
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    const auto totalSize = static_cast<GLsizeiptr>(segmentSize * segmentCount);
+
+    m_buffer = GLBuffer::create();
+    glNamedBufferStorage(m_buffer.id(), totalSize, nullptr, flags);
+    m_mapped = static_cast<std::uint8_t*>(glMapNamedBufferRange(m_buffer.id(), 0, totalSize, flags));
+}
+
+inline void StreamBuffer::advance()
+{
+    // Never initialised, there's nothing to fence or move to
+    if (m_fences.empty())
+        return;
+
+    // Guard the segment we just finished with. Any draws sourcing it have already been submitted.
+    m_fences[m_segment].insert();
+
+    m_segment = (m_segment + 1) % static_cast<std::uint32_t>(m_fences.size());
+    m_cursor = 0;
+
+    auto& fence = m_fences[m_segment];
+    if (!fence)
+        return;
+
+    // Cheap poll first, only flush + block when the GPU is genuinely behind
+    auto result = glClientWaitSync(fence.get(), 0, 0);
+    if (result == GL_TIMEOUT_EXPIRED)
+    {
+        ++m_stallCount;
+        do
+        {
+            result = glClientWaitSync(fence.get(), GL_SYNC_FLUSH_COMMANDS_BIT, 1'000'000);
+        } while (result == GL_TIMEOUT_EXPIRED);
+    }
+
+    fence.reset();
+}
+
+inline auto StreamBuffer::write(const void* data, const std::size_t size, const std::size_t alignment) -> std::size_t
+{
+    const auto offset = (segmentOffset() + m_cursor + alignment - 1) / alignment * alignment;
+    const auto cursor = offset - segmentOffset();
+
+    // Anything past the segment belongs to a segment the GPU may still be reading, or lies outside the buffer
+    if (m_mapped == nullptr || cursor > m_segmentSize || size > m_segmentSize - cursor)
+    {
+        std::cerr << "[StreamBuffer] Segment overflow: " << size << " bytes at " << cursor << " of a " << m_segmentSize << " byte segment" << std::endl;
+        return WriteFailed;
+    }
+
+    std::memcpy(m_mapped + offset, data, size);
+    m_cursor = cursor + size;
+
+    return offset;
+}
+
+inline auto StreamBuffer::buffer() const -> GLuint
+{
+    return m_buffer.id();
+}
+
+inline auto StreamBuffer::segmentSize() const -> std::size_t
+{
+    return m_segmentSize;
+}
+
+inline auto StreamBuffer::segmentOffset() const -> std::size_t
+{
+    return m_segmentSize * m_segment;
+}
+
+inline auto StreamBuffer::stallCount() const -> std::uint64_t
+{
+    return m_stallCount;
+}
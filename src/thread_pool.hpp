@@ -0,0 +1,110 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+class ThreadPool
+{
+public:
+    ThreadPool() = default;
+    ThreadPool(const ThreadPool&) = delete;
+    auto operator=(const ThreadPool&) -> ThreadPool& = delete;
+    ~ThreadPool();
+
+    /* 0 uses one thread per hardware thread, minus one for the render thread */
+    void init(std::uint32_t threadCount = 0);
+    void shutdown();
+
+    void submit(std::function<void()> task);
+
+    auto threadCount() const -> std::uint32_t;
+
+    /* Whether the calling thread is one of this pool's workers. Blocking on the pool from there can deadlock. */
+    auto isWorkerThread() const -> bool;
+
+private:
+    void workerLoop();
+
+private:
+    std::vector<std::thread> m_threads;
+    std::queue<std::function<void()>> m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_stopping = false;
+};
+
+inline ThreadPool::~ThreadPool()
+{
+    shutdown();
+}
+
+inline void ThreadPool::init(std::uint32_t threadCount)
+{
+    if (threadCount == 0)
+        threadCount = std::max(2u, std::thread::hardware_concurrency()) - 1; // hardware_concurrency() may return 0
+
+    m_stopping = false;
+    for (std::uint32_t i = 0; i < threadCount; ++i)
+        m_threads.emplace_back(&ThreadPool::workerLoop, this);
+}
+
+inline void ThreadPool::shutdown()
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_stopping = true;
+    }
+    m_condition.notify_all();
+
+    for (auto& thread : m_threads)
+        thread.join();
+    m_threads.clear();
+
+    // Workers drain the queue before exiting, so anything left was submitted to a pool that never had threads
+    m_tasks = {};
+}
+
+inline void ThreadPool::submit(std::function<void()> task)
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_tasks.push(std::move(task));
+    }
+    m_condition.notify_one();
+}
+
+inline auto ThreadPool::threadCount() const -> std::uint32_t
+{
+    return static_cast<std::uint32_t>(m_threads.size());
+}
+
+inline auto ThreadPool::isWorkerThread() const -> bool
+{
+    const auto id = std::this_thread::get_id();
+    return std::any_of(m_threads.begin(), m_threads.end(), [id](const std::thread& thread) { return thread.get_id() == id; });
+}
+
+inline void ThreadPool::workerLoop()
+{
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock lock(m_mutex);
+            m_condition.wait(lock, [this] { return m_stopping || !m_tasks.empty(); });
+            if (m_stopping && m_tasks.empty())
+                return;
+
+            task = std::move(m_tasks.front());
+            m_tasks.pop();
+        }
+
+        task();
+    }
+}
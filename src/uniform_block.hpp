@@ -0,0 +1,275 @@
+#pragma once
+
+#include "gl_state.hpp"
+#include "stream_buffer.hpp"
+
+#include <glad/glad.h>
+#include <glm/ext/matrix_float4x4.hpp>
+#include <glm/ext/vector_float2.hpp>
+#include <glm/ext/vector_float3.hpp>
+#include <glm/ext/vector_float4.hpp>
+#include <glm/ext/vector_int4.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// Std140 blocks are uniform blocks, std430 blocks are shader storage blocks (core GL has no std430 uniform blocks)
+enum class BlockLayout
+{
+    Std140,
+    Std430,
+};
+
+struct BlockMember
+{
+    std::string_view name;
+    GLenum type = 0;
+    GLuint offset = 0;
+    GLuint size = 0;         // Of one element
+    GLuint alignment = 0;    // std430 base alignment of one element
+    GLuint arraySize = 0;    // 0 if not an array
+    GLuint arrayStride = 0;  // sizeof one C++ element
+    GLuint matrixStride = 0; // 0 if not a matrix
+};
+
+// Maps a C++ member type onto its GLSL type and std430 base alignment. Specialise for custom member types.
+template <typename T>
+struct BlockMemberFormat
+{
+    static_assert(sizeof(T) == 0, "No BlockMemberFormat specialisation for this member type.");
+};
+
+template <GLenum Type, GLuint Alignment, GLuint MatrixStride = 0>
+struct BlockMemberFormatOf
+{
+    static constexpr GLenum type = Type;
+    static constexpr GLuint alignment = Alignment;
+    static constexpr GLuint matrixStride = MatrixStride;
+};
+
+// clang-format off
+template <> struct BlockMemberFormat<float> : BlockMemberFormatOf<GL_FLOAT, 4> {};
+template <> struct BlockMemberFormat<int> : BlockMemberFormatOf<GL_INT, 4> {};
+template <> struct BlockMemberFormat<GLuint> : BlockMemberFormatOf<GL_UNSIGNED_INT, 4> {};
+template <> struct BlockMemberFormat<glm::vec2> : BlockMemberFormatOf<GL_FLOAT_VEC2, 8> {};
+template <> struct BlockMemberFormat<glm::vec3> : BlockMemberFormatOf<GL_FLOAT_VEC3, 16> {};
+template <> struct BlockMemberFormat<glm::vec4> : BlockMemberFormatOf<GL_FLOAT_VEC4, 16> {};
+template <> struct BlockMemberFormat<glm::ivec4> : BlockMemberFormatOf<GL_INT_VEC4, 16> {};
+template <> struct BlockMemberFormat<glm::mat4> : BlockMemberFormatOf<GL_FLOAT_MAT4, 16, 16> {};
+// clang-format on
+
+template <typename T>
+constexpr auto makeBlockMember(const std::string_view name, const std::size_t offset) -> BlockMember
+{
+    using Element = std::remove_extent_t<T>;
+    using Format = BlockMemberFormat<Element>;
+    return {
+        name, Format::type, static_cast<GLuint>(offset), sizeof(Element), Format::alignment, std::extent_v<T>, sizeof(Element), Format::matrixStride,
+    };
+}
+
+constexpr auto roundUp(const GLuint value, const GLuint alignment) -> GLuint
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+/* Array stride the GL expects for `member` under `layout` */
+constexpr auto blockArrayStride(const BlockLayout layout, const BlockMember& member) -> GLuint
+{
+    const auto stride = roundUp(member.size, member.alignment);
+    return layout == BlockLayout::Std140 ? roundUp(stride, 16) : stride;
+}
+
+/* True if the C++ offsets and strides match the GLSL packing rules. Members must be declared in memory order. */
+template <std::size_t N>
+constexpr auto isBlockLayoutValid(const BlockLayout layout, const std::array<BlockMember, N>& members, const std::size_t size) -> bool
+{
+    GLuint end = 0;
+    for (const auto& member : members)
+    {
+        // Std140 rounds the alignment of arrays and matrices up to a vec4
+        auto alignment = member.alignment;
+        if (layout == BlockLayout::Std140 && (member.arraySize > 0 || member.matrixStride > 0))
+            alignment = roundUp(alignment, 16);
+
+        if (member.offset % alignment != 0 || member.offset < end)
+            return false;
+        if (member.arraySize > 0 && member.arrayStride != blockArrayStride(layout, member))
+            return false;
+
+        end = member.offset + (member.arraySize > 0 ? member.arraySize * member.arrayStride : member.size);
+    }
+
+    return layout == BlockLayout::Std430 || size % 16 == 0;
+}
+
+// Compile-time description of a uniform (std140) or shader storage (std430) block. Declare with UNIFORM_BLOCK at global scope:
+//
+//   struct CameraBlock { glm::mat4 view; glm::mat4 projection; glm::vec3 position; float time; };
+//   UNIFORM_BLOCK(CameraBlock, "Camera", BlockLayout::Std140, BLOCK_MEMBER(view), BLOCK_MEMBER(projection), BLOCK_MEMBER(position), BLOCK_MEMBER(time));
+//
+// Members use their C++ names, which must match the GLSL ones. Nested structs aren't supported.
+template <typename T>
+struct UniformBlock;
+
+#define BLOCK_MEMBER(member) makeBlockMember<decltype(Type::member)>(#member, offsetof(Type, member))
+
+#define UNIFORM_BLOCK(BlockType, blockName, blockLayout, ...)                                                                                                  \
+    template <>                                                                                                                                                \
+    struct UniformBlock<BlockType>                                                                                                                             \
+    {                                                                                                                                                          \
+        using Type = BlockType;                                                                                                                                \
+        static constexpr std::string_view name = blockName;                                                                                                    \
+        static constexpr BlockLayout layout = blockLayout;                                                                                                     \
+        static constexpr std::array members = { __VA_ARGS__ };                                                                                                 \
+        static_assert(isBlockLayoutValid(layout, members, sizeof(Type)), "Block members don't follow the GLSL packing rules, add explicit padding.");          \
+    }
+
+/* Compares a C++ block against the block the program actually declares. Logs every mismatch. */
+template <typename T>
+auto checkBlockLayout(const GLuint program) -> bool
+{
+    using Block = UniformBlock<T>;
+    const bool uniform = Block::layout == BlockLayout::Std140;
+    const GLenum blockInterface = uniform ? GL_UNIFORM_BLOCK : GL_SHADER_STORAGE_BLOCK;
+    const GLenum memberInterface = uniform ? GL_UNIFORM : GL_BUFFER_VARIABLE;
+
+    const std::string blockName(Block::name);
+    const auto blockIndex = glGetProgramResourceIndex(program, blockInterface, blockName.c_str());
+    if (blockIndex == GL_INVALID_INDEX)
+    {
+        std::cerr << "[OpenGL][UniformBlock] Program has no block named " << blockName << std::endl;
+        return false;
+    }
+
+    const GLenum blockProperties[] = { GL_BUFFER_DATA_SIZE, GL_NUM_ACTIVE_VARIABLES };
+    GLint blockValues[2] = {};
+    glGetProgramResourceiv(program, blockInterface, blockIndex, 2, blockProperties, 2, nullptr, blockValues);
+
+    bool valid = true;
+    if (static_cast<std::size_t>(blockValues[0]) > sizeof(T))
+    {
+        std::cerr << "[OpenGL][UniformBlock] " << blockName << " is " << blockValues[0] << " bytes in GLSL but " << sizeof(T) << " in C++" << std::endl;
+        valid = false;
+    }
+
+    std::vector<GLint> variables(blockValues[1]);
+    const GLenum activeVariables = GL_ACTIVE_VARIABLES;
+    glGetProgramResourceiv(program, blockInterface, blockIndex, 1, &activeVariables, blockValues[1], nullptr, variables.data());
+
+    char nameBuffer[256];
+    for (const auto variable : variables)
+    {
+        const GLenum properties[] = { GL_OFFSET, GL_TYPE, GL_ARRAY_STRIDE, GL_MATRIX_STRIDE };
+        GLint values[4] = {};
+        glGetProgramResourceiv(program, memberInterface, variable, 4, properties, 4, nullptr, values);
+
+        GLsizei length = 0;
+        glGetProgramResourceName(program, memberInterface, variable, sizeof(nameBuffer), &length, nameBuffer);
+
+        // Reflected names are "member", "Block.member" or "member[0]"
+        std::string_view name(nameBuffer, length);
+        if (const auto dot = name.find('.'); dot != std::string_view::npos)
+            name.remove_prefix(dot + 1);
+        if (name.ends_with("[0]"))
+            name.remove_suffix(3);
+
+        const auto member = std::find_if(Block::members.begin(), Block::members.end(), [&](const BlockMember& m) { return m.name == name; });
+        if (member == Block::members.end())
+        {
+            std::cerr << "[OpenGL][UniformBlock] " << blockName << "." << name << " has no C++ member" << std::endl;
+            valid = false;
+            continue;
+        }
+
+        const bool arrayMatches = member->arraySize == 0 || static_cast<GLuint>(values[2]) == member->arrayStride;
+        const bool matrixMatches = member->matrixStride == 0 || static_cast<GLuint>(values[3]) == member->matrixStride;
+        if (static_cast<GLuint>(values[0]) != member->offset || static_cast<GLenum>(values[1]) != member->type || !arrayMatches || !matrixMatches)
+        {
+            std::cerr << "[OpenGL][UniformBlock] " << blockName << "." << name << " is at offset " << values[0] << " in GLSL but " << member->offset
+                      << " in C++ (or its type or stride differs)" << std::endl;
+            valid = false;
+        }
+    }
+
+    return valid;
+}
+
+// Per-frame ring of block data in one persistently mapped StreamBuffer. Each bind() is a memcpy and a glBindBufferRange,
+// which replaces one glUniform* call per member. Call advance() once per frame after the frame's draws are submitted.
+class UniformRing
+{
+public:
+    /* `segmentSize` must hold every block written in one frame */
+    void init(std::size_t segmentSize, std::uint32_t segmentCount = 3);
+    void advance();
+
+    /* Copies the block into the current segment and returns its offset, aligned for the block's buffer target.
+       StreamBuffer::WriteFailed (and nothing written) if the segment is full. */
+    template <typename T>
+    [[nodiscard]] auto write(const T& block) -> std::size_t;
+
+    /* Writes the block and binds it to uniform (std140) or shader storage (std430) binding point `binding`. False if it
+       didn't fit, the binding is then left untouched rather than pointed at stale data. */
+    template <typename T>
+    auto bind(GLuint binding, const T& block) -> bool;
+
+    auto stream() const -> const StreamBuffer&;
+
+private:
+    StreamBuffer m_stream;
+    std::size_t m_uniformAlignment = 256;
+    std::size_t m_storageAlignment = 256;
+};
+
+inline void UniformRing::init(const std::size_t segmentSize, const std::uint32_t segmentCount)
+{
+    GLint uniformAlignment = 0, storageAlignment = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storageAlignment);
+    m_uniformAlignment = static_cast<std::size_t>(std::max(uniformAlignment, 1));
+    m_storageAlignment = static_cast<std::size_t>(std::max(storageAlignment, 1));
+
+    // Keep every segment start aligned for both targets
+    const auto alignment = std::max(m_uniformAlignment, m_storageAlignment);
+    m_stream.init((segmentSize + alignment - 1) / alignment * alignment, segmentCount);
+}
+
+inline void UniformRing::advance()
+{
+    m_stream.advance();
+}
+
+template <typename T>
+auto UniformRing::write(const T& block) -> std::size_t
+{
+    const auto alignment = UniformBlock<T>::layout == BlockLayout::Std140 ? m_uniformAlignment : m_storageAlignment;
+    const auto offset = m_stream.write(&block, sizeof(T), alignment);
+    if (offset == StreamBuffer::WriteFailed)
+        std::cerr << "[OpenGL][UniformRing] No room left for " << UniformBlock<T>::name << " this frame, the segment size is too small" << std::endl;
+    return offset;
+}
+
+template <typename T>
+auto UniformRing::bind(const GLuint binding, const T& block) -> bool
+{
+    const auto offset = write(block);
+    if (offset == StreamBuffer::WriteFailed)
+        return false;
+
+    const GLenum target = UniformBlock<T>::layout == BlockLayout::Std140 ? GL_UNIFORM_BUFFER : GL_SHADER_STORAGE_BUFFER;
+    GLState::bindBufferRange(target, binding, m_stream.buffer(), static_cast<GLintptr>(offset), sizeof(T));
+    return true;
+}
+
+inline auto UniformRing::stream() const -> const StreamBuffer&
+{
+    return m_stream;
+}
@@ -0,0 +1,151 @@
+#pragma once
+
+#include "hash.hpp"
+
+#include <glad/glad.h>
+#include <glm/ext/matrix_float4x4.hpp>
+#include <glm/ext/vector_float2.hpp>
+#include <glm/ext/vector_float3.hpp>
+#include <glm/ext/vector_float4.hpp>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Uniform name hashed at compile time. Implicitly constructible from string literals only, use fromString() for runtime names.
+struct UniformName
+{
+    std::uint64_t hash = 0;
+
+    consteval UniformName(const char* name) : hash(fnv1a64(name)) {}
+
+    static constexpr auto fromString(const std::string_view name) -> UniformName { return UniformName(fnv1a64(name), 0); }
+
+private:
+    constexpr UniformName(const std::uint64_t nameHash, int) : hash(nameHash) {}
+};
+
+// GL type of each C++ type accepted by Shader::set
+template <typename T>
+struct UniformType
+{
+    static_assert(sizeof(T) == 0, "Unsupported uniform type.");
+};
+
+// clang-format off
+template <> struct UniformType<int> { static constexpr GLenum glType = GL_INT; };
+template <> struct UniformType<GLuint> { static constexpr GLenum glType = GL_UNSIGNED_INT; };
+template <> struct UniformType<float> { static constexpr GLenum glType = GL_FLOAT; };
+template <> struct UniformType<glm::vec2> { static constexpr GLenum glType = GL_FLOAT_VEC2; };
+template <> struct UniformType<glm::vec3> { static constexpr GLenum glType = GL_FLOAT_VEC3; };
+template <> struct UniformType<glm::vec4> { static constexpr GLenum glType = GL_FLOAT_VEC4; };
+template <> struct UniformType<glm::mat4> { static constexpr GLenum glType = GL_FLOAT_MAT4; };
+// clang-format on
+
+template <typename T>
+struct UniformHandle
+{
+    GLint location = -1;
+
+    explicit operator bool() const { return location >= 0; }
+};
+
+// Flat open-addressed table of a program's active uniforms, filled once after link. Arrays are reachable both as
+// "name" and "name[0]". Uniforms inside blocks have no location and are skipped.
+class UniformCache
+{
+public:
+    struct Entry
+    {
+        std::uint64_t hash = 0;
+        GLint location = -1;
+        GLenum type = 0;
+    };
+
+    void reflect(GLuint program);
+    void clear();
+
+    /* nullptr if the program has no such uniform (or the compiler optimised it out) */
+    auto find(std::uint64_t hash) const -> const Entry*;
+    auto size() const -> std::uint32_t;
+
+private:
+    void insert(const Entry& entry);
+
+private:
+    std::vector<Entry> m_entries; // Power of two sized, hash 0 marks an empty slot
+    std::uint32_t m_size = 0;
+};
+
+inline void UniformCache::reflect(const GLuint program)
+{
+    clear();
+
+    GLint count = 0, maxNameLength = 0;
+    glGetProgramInterfaceiv(program, GL_UNIFORM, GL_ACTIVE_RESOURCES, &count);
+    glGetProgramInterfaceiv(program, GL_UNIFORM, GL_MAX_NAME_LENGTH, &maxNameLength);
+
+    // Keep the load factor under a half
+    std::size_t capacity = 16;
+    while (capacity < static_cast<std::size_t>(count) * 4)
+        capacity *= 2;
+    m_entries.assign(capacity, {});
+
+    std::string name(static_cast<std::size_t>(maxNameLength), '\0');
+    for (GLint i = 0; i < count; ++i)
+    {
+        const GLenum properties[] = { GL_LOCATION, GL_TYPE };
+        GLint values[2] = {};
+        glGetProgramResourceiv(program, GL_UNIFORM, i, 2, properties, 2, nullptr, values);
+        if (values[0] < 0)
+            continue;
+
+        GLsizei length = 0;
+        glGetProgramResourceName(program, GL_UNIFORM, i, maxNameLength, &length, name.data());
+        const std::string_view view(name.data(), length);
+
+        insert({ fnv1a64(view), values[0], static_cast<GLenum>(values[1]) });
+        if (view.ends_with("[0]"))
+            insert({ fnv1a64(view.substr(0, view.size() - 3)), values[0], static_cast<GLenum>(values[1]) });
+    }
+}
+
+inline void UniformCache::clear()
+{
+    m_entries.clear();
+    m_size = 0;
+}
+
+inline auto UniformCache::find(const std::uint64_t hash) const -> const Entry*
+{
+    if (m_entries.empty())
+        return nullptr;
+
+    const auto mask = m_entries.size() - 1;
+    for (auto slot = hash & mask;; slot = (slot + 1) & mask)
+    {
+        const auto& entry = m_entries[slot];
+        if (entry.hash == hash)
+            return &entry;
+        if (entry.hash == 0)
+            return nullptr;
+    }
+}
+
+inline auto UniformCache::size() const -> std::uint32_t
+{
+    return m_size;
+}
+
+inline void UniformCache::insert(const Entry& entry)
+{
+    const auto mask = m_entries.size() - 1;
+    auto slot = entry.hash & mask;
+    while (m_entries[slot].hash != 0 && m_entries[slot].hash != entry.hash)
+        slot = (slot + 1) & mask;
+
+    if (m_entries[slot].hash == 0)
+        ++m_size;
+    m_entries[slot] = entry;
+}
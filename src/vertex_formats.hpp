@@ -0,0 +1,204 @@
+#pragma once
+
+#include "mesh.hpp"
+
+#include <glad/glad.h>
+#include <glm/common.hpp>
+#include <glm/ext/vector_float2.hpp>
+#include <glm/ext/vector_float3.hpp>
+#include <glm/ext/vector_float4.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+// Storage types for packed attributes. Each maps onto one GL vertex format through AttribFormat.
+struct Snorm16x2
+{
+    std::int16_t x = 0, y = 0;
+};
+
+struct Half2
+{
+    std::uint16_t x = 0, y = 0;
+};
+
+struct Unorm8x4
+{
+    std::uint8_t r = 0, g = 0, b = 0, a = 0;
+};
+
+struct Snorm1010102
+{
+    std::uint32_t packed = 0;
+};
+
+// 12 bytes, vs. 28 for Vertex. Positions are quantised to the mesh bounds, see PositionQuantisation.
+struct PackedVertex
+{
+    Snorm16x2 pos;
+    Half2 texCoord;
+    Unorm8x4 color;
+};
+
+// 16 bytes
+struct PackedNormalVertex
+{
+    Snorm16x2 pos;
+    Half2 texCoord;
+    Unorm8x4 color;
+    Snorm1010102 normal;
+};
+
+// Dequantise in the vertex shader with `pos = offset + aPos * scale`
+struct PositionQuantisation
+{
+    glm::vec2 offset = {};
+    glm::vec2 scale = { 1, 1 };
+};
+
+struct PackedEncodeReport
+{
+    PositionQuantisation quantisation;
+
+    float maxPositionError = 0.0f;
+    float maxTexCoordError = 0.0f;
+    float maxColorError = 0.0f;
+    float maxNormalError = 0.0f;
+
+    std::size_t originalBytes = 0;
+    std::size_t packedBytes = 0;
+};
+
+// clang-format off
+template <> struct AttribFormat<Snorm16x2> : AttribFormatOf<2, GL_SHORT, GL_TRUE> {};
+template <> struct AttribFormat<Half2> : AttribFormatOf<2, GL_HALF_FLOAT> {};
+template <> struct AttribFormat<Unorm8x4> : AttribFormatOf<4, GL_UNSIGNED_BYTE, GL_TRUE> {};
+template <> struct AttribFormat<Snorm1010102> : AttribFormatOf<4, GL_INT_2_10_10_10_REV, GL_TRUE> {};
+// clang-format on
+
+VERTEX_LAYOUT(PackedVertex, VERTEX_ATTRIB(0, pos), VERTEX_ATTRIB(1, texCoord), VERTEX_ATTRIB(2, color));
+VERTEX_LAYOUT(PackedNormalVertex, VERTEX_ATTRIB(0, pos), VERTEX_ATTRIB(1, texCoord), VERTEX_ATTRIB(2, color), VERTEX_ATTRIB(3, normal));
+
+inline auto computePositionQuantisation(const Vertex* vertices, const std::size_t count) -> PositionQuantisation
+{
+    if (count == 0)
+        return {};
+
+    glm::vec2 min = vertices[0].pos, max = vertices[0].pos;
+    for (std::size_t i = 1; i < count; ++i)
+    {
+        min = glm::min(min, vertices[i].pos);
+        max = glm::max(max, vertices[i].pos);
+    }
+
+    PositionQuantisation quantisation;
+    quantisation.offset = (min + max) * 0.5f;
+    quantisation.scale = glm::max((max - min) * 0.5f, glm::vec2(1e-8f));
+    return quantisation;
+}
+
+inline auto encodeSnorm16x2(const glm::vec2& value) -> Snorm16x2
+{
+    return { static_cast<std::int16_t>(glm::packSnorm1x16(value.x)), static_cast<std::int16_t>(glm::packSnorm1x16(value.y)) };
+}
+
+inline auto decodeSnorm16x2(const Snorm16x2& value) -> glm::vec2
+{
+    return { glm::unpackSnorm1x16(static_cast<std::uint16_t>(value.x)), glm::unpackSnorm1x16(static_cast<std::uint16_t>(value.y)) };
+}
+
+inline auto encodeHalf2(const glm::vec2& value) -> Half2
+{
+    return { glm::packHalf1x16(value.x), glm::packHalf1x16(value.y) };
+}
+
+inline auto decodeHalf2(const Half2& value) -> glm::vec2
+{
+    return { glm::unpackHalf1x16(value.x), glm::unpackHalf1x16(value.y) };
+}
+
+inline auto encodeUnorm8x4(const glm::vec4& value) -> Unorm8x4
+{
+    return { glm::packUnorm1x8(value.r), glm::packUnorm1x8(value.g), glm::packUnorm1x8(value.b), glm::packUnorm1x8(value.a) };
+}
+
+inline auto decodeUnorm8x4(const Unorm8x4& value) -> glm::vec4
+{
+    return { glm::unpackUnorm1x8(value.r), glm::unpackUnorm1x8(value.g), glm::unpackUnorm1x8(value.b), glm::unpackUnorm1x8(value.a) };
+}
+
+inline auto encodeSnorm1010102(const glm::vec3& normal) -> Snorm1010102
+{
+    return { glm::packSnorm3x10_1x2(glm::vec4(normal, 0.0f)) };
+}
+
+inline auto decodeSnorm1010102(const Snorm1010102& value) -> glm::vec3
+{
+    return glm::vec3(glm::unpackSnorm3x10_1x2(value.packed));
+}
+
+template <typename T>
+auto maxAbsError(const T& decoded, const T& original) -> float
+{
+    const auto error = glm::abs(decoded - original);
+
+    float result = 0.0f;
+    for (typename T::length_type i = 0; i < T::length(); ++i)
+        result = std::max(result, error[i]);
+    return result;
+}
+
+inline auto encodePackedVertex(const Vertex& vertex, const PositionQuantisation& quantisation) -> PackedVertex
+{
+    const auto pos = (vertex.pos - quantisation.offset) / quantisation.scale;
+    return { encodeSnorm16x2(pos), encodeHalf2(vertex.texCoord), encodeUnorm8x4(glm::vec4(vertex.color, 1.0f)) };
+}
+
+inline void measureEncodeError(const Vertex& vertex, const PackedVertex& packed, PackedEncodeReport& report)
+{
+    const auto& quantisation = report.quantisation;
+    const auto pos = quantisation.offset + decodeSnorm16x2(packed.pos) * quantisation.scale;
+    const auto color = glm::vec3(decodeUnorm8x4(packed.color));
+
+    report.maxPositionError = std::max(report.maxPositionError, maxAbsError(pos, vertex.pos));
+    report.maxTexCoordError = std::max(report.maxTexCoordError, maxAbsError(decodeHalf2(packed.texCoord), vertex.texCoord));
+    report.maxColorError = std::max(report.maxColorError, maxAbsError(color, vertex.color));
+}
+
+inline auto encodePackedVertices(const Vertex* vertices, const std::size_t count, PackedVertex* out) -> PackedEncodeReport
+{
+    PackedEncodeReport report;
+    report.quantisation = computePositionQuantisation(vertices, count);
+    report.originalBytes = count * sizeof(Vertex);
+    report.packedBytes = count * sizeof(PackedVertex);
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        out[i] = encodePackedVertex(vertices[i], report.quantisation);
+        measureEncodeError(vertices[i], out[i], report);
+    }
+
+    return report;
+}
+
+/* `originalBytes` includes the separate float normal stream */
+inline auto encodePackedVertices(const Vertex* vertices, const glm::vec3* normals, const std::size_t count, PackedNormalVertex* out) -> PackedEncodeReport
+{
+    PackedEncodeReport report;
+    report.quantisation = computePositionQuantisation(vertices, count);
+    report.originalBytes = count * (sizeof(Vertex) + sizeof(glm::vec3));
+    report.packedBytes = count * sizeof(PackedNormalVertex);
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        const auto packed = encodePackedVertex(vertices[i], report.quantisation);
+        measureEncodeError(vertices[i], packed, report);
+
+        out[i] = { packed.pos, packed.texCoord, packed.color, encodeSnorm1010102(normals[i]) };
+        report.maxNormalError = std::max(report.maxNormalError, maxAbsError(decodeSnorm1010102(out[i].normal), normals[i]));
+    }
+
+    return report;
+}
@@ -0,0 +1,163 @@
+#pragma once
+
+#include "gl_handle.hpp"
+#include "hash.hpp"
+
+#include <glad/glad.h>
+#include <glm/ext/matrix_float4x4.hpp>
+#include <glm/ext/vector_float2.hpp>
+#include <glm/ext/vector_float3.hpp>
+#include <glm/ext/vector_float4.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+#include <unordered_map>
+
+struct Attrib
+{
+    GLuint index = 0;
+    GLint size = 0;
+    GLenum type = 0;
+    GLboolean normalised = GL_FALSE;
+    GLuint offset = 0;
+};
+
+// Maps a C++ member type onto its GL vertex format. Specialise for custom attribute storage types.
+template <typename T>
+struct AttribFormat
+{
+    static_assert(sizeof(T) == 0, "No AttribFormat specialisation for this member type.");
+};
+
+template <GLint Size, GLenum Type, GLboolean Normalised = GL_FALSE>
+struct AttribFormatOf
+{
+    static constexpr GLint size = Size;
+    static constexpr GLenum type = Type;
+    static constexpr GLboolean normalised = Normalised;
+};
+
+// clang-format off
+template <> struct AttribFormat<float> : AttribFormatOf<1, GL_FLOAT> {};
+template <> struct AttribFormat<glm::vec2> : AttribFormatOf<2, GL_FLOAT> {};
+template <> struct AttribFormat<glm::vec3> : AttribFormatOf<3, GL_FLOAT> {};
+template <> struct AttribFormat<glm::vec4> : AttribFormatOf<4, GL_FLOAT> {};
+// clang-format on
+
+template <typename T>
+constexpr auto makeAttrib(const GLuint index, const std::size_t offset) -> Attrib
+{
+    return { index, AttribFormat<T>::size, AttribFormat<T>::type, AttribFormat<T>::normalised, static_cast<GLuint>(offset) };
+}
+
+template <std::size_t N>
+constexpr auto hashLayout(const std::array<Attrib, N>& attribs, const std::size_t stride) -> std::uint64_t
+{
+    auto hash = fnv1a64(static_cast<std::uint64_t>(stride));
+    for (const auto& attrib : attribs)
+    {
+        hash = fnv1a64(attrib.index, hash);
+        hash = fnv1a64(static_cast<std::uint64_t>(attrib.size), hash);
+        hash = fnv1a64(attrib.type, hash);
+        hash = fnv1a64(attrib.normalised, hash);
+        hash = fnv1a64(attrib.offset, hash);
+    }
+    return hash;
+}
+
+// Compile-time description of a vertex struct. Declare with VERTEX_LAYOUT at global scope:
+//
+//   VERTEX_LAYOUT(Vertex, VERTEX_ATTRIB(0, pos), VERTEX_ATTRIB(1, texCoord));
+template <typename V>
+struct VertexLayout;
+
+#define VERTEX_ATTRIB(location, member) makeAttrib<decltype(Type::member)>(location, offsetof(Type, member))
+
+// A mat4 takes 4 consecutive locations, one per column
+#define VERTEX_ATTRIB_MAT4(location, member)                                                                                                                   \
+    makeAttrib<glm::vec4>(location, offsetof(Type, member)), makeAttrib<glm::vec4>(location + 1, offsetof(Type, member) + sizeof(glm::vec4)),                 \
+        makeAttrib<glm::vec4>(location + 2, offsetof(Type, member) + 2 * sizeof(glm::vec4)),                                                                   \
+        makeAttrib<glm::vec4>(location + 3, offsetof(Type, member) + 3 * sizeof(glm::vec4))
+
+#define VERTEX_LAYOUT(VertexType, ...)                                                                                                                         \
+    template <>                                                                                                                                                \
+    struct VertexLayout<VertexType>                                                                                                                            \
+    {                                                                                                                                                          \
+        using Type = VertexType;                                                                                                                               \
+        static constexpr std::array attribs = { __VA_ARGS__ };                                                                                                 \
+        static constexpr std::size_t stride = sizeof(VertexType);                                                                                              \
+        static constexpr std::uint64_t hash = hashLayout(attribs, stride);                                                                                     \
+    }
+
+// Shares one format-only VAO between every mesh with an identical layout. Buffers are attached at bind time.
+// Per-vertex attributes source binding 0, per-instance attributes (if any) binding 1.
+class VertexArrayCache
+{
+public:
+    static constexpr GLuint VertexBinding = 0;
+    static constexpr GLuint InstanceBinding = 1;
+
+    static void shutdown();
+
+    template <typename V, typename Instance = void>
+    static auto get() -> GLuint;
+
+    static auto get(std::uint64_t hash, std::span<const Attrib> attribs, std::span<const Attrib> instanceAttribs = {}) -> GLuint;
+
+    /* Adds attributes sourced from InstanceBinding to `vao` */
+    static void setupInstanceAttribs(GLuint vao, std::span<const Attrib> instanceAttribs);
+
+private:
+    inline static std::unordered_map<std::uint64_t, GLVertexArray> m_vaos;
+};
+
+inline void VertexArrayCache::shutdown()
+{
+    m_vaos.clear();
+}
+
+template <typename V, typename Instance>
+auto VertexArrayCache::get() -> GLuint
+{
+    using Layout = VertexLayout<V>;
+    if constexpr (std::is_void_v<Instance>)
+        return get(Layout::hash, Layout::attribs);
+    else
+        return get(fnv1a64(VertexLayout<Instance>::hash, Layout::hash), Layout::attribs, VertexLayout<Instance>::attribs);
+}
+
+inline auto VertexArrayCache::get(const std::uint64_t hash, const std::span<const Attrib> attribs, const std::span<const Attrib> instanceAttribs) -> GLuint
+{
+    auto& handle = m_vaos[hash];
+    if (handle)
+        return handle.id();
+
+    handle = GLVertexArray::create();
+    const auto vao = handle.id();
+    for (const auto& attrib : attribs)
+    {
+        glEnableVertexArrayAttrib(vao, attrib.index);
+        glVertexArrayAttribBinding(vao, attrib.index, VertexBinding);
+        glVertexArrayAttribFormat(vao, attrib.index, attrib.size, attrib.type, attrib.normalised, attrib.offset);
+    }
+    setupInstanceAttribs(vao, instanceAttribs);
+
+    return vao;
+}
+
+inline void VertexArrayCache::setupInstanceAttribs(const GLuint vao, const std::span<const Attrib> instanceAttribs)
+{
+    if (instanceAttribs.empty())
+        return;
+
+    for (const auto& attrib : instanceAttribs)
+    {
+        glEnableVertexArrayAttrib(vao, attrib.index);
+        glVertexArrayAttribBinding(vao, attrib.index, InstanceBinding);
+        glVertexArrayAttribFormat(vao, attrib.index, attrib.size, attrib.type, attrib.normalised, attrib.offset);
+    }
+    glVertexArrayBindingDivisor(vao, InstanceBinding, 1);
+}
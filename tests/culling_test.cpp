@@ -0,0 +1,110 @@
+#include "culling.hpp"
+#include "test.hpp"
+
+#include <glm/ext/matrix_clip_space.hpp>
+#include <glm/ext/matrix_transform.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <future>
+#include <random>
+
+namespace
+{
+auto makeSet(const std::uint32_t count) -> CullingSet
+{
+    std::mt19937 random(3);
+    std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+    CullingSet set;
+    for (std::uint32_t i = 0; i < count; ++i)
+    {
+        const glm::vec3 centre(position(random), position(random), position(random));
+        set.add(centre - 1.0f, centre + 1.0f);
+    }
+    return set;
+}
+
+auto makeFrustum() -> Frustum
+{
+    const auto view = glm::lookAt(glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    return Frustum::fromMatrix(glm::perspective(1.0f, 1.0f, 0.1f, 150.0f) * view);
+}
+
+auto cullScalar(const CullingSet& set, const Frustum& frustum) -> std::vector<std::uint32_t>
+{
+    std::vector<std::uint32_t> visible(set.size());
+    visible.resize(cullFrustumScalar(set, frustum, 0, set.size(), visible.data()));
+    return visible;
+}
+
+void testKernelsAgree()
+{
+    // An odd count so the last block has padding lanes
+    const auto set = makeSet(10001);
+    const auto frustum = makeFrustum();
+    const auto reference = cullScalar(set, frustum);
+    CHECK(!reference.empty() && reference.size() < set.size());
+
+    std::vector<std::uint32_t> visible(set.size());
+#if defined(SIMD_SSE2)
+    visible.resize(cullFrustumSse2(set, frustum, 0, set.size(), visible.data()));
+    CHECK(visible == reference);
+#endif
+#if defined(SIMD_AVX2_DISPATCH)
+    if (simdHasAvx2())
+    {
+        visible.resize(set.size());
+        visible.resize(cullFrustumAvx2(set, frustum, 0, set.size(), visible.data()));
+        CHECK(visible == reference);
+    }
+#endif
+    cullFrustum(set, frustum, visible);
+    CHECK(visible == reference);
+}
+
+void testParallelWithoutWorkers()
+{
+    // Nothing would ever run the chunks, so this has to cull inline rather than wait
+    const auto set = makeSet(10001);
+    const auto frustum = makeFrustum();
+    ThreadPool pool;
+    std::vector<std::uint32_t> visible;
+    cullFrustumParallel(set, frustum, pool, visible, 1024);
+    CHECK(visible == cullScalar(set, frustum));
+}
+
+void testParallelFromWorker()
+{
+    // A single worker blocked waiting on chunks queued behind itself would never finish
+    const auto set = makeSet(10001);
+    const auto frustum = makeFrustum();
+    ThreadPool pool;
+    pool.init(1);
+
+    std::vector<std::uint32_t> visible;
+    std::promise<void> done;
+    auto future = done.get_future();
+    pool.submit([&] {
+        cullFrustumParallel(set, frustum, pool, visible, 1024);
+        done.set_value();
+    });
+
+    const auto finished = future.wait_for(std::chrono::seconds(10)) == std::future_status::ready;
+    CHECK(finished);
+    if (!finished)
+        std::exit(testResult()); // The pool can't be joined
+    CHECK(visible == cullScalar(set, frustum));
+
+    // And from outside the pool the chunks do go to the worker
+    cullFrustumParallel(set, frustum, pool, visible, 1024);
+    CHECK(visible == cullScalar(set, frustum));
+}
+} // namespace
+
+int main()
+{
+    testKernelsAgree();
+    testParallelWithoutWorkers();
+    testParallelFromWorker();
+    return testResult();
+}
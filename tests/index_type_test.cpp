@@ -0,0 +1,123 @@
+#include "index_type.hpp"
+#include "test.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+/* Triangle list over a (size + 1)^2 vertex grid, two triangles per cell */
+auto makeGrid(const std::uint32_t size) -> std::vector<std::uint32_t>
+{
+    std::vector<std::uint32_t> indices;
+    const auto stride = size + 1;
+    for (std::uint32_t y = 0; y < size; ++y)
+    {
+        for (std::uint32_t x = 0; x < size; ++x)
+        {
+            const auto corner = y * stride + x;
+            indices.insert(indices.end(), { corner, corner + 1, corner + stride, corner + 1, corner + stride + 1, corner + stride });
+        }
+    }
+    return indices;
+}
+
+void testNarrow()
+{
+    // 255x255 cells is 256^2 = 65536 vertices, the most that still narrows whole
+    const auto indices = makeGrid(255);
+    std::vector<std::uint16_t> narrowed;
+    CHECK(narrowIndices(indices.data(), indices.size(), 256 * 256, narrowed));
+    CHECK(narrowed.size() == indices.size());
+
+    bool same = true;
+    for (std::size_t i = 0; i < indices.size(); ++i)
+        same = same && narrowed[i] == indices[i];
+    CHECK(same);
+
+    std::vector<IndexChunk16> chunks;
+    const auto report = narrowOrSplitIndices(indices.data(), indices.size(), 256 * 256, 12, chunks);
+    CHECK(report.chunkCount == 1 && chunks.size() == 1);
+    CHECK(report.duplicatedVertices == 0);
+    CHECK(report.bytesSaved() == static_cast<std::ptrdiff_t>(indices.size() * 2));
+    CHECK(chunks[0].vertexRemap.size() == 256 * 256 && chunks[0].vertexRemap.back() == 256 * 256 - 1);
+
+    // One vertex too many no longer fits
+    CHECK(!narrowIndices(indices.data(), indices.size(), 256 * 256 + 1, narrowed));
+}
+
+void testSplit()
+{
+    // 300x300 cells is 90601 vertices, which has to be split
+    constexpr std::uint32_t VertexCount = 301 * 301;
+    const auto indices = makeGrid(300);
+    std::vector<std::uint16_t> narrowed;
+    CHECK(!narrowIndices(indices.data(), indices.size(), VertexCount, narrowed));
+
+    std::vector<IndexChunk16> chunks;
+    const auto report = narrowOrSplitIndices(indices.data(), indices.size(), VertexCount, 12, chunks);
+    CHECK(chunks.size() >= 2 && report.chunkCount == chunks.size());
+    CHECK(report.duplicatedVertices > 0);
+
+    // Each chunk stays addressable with 16 bits, and mapping its local indices back through the remap reproduces the source triangles in order
+    std::size_t next = 0, chunkVertices = 0;
+    bool matches = true;
+    for (const auto& chunk : chunks)
+    {
+        CHECK(chunk.vertexRemap.size() <= 65536);
+        CHECK(chunk.indices.size() % 3 == 0);
+        chunkVertices += chunk.vertexRemap.size();
+        for (const auto local : chunk.indices)
+        {
+            matches = matches && local < chunk.vertexRemap.size() && next < indices.size() && chunk.vertexRemap[local] == indices[next];
+            ++next;
+        }
+    }
+    CHECK(matches);
+    CHECK(next == indices.size());
+    CHECK(chunkVertices == VertexCount + report.duplicatedVertices);
+
+    // Gathering a chunk's vertices puts the source vertex at each local index
+    std::vector<std::uint32_t> positions(VertexCount);
+    for (std::uint32_t i = 0; i < VertexCount; ++i)
+        positions[i] = i * 7;
+    const auto& last = chunks.back();
+    const auto gathered = gatherVertices(positions.data(), sizeof(std::uint32_t), last);
+    CHECK(gathered.size() == last.vertexRemap.size() * sizeof(std::uint32_t));
+
+    bool gatheredMatches = true;
+    for (std::size_t i = 0; i < last.vertexRemap.size(); ++i)
+    {
+        std::uint32_t value = 0;
+        std::memcpy(&value, gathered.data() + i * sizeof(std::uint32_t), sizeof(value));
+        gatheredMatches = gatheredMatches && value == last.vertexRemap[i] * 7;
+    }
+    CHECK(gatheredMatches);
+}
+
+void testOutOfRange()
+{
+    const std::vector<std::uint32_t> indices = { 0, 1, 2, 2, 1, 3 };
+    std::vector<std::uint16_t> narrowed;
+    CHECK(narrowIndices(indices.data(), indices.size(), 4, narrowed));
+    CHECK(!narrowIndices(indices.data(), indices.size(), 3, narrowed));
+    CHECK(narrowed.empty());
+
+    CHECK(splitIndices16(indices.data(), indices.size(), 4).size() == 1);
+    CHECK(splitIndices16(indices.data(), indices.size(), 3).empty());
+
+    std::vector<IndexChunk16> chunks;
+    const auto report = narrowOrSplitIndices(indices.data(), indices.size(), 3, 12, chunks);
+    CHECK(chunks.empty() && report.chunkCount == 0);
+    CHECK(report.bytesSaved() == 0);
+}
+} // namespace
+
+int main()
+{
+    testNarrow();
+    testSplit();
+    testOutOfRange();
+    return testResult();
+}
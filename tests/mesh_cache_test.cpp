@@ -0,0 +1,103 @@
+#include "mesh_cache.hpp"
+#include "test.hpp"
+
+#include <filesystem>
+#include <functional>
+#include <string>
+
+namespace
+{
+const auto CachePath = (std::filesystem::temp_directory_path() / "mesh_cache_test.glmc").string();
+const auto PatchedPath = (std::filesystem::temp_directory_path() / "mesh_cache_test_patched.glmc").string();
+constexpr std::uint64_t SourceHash = 0x1234;
+
+auto readFile(const std::string& path) -> std::vector<char>
+{
+    std::ifstream file(path, std::ios::binary);
+    return { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+}
+
+void writeFile(const std::string& path, const std::vector<char>& bytes)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+/* Copies the valid cache with its header modified by `patch`, optionally truncated, and tries to open it */
+auto openPatched(const std::function<void(MeshCacheHeader&)>& patch, const std::size_t truncateBy = 0) -> bool
+{
+    auto bytes = readFile(CachePath);
+    MeshCacheHeader header;
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    patch(header);
+    std::memcpy(bytes.data(), &header, sizeof(header));
+    bytes.resize(bytes.size() - truncateBy);
+    writeFile(PatchedPath, bytes);
+
+    MeshCacheFile file;
+    return file.open(PatchedPath.c_str(), SourceHash);
+}
+
+void testRoundTrip()
+{
+    const float vertices[] = { 0, 0, 0, 1, 0, 0, 0, 1, 0, 1, 1, 1 };
+    const std::uint16_t indices[] = { 0, 1, 2, 2, 1, 3 };
+    const Attrib attribs[] = { { 0, 3, GL_FLOAT, GL_FALSE, 0 } };
+
+    MeshCacheDesc desc;
+    desc.sourceHash = SourceHash;
+    desc.indexType = GL_UNSIGNED_SHORT;
+    desc.attribs = attribs;
+    desc.vertexStride = 3 * sizeof(float);
+    desc.vertices = vertices;
+    desc.vertexCount = 4;
+    desc.indices = indices;
+    desc.indexCount = 6;
+    CHECK(writeMeshCache(CachePath.c_str(), desc));
+
+    MeshCacheFile file;
+    CHECK(!file.open(CachePath.c_str(), SourceHash + 1));
+    CHECK(file.open(CachePath.c_str(), SourceHash));
+
+    const auto& header = file.header();
+    CHECK(header.vertexSize == sizeof(vertices) && header.indexSize == sizeof(indices));
+    CHECK(header.boundsMin == glm::vec3(0.0f) && header.boundsMax == glm::vec3(1.0f));
+    CHECK(std::memcmp(file.vertexData(), vertices, sizeof(vertices)) == 0);
+    CHECK(std::memcmp(file.indexData(), indices, sizeof(indices)) == 0);
+    CHECK(file.attribs().size() == 1 && file.attribs()[0].type == GL_FLOAT);
+
+    CHECK(openPatched([](MeshCacheHeader&) {}));
+}
+
+void testRejectsCorruptHeaders()
+{
+    // Sizes that don't match their counts
+    CHECK(!openPatched([](MeshCacheHeader& header) { header.indexCount += 1; }));
+    CHECK(!openPatched([](MeshCacheHeader& header) { header.indexSize -= 2; }));
+    CHECK(!openPatched([](MeshCacheHeader& header) { header.vertexCount = 1000; }));
+    CHECK(!openPatched([](MeshCacheHeader& header) { header.vertexStride = 4; }));
+    CHECK(!openPatched([](MeshCacheHeader& header) { header.indexType = GL_FLOAT; }));
+    CHECK(!openPatched([](MeshCacheHeader& header) { header.attribCount = MeshCacheMaxAttribs + 1; }));
+
+    // Offsets that wrap around when added to the size
+    CHECK(!openPatched([](MeshCacheHeader& header) { header.vertexOffset = ~std::uint64_t(0) - 8; }));
+    CHECK(!openPatched([](MeshCacheHeader& header) { header.indexOffset = ~std::uint64_t(0) - 4; }));
+
+    // Counts and sizes that agree with each other but not with the file
+    CHECK(!openPatched([](MeshCacheHeader& header) {
+        header.indexCount = 0x80000000u;
+        header.indexSize = 0x100000000ull;
+    }));
+    CHECK(!openPatched([](MeshCacheHeader&) {}, 1));
+}
+} // namespace
+
+int main()
+{
+    testRoundTrip();
+    testRejectsCorruptHeaders();
+
+    std::filesystem::remove(CachePath);
+    std::filesystem::remove(PatchedPath);
+    return testResult();
+}
@@ -0,0 +1,65 @@
+#include "mesh_loader.hpp"
+#include "test.hpp"
+
+// Only the worker side of the loader, anything reaching an upload would need a GL context
+
+namespace
+{
+auto loadTriangle(MeshData& data) -> bool
+{
+    data.vertexStride = 12;
+    data.vertices.resize(3 * data.vertexStride);
+    data.indices = { 0, 1, 2 };
+    return true;
+}
+
+void testShutdownWithoutWorkers()
+{
+    // Loads submitted before init() never start. Shutting down must fail them rather than wait forever.
+    MeshLoader loader;
+    auto handle = loader.load("never started", loadTriangle);
+    CHECK(loader.pendingCount() == 1);
+
+    loader.shutdown();
+    CHECK(loader.pendingCount() == 0);
+    CHECK(handle->state() == AssetState::Failed);
+    CHECK(handle.use_count() == 1); // The pool released its copy
+}
+
+void testEmptyMeshesFail()
+{
+    MeshLoader loader;
+    loader.init(1);
+
+    auto noIndices = loader.load("no indices", [](MeshData& data) {
+        data.vertices.resize(36);
+        return true;
+    });
+    auto noVertices = loader.load("no vertices", [](MeshData& data) {
+        data.indices = { 0, 1, 2 };
+        return true;
+    });
+    auto failed = loader.load("failed", [](MeshData&) { return false; });
+
+    // Failed loads are retired by pumpUploads without touching GL
+    const auto start = std::chrono::steady_clock::now();
+    while (loader.pendingCount() > 0 && std::chrono::steady_clock::now() - start < std::chrono::seconds(10))
+    {
+        loader.pumpUploads(0);
+        std::this_thread::yield();
+    }
+
+    CHECK(loader.pendingCount() == 0);
+    CHECK(noIndices->state() == AssetState::Failed);
+    CHECK(noVertices->state() == AssetState::Failed);
+    CHECK(failed->state() == AssetState::Failed);
+    loader.shutdown();
+}
+} // namespace
+
+int main()
+{
+    testShutdownWithoutWorkers();
+    testEmptyMeshesFail();
+    return testResult();
+}
@@ -0,0 +1,168 @@
+#include "mesh_optimiser.hpp"
+#include "test.hpp"
+
+#include <algorithm>
+#include <array>
+#include <random>
+#include <tuple>
+
+namespace
+{
+struct Vertex
+{
+    glm::vec3 position;
+    glm::vec3 normal;
+};
+
+struct TestMesh
+{
+    std::vector<Vertex> vertices;
+    std::vector<std::uint32_t> indices;
+};
+
+/* Flat `size` x `size` quad grid, triangles in row order */
+auto makeGrid(const std::uint32_t size) -> TestMesh
+{
+    TestMesh mesh;
+    for (std::uint32_t y = 0; y <= size; ++y)
+    {
+        for (std::uint32_t x = 0; x <= size; ++x)
+            mesh.vertices.push_back({ glm::vec3(static_cast<float>(x), static_cast<float>(y), 0.0f), glm::vec3(0.0f, 0.0f, 1.0f) });
+    }
+
+    for (std::uint32_t y = 0; y < size; ++y)
+    {
+        for (std::uint32_t x = 0; x < size; ++x)
+        {
+            const auto v = y * (size + 1) + x;
+            mesh.indices.insert(mesh.indices.end(), { v, v + 1, v + size + 2, v, v + size + 2, v + size + 1 });
+        }
+    }
+    return mesh;
+}
+
+void shuffleTriangles(std::vector<std::uint32_t>& indices)
+{
+    std::vector<std::array<std::uint32_t, 3>> triangles(indices.size() / 3);
+    std::memcpy(triangles.data(), indices.data(), indices.size() * sizeof(std::uint32_t));
+    std::shuffle(triangles.begin(), triangles.end(), std::mt19937(42));
+    std::memcpy(indices.data(), triangles.data(), indices.size() * sizeof(std::uint32_t));
+}
+
+/* Triangles as sorted position triples, so meshes compare equal regardless of triangle, corner or vertex order */
+auto triangleSet(const TestMesh& mesh) -> std::vector<std::array<float, 9>>
+{
+    std::vector<std::array<float, 9>> triangles;
+    for (std::size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+    {
+        std::array<glm::vec3, 3> corners = { mesh.vertices[mesh.indices[i]].position, mesh.vertices[mesh.indices[i + 1]].position,
+                                             mesh.vertices[mesh.indices[i + 2]].position };
+        std::sort(corners.begin(), corners.end(), [](const glm::vec3& a, const glm::vec3& b) {
+            return std::tie(a.x, a.y, a.z) < std::tie(b.x, b.y, b.z);
+        });
+        triangles.push_back({ corners[0].x, corners[0].y, corners[0].z, corners[1].x, corners[1].y, corners[1].z, corners[2].x, corners[2].y,
+                              corners[2].z });
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+auto acmr(const TestMesh& mesh) -> float
+{
+    return analyseVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size()).acmr;
+}
+
+void testAnalyseVertexCache()
+{
+    // One triangle: 3 misses, 3 vertices
+    const std::uint32_t single[] = { 0, 1, 2 };
+    const auto stats = analyseVertexCache(single, 3, 3);
+    CHECK(stats.acmr == 3.0f);
+    CHECK(stats.atvr == 1.0f);
+
+    // A quad's second triangle hits on two of its vertices
+    const std::uint32_t quad[] = { 0, 1, 2, 0, 2, 3 };
+    CHECK(analyseVertexCache(quad, 6, 4).acmr == 2.0f);
+}
+
+void testVertexCacheNotWorse()
+{
+    // Row order is already reasonable, shuffled is the worst case. Neither may get worse, and both should end up close to
+    // the ~0.7 Forsyth reaches on a regular grid with a 16 entry cache.
+    for (const bool shuffled : { false, true })
+    {
+        auto mesh = makeGrid(64);
+        if (shuffled)
+            shuffleTriangles(mesh.indices);
+        const auto reference = triangleSet(mesh);
+        const auto before = acmr(mesh);
+
+        std::vector<std::uint32_t> optimised(mesh.indices.size());
+        optimiseVertexCache(optimised.data(), mesh.indices.data(), mesh.indices.size(), mesh.vertices.size());
+        mesh.indices = optimised;
+
+        const auto after = acmr(mesh);
+        CHECK(after <= before);
+        CHECK(after < 0.85f);
+        CHECK(triangleSet(mesh) == reference);
+    }
+}
+
+void testFullPipeline()
+{
+    auto mesh = makeGrid(64);
+    shuffleTriangles(mesh.indices);
+    const auto reference = triangleSet(mesh);
+    const auto before = acmr(mesh);
+
+    std::vector<std::uint32_t> optimised(mesh.indices.size());
+    optimiseVertexCache(optimised.data(), mesh.indices.data(), mesh.indices.size(), mesh.vertices.size());
+    mesh.indices = optimised;
+    const auto cacheOptimised = acmr(mesh);
+
+    // Overdraw only moves whole clusters split at cache breaks, so it may only cost a little of the cache efficiency
+    optimiseOverdraw(mesh.indices.data(), mesh.indices.size(), mesh.vertices.data(), mesh.vertices.size(), sizeof(Vertex));
+    const auto overdrawOptimised = acmr(mesh);
+    CHECK(overdrawOptimised <= cacheOptimised * 1.05f);
+    CHECK(overdrawOptimised < before);
+    CHECK(triangleSet(mesh) == reference);
+
+    // Fetch remaps vertices without reordering triangles, so the cache behaviour is unchanged
+    const auto vertexCount = mesh.vertices.size();
+    mesh.vertices.resize(optimiseVertexFetch(mesh.vertices.data(), mesh.indices.data(), mesh.indices.size(), vertexCount, sizeof(Vertex)));
+    CHECK(mesh.vertices.size() == vertexCount);
+    CHECK(acmr(mesh) == overdrawOptimised);
+    CHECK(triangleSet(mesh) == reference);
+
+    // First-use order: each index is at most one past the highest seen so far
+    std::uint32_t highest = 0;
+    bool firstUseOrder = mesh.indices[0] == 0;
+    for (const auto index : mesh.indices)
+    {
+        firstUseOrder &= index <= highest + 1;
+        highest = std::max(highest, index);
+    }
+    CHECK(firstUseOrder);
+}
+
+void testUnreferencedVerticesDropped()
+{
+    std::vector<Vertex> vertices(5);
+    for (std::size_t i = 0; i < vertices.size(); ++i)
+        vertices[i].position = glm::vec3(static_cast<float>(i));
+    std::uint32_t indices[] = { 4, 2, 0 };
+
+    CHECK(optimiseVertexFetch(vertices.data(), indices, 3, vertices.size(), sizeof(Vertex)) == 3);
+    CHECK(indices[0] == 0 && indices[1] == 1 && indices[2] == 2);
+    CHECK(vertices[0].position.x == 4.0f && vertices[1].position.x == 2.0f && vertices[2].position.x == 0.0f);
+}
+} // namespace
+
+int main()
+{
+    testAnalyseVertexCache();
+    testVertexCacheNotWorse();
+    testFullPipeline();
+    testUnreferencedVerticesDropped();
+    return testResult();
+}
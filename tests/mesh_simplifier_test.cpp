@@ -0,0 +1,184 @@
+#include "mesh_simplifier.hpp"
+#include "test.hpp"
+
+#include <glm/ext/scalar_constants.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+struct TestMesh
+{
+    std::vector<glm::vec3> positions;
+    std::vector<std::uint32_t> indices;
+};
+
+/* Flat `size` x `size` quad grid over [0, 1]^2 */
+auto makeGrid(const std::uint32_t size) -> TestMesh
+{
+    TestMesh mesh;
+    for (std::uint32_t y = 0; y <= size; ++y)
+    {
+        for (std::uint32_t x = 0; x <= size; ++x)
+            mesh.positions.emplace_back(static_cast<float>(x) / static_cast<float>(size), static_cast<float>(y) / static_cast<float>(size), 0.0f);
+    }
+
+    for (std::uint32_t y = 0; y < size; ++y)
+    {
+        for (std::uint32_t x = 0; x < size; ++x)
+        {
+            const auto v = y * (size + 1) + x;
+            mesh.indices.insert(mesh.indices.end(), { v, v + 1, v + size + 2, v, v + size + 2, v + size + 1 });
+        }
+    }
+    return mesh;
+}
+
+/* Closed unit sphere: a subdivided cube with its vertices projected outward, so there are no seams or border edges */
+auto makeSphere(const std::uint32_t size) -> TestMesh
+{
+    TestMesh mesh;
+    const glm::vec3 axes[6][3] = {
+        { { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 } },   { { -1, 0, 0 }, { 0, 0, 1 }, { 0, 1, 0 } }, { { 0, 1, 0 }, { 0, 0, 1 }, { 1, 0, 0 } },
+        { { 0, -1, 0 }, { 1, 0, 0 }, { 0, 0, 1 } }, { { 0, 0, 1 }, { 1, 0, 0 }, { 0, 1, 0 } },  { { 0, 0, -1 }, { 0, 1, 0 }, { 1, 0, 0 } },
+    };
+
+    // Faces share their edge vertices through a position lookup, otherwise the cube seams would be borders
+    auto vertex = [&](const glm::vec3& p) {
+        const auto position = glm::normalize(p);
+        for (std::size_t v = 0; v < mesh.positions.size(); ++v)
+        {
+            if (glm::length(mesh.positions[v] - position) < 1e-5f)
+                return static_cast<std::uint32_t>(v);
+        }
+        mesh.positions.push_back(position);
+        return static_cast<std::uint32_t>(mesh.positions.size() - 1);
+    };
+
+    for (const auto& [normal, u, v] : axes)
+    {
+        auto corner = [&](const std::uint32_t x, const std::uint32_t y) {
+            const auto s = static_cast<float>(x) / static_cast<float>(size) * 2.0f - 1.0f, t = static_cast<float>(y) / static_cast<float>(size) * 2.0f - 1.0f;
+            return vertex(normal + u * s + v * t);
+        };
+
+        for (std::uint32_t y = 0; y < size; ++y)
+        {
+            for (std::uint32_t x = 0; x < size; ++x)
+            {
+                const auto a = corner(x, y), b = corner(x + 1, y), c = corner(x + 1, y + 1), d = corner(x, y + 1);
+                mesh.indices.insert(mesh.indices.end(), { a, b, c, a, c, d });
+            }
+        }
+    }
+    return mesh;
+}
+
+auto simplify(const TestMesh& mesh, const std::size_t targetIndexCount, const float maxError = 1e30f) -> SimplifyResult
+{
+    return simplifyMesh(mesh.indices.data(), mesh.indices.size(), mesh.positions.data(), mesh.positions.size(), sizeof(glm::vec3), 0, targetIndexCount,
+                        maxError);
+}
+
+auto hasDegenerateTriangles(const std::vector<std::uint32_t>& indices) -> bool
+{
+    for (std::size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        if (indices[i] == indices[i + 1] || indices[i + 1] == indices[i + 2] || indices[i] == indices[i + 2])
+            return true;
+    }
+    return false;
+}
+
+void testPlaneReachesTarget()
+{
+    // Collapses within a plane cost nothing, so a flat grid can go all the way down to the target with no error
+    const auto mesh = makeGrid(16);
+    const auto target = mesh.indices.size() / 10 / 3 * 3;
+    const auto result = simplify(mesh, target);
+
+    CHECK(result.indices.size() <= target);
+    CHECK(!result.indices.empty());
+    CHECK(result.indices.size() % 3 == 0);
+    CHECK(result.error < 1e-3f);
+    CHECK(!hasDegenerateTriangles(result.indices));
+
+    // Borders are pinned, so the outline keeps its corners
+    for (const auto corner : { 0u, 16u, 17u * 16u, 17u * 17u - 1u })
+        CHECK(std::find(result.indices.begin(), result.indices.end(), corner) != result.indices.end());
+}
+
+void testSphereErrorBounded()
+{
+    const auto mesh = makeSphere(12);
+    const auto target = mesh.indices.size() / 4 / 3 * 3;
+    const auto result = simplify(mesh, target);
+
+    CHECK(result.indices.size() <= target);
+    CHECK(!hasDegenerateTriangles(result.indices));
+
+    // Every vertex stays on the sphere, so the deviation is how far the flattened triangles sag inside it. The reported
+    // error is an area weighted average rather than a maximum, but must stay within a small factor of the worst sag.
+    float sag = 0.0f;
+    for (std::size_t i = 0; i < result.indices.size(); i += 3)
+    {
+        const auto centroid = (mesh.positions[result.indices[i]] + mesh.positions[result.indices[i + 1]] + mesh.positions[result.indices[i + 2]]) / 3.0f;
+        sag = std::max(sag, 1.0f - glm::length(centroid));
+    }
+    CHECK(result.error >= sag * 0.25f);
+    CHECK(result.error <= sag * 2.0f);
+    CHECK(sag < 0.1f);
+}
+
+void testMaxErrorStopsEarly()
+{
+    const auto mesh = makeSphere(12);
+    const auto unlimited = simplify(mesh, 0);
+    const auto maxError = unlimited.error * 0.1f;
+    const auto limited = simplify(mesh, 0, maxError);
+
+    CHECK(limited.error <= maxError);
+    CHECK(limited.indices.size() > unlimited.indices.size());
+    CHECK(limited.indices.size() < mesh.indices.size());
+}
+
+void testLodChain()
+{
+    const auto mesh = makeSphere(12);
+    const auto chain = generateLodChain(mesh.indices.data(), mesh.indices.size(), mesh.positions.data(), mesh.positions.size(), sizeof(glm::vec3));
+
+    CHECK(chain.levels.size() > 2);
+    CHECK(chain.levels[0].indexCount == mesh.indices.size());
+    CHECK(chain.levels[0].error == 0.0f);
+    for (std::size_t i = 1; i < chain.levels.size(); ++i)
+    {
+        const auto& level = chain.levels[i];
+        CHECK(level.indexCount < chain.levels[i - 1].indexCount);
+        CHECK(level.error >= chain.levels[i - 1].error);
+        CHECK(level.firstIndex == chain.levels[i - 1].firstIndex + chain.levels[i - 1].indexCount);
+    }
+    CHECK(chain.indices.size() == chain.levels.back().firstIndex + chain.levels.back().indexCount);
+
+    // Further away never picks a finer level
+    const auto fovY = glm::pi<float>() / 3.0f;
+    std::size_t previous = 0;
+    for (float distance = 0.5f; distance < 1000.0f; distance *= 2.0f)
+    {
+        const auto level = selectLod(chain, distance, fovY, 1080.0f);
+        CHECK(level >= previous);
+        previous = level;
+    }
+    CHECK(selectLod(chain, 1e-3f, fovY, 1080.0f) == 0);
+    CHECK(selectLod(chain, 1e6f, fovY, 1080.0f) == chain.levels.size() - 1);
+}
+} // namespace
+
+int main()
+{
+    testPlaneReachesTarget();
+    testSphereErrorBounded();
+    testMaxErrorStopsEarly();
+    testLodChain();
+    return testResult();
+}
@@ -0,0 +1,187 @@
+#include "meshlet.hpp"
+#include "test.hpp"
+
+#include <algorithm>
+#include <random>
+#include <set>
+
+namespace
+{
+struct TestMesh
+{
+    std::vector<glm::vec3> positions;
+    std::vector<std::uint32_t> indices;
+};
+
+/* Closed unit sphere with outward (counter-clockwise) winding: a subdivided cube with its vertices projected outward */
+auto makeSphere(const std::uint32_t size) -> TestMesh
+{
+    TestMesh mesh;
+    const glm::vec3 axes[6][3] = {
+        { { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 } },   { { -1, 0, 0 }, { 0, 0, 1 }, { 0, 1, 0 } }, { { 0, 1, 0 }, { 0, 0, 1 }, { 1, 0, 0 } },
+        { { 0, -1, 0 }, { 1, 0, 0 }, { 0, 0, 1 } }, { { 0, 0, 1 }, { 1, 0, 0 }, { 0, 1, 0 } },  { { 0, 0, -1 }, { 0, 1, 0 }, { 1, 0, 0 } },
+    };
+
+    for (const auto& [normal, u, v] : axes)
+    {
+        const auto first = static_cast<std::uint32_t>(mesh.positions.size());
+        for (std::uint32_t y = 0; y <= size; ++y)
+        {
+            for (std::uint32_t x = 0; x <= size; ++x)
+            {
+                const auto s = static_cast<float>(x) / static_cast<float>(size) * 2.0f - 1.0f;
+                const auto t = static_cast<float>(y) / static_cast<float>(size) * 2.0f - 1.0f;
+                mesh.positions.push_back(glm::normalize(normal + u * s + v * t));
+            }
+        }
+
+        for (std::uint32_t y = 0; y < size; ++y)
+        {
+            for (std::uint32_t x = 0; x < size; ++x)
+            {
+                const auto a = first + y * (size + 1) + x;
+                mesh.indices.insert(mesh.indices.end(), { a, a + 1, a + size + 2, a, a + size + 2, a + size + 1 });
+            }
+        }
+    }
+    return mesh;
+}
+
+auto build(const TestMesh& mesh, const std::uint32_t maxVertices, const std::uint32_t maxTriangles) -> MeshletSet
+{
+    return buildMeshlets(mesh.indices.data(), mesh.indices.size(), mesh.positions.data(), mesh.positions.size(), sizeof(glm::vec3), 0, maxVertices,
+                         maxTriangles);
+}
+
+void testLimits()
+{
+    const auto mesh = makeSphere(16);
+    for (const auto& [maxVertices, maxTriangles] : { std::pair(64u, 124u), std::pair(16u, 32u), std::pair(128u, 8u), std::pair(3u, 1u) })
+    {
+        const auto set = build(mesh, maxVertices, maxTriangles);
+        CHECK(set.indices == mesh.indices);
+        CHECK(!set.meshlets.empty());
+        CHECK(set.radius.size() % 4 == 0 && set.radius.size() >= set.meshlets.size());
+
+        // Meshlets cover the index buffer in order, each within both limits and with an exact vertex count
+        std::uint32_t nextIndex = 0;
+        for (std::size_t m = 0; m < set.meshlets.size(); ++m)
+        {
+            const auto& meshlet = set.meshlets[m];
+            const std::set<std::uint32_t> unique(set.indices.begin() + meshlet.firstIndex, set.indices.begin() + meshlet.firstIndex + meshlet.indexCount);
+            CHECK(meshlet.firstIndex == nextIndex);
+            CHECK(meshlet.indexCount > 0 && meshlet.indexCount % 3 == 0);
+            CHECK(meshlet.indexCount / 3 <= maxTriangles);
+            CHECK(meshlet.vertexCount <= maxVertices);
+            CHECK(meshlet.vertexCount == unique.size());
+            nextIndex += meshlet.indexCount;
+
+            // The bounding sphere holds every vertex
+            const glm::vec3 centre(set.centreX[m], set.centreY[m], set.centreZ[m]);
+            for (const auto v : unique)
+                CHECK(glm::length(mesh.positions[v] - centre) <= set.radius[m] * 1.0001f + 1e-6f);
+        }
+        CHECK(nextIndex == mesh.indices.size());
+    }
+}
+
+void testCullingConservative()
+{
+    // Cameras all around the sphere, each with a random half space as the frustum. A culled meshlet must have every triangle
+    // either back facing or entirely outside, a visible triangle must never be lost.
+    const auto mesh = makeSphere(16);
+    const auto set = build(mesh, 64, 124);
+
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    auto randomDirection = [&] {
+        glm::vec3 direction;
+        do
+            direction = glm::vec3(unit(random), unit(random), unit(random));
+        while (glm::length(direction) < 0.1f || glm::length(direction) > 1.0f);
+        return glm::normalize(direction);
+    };
+
+    std::uint32_t coneCulled = 0, frustumCulled = 0;
+    for (int camera = 0; camera < 200; ++camera)
+    {
+        const auto cameraPos = randomDirection() * (1.2f + static_cast<float>(camera % 10));
+        const auto planeNormal = randomDirection();
+        const auto planeDistance = unit(random) * 0.5f;
+
+        Frustum frustum;
+        frustum.planes.fill(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+        frustum.planes[0] = glm::vec4(planeNormal, planeDistance);
+
+        for (std::size_t first = 0; first < set.meshlets.size(); first += 4)
+        {
+            const auto mask = cullMeshlets4(set, first, frustum, cameraPos);
+            for (std::size_t lane = 0; lane < 4; ++lane)
+            {
+                if (first + lane >= set.meshlets.size())
+                {
+                    CHECK((mask & (1u << lane)) == 0); // Padding lanes never survive
+                    continue;
+                }
+                if ((mask & (1u << lane)) != 0)
+                    continue;
+
+                const auto& meshlet = set.meshlets[first + lane];
+                bool outside = true, backFacing = true;
+                for (auto i = meshlet.firstIndex; i < meshlet.firstIndex + meshlet.indexCount; i += 3)
+                {
+                    const auto a = mesh.positions[set.indices[i]], b = mesh.positions[set.indices[i + 1]], c = mesh.positions[set.indices[i + 2]];
+                    backFacing &= glm::dot(glm::cross(b - a, c - a), cameraPos - a) <= 0.0f;
+                    for (const auto& p : { a, b, c })
+                        outside &= glm::dot(planeNormal, p) + planeDistance < 0.0f;
+                }
+                CHECK(outside || backFacing);
+                coneCulled += !outside;
+                frustumCulled += outside;
+            }
+        }
+    }
+
+    // And the tests do cull something
+    CHECK(coneCulled > 0);
+    CHECK(frustumCulled > 0);
+}
+
+void testCullCommands()
+{
+    const auto mesh = makeSphere(16);
+    const auto set = build(mesh, 64, 124);
+
+    // Everything visible from inside the sphere (no cone points away from the centre), so one command covers it all
+    Frustum everything;
+    everything.planes.fill(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+    std::vector<DrawElementsIndirectCommand> commands;
+    auto stats = cullMeshlets(set, everything, glm::vec3(0.0f), 100, 5, 2, commands);
+    CHECK(stats.visibleMeshlets == set.meshlets.size());
+    CHECK(stats.visibleTriangles == mesh.indices.size() / 3);
+    CHECK(commands.size() == 1);
+    CHECK(commands[0].count == mesh.indices.size() && commands[0].firstIndex == 100);
+    CHECK(commands[0].baseVertex == 5 && commands[0].baseInstance == 2);
+
+    // From outside, roughly the far half is culled. Commands cover exactly the visible triangles, in disjoint runs.
+    commands.clear();
+    stats = cullMeshlets(set, everything, glm::vec3(0.0f, 0.0f, 10.0f), 0, 0, 0, commands);
+    CHECK(stats.visibleMeshlets < set.meshlets.size());
+    std::uint64_t indexCount = 0;
+    for (std::size_t i = 0; i < commands.size(); ++i)
+    {
+        indexCount += commands[i].count;
+        if (i > 0)
+            CHECK(commands[i].firstIndex > commands[i - 1].firstIndex + commands[i - 1].count);
+    }
+    CHECK(indexCount == stats.visibleTriangles * 3);
+}
+} // namespace
+
+int main()
+{
+    testLimits();
+    testCullingConservative();
+    testCullCommands();
+    return testResult();
+}
@@ -0,0 +1,143 @@
+#include "occlusion_buffer.hpp"
+#include "test.hpp"
+
+#include <glm/ext/matrix_clip_space.hpp>
+#include <glm/ext/matrix_transform.hpp>
+
+namespace
+{
+constexpr std::uint32_t QuadIndices[] = { 0, 1, 2, 0, 2, 3 };
+
+/* Counter-clockwise quad at depth `z` spanning [x0, x1] x [y0, y1] */
+auto quad(const float x0, const float y0, const float x1, const float y1, const float z) -> std::array<glm::vec3, 4>
+{
+    return { glm::vec3(x0, y0, z), glm::vec3(x1, y0, z), glm::vec3(x1, y1, z), glm::vec3(x0, y1, z) };
+}
+
+void addQuad(OcclusionBuffer& buffer, const std::array<glm::vec3, 4>& corners, const glm::mat4& modelViewProjection)
+{
+    buffer.addOccluder(corners.data(), corners.size(), sizeof(glm::vec3), 0, QuadIndices, std::size(QuadIndices), modelViewProjection);
+}
+
+void testRasterise()
+{
+    // With an identity matrix the quad covers the left half of the screen at NDC depth 0, window depth 0.5
+    OcclusionBuffer buffer;
+    buffer.init(64, 32);
+    addQuad(buffer, quad(-1.0f, -1.0f, 0.0f, 1.0f, 0.0f), glm::mat4(1.0f));
+    CHECK(buffer.triangleCount() == 2);
+
+    // Back facing triangles are dropped
+    const auto backFacing = quad(1.0f, -1.0f, 0.0f, 1.0f, 0.0f);
+    addQuad(buffer, backFacing, glm::mat4(1.0f));
+    CHECK(buffer.triangleCount() == 2);
+
+    buffer.rasterise();
+    const auto& depth = buffer.depth(0);
+    std::uint32_t covered = 0, wrong = 0;
+    for (std::uint32_t y = 0; y < buffer.height(); ++y)
+    {
+        for (std::uint32_t x = 0; x < buffer.width(); ++x)
+        {
+            const auto expected = x < buffer.width() / 2 ? 0.5f : 1.0f;
+            wrong += std::abs(depth[y * buffer.width() + x] - expected) > 1e-6f;
+            covered += depth[y * buffer.width() + x] < 1.0f;
+        }
+    }
+    // The shared diagonal runs through pixel centres, the fill rule must leave no holes along it
+    CHECK(wrong == 0);
+    CHECK(covered == buffer.width() * buffer.height() / 2);
+
+    // Rasterising in bands across a pool gives the same result
+    ThreadPool pool;
+    pool.init(2);
+    OcclusionBuffer pooled;
+    pooled.init(64, 32);
+    addQuad(pooled, quad(-1.0f, -1.0f, 0.0f, 1.0f, 0.0f), glm::mat4(1.0f));
+    pooled.rasterise(&pool);
+    CHECK(pooled.depth(0) == depth);
+
+    // clear() resets the depth and the queue
+    buffer.clear();
+    CHECK(buffer.triangleCount() == 0);
+    CHECK(std::all_of(buffer.depth(0).begin(), buffer.depth(0).end(), [](const float d) { return d == 1.0f; }));
+}
+
+void testHierarchy()
+{
+    // Odd level sizes on the way up (48x20 -> 24x10 -> 12x5 -> 6x3 -> 3x2 -> 2x1 -> 1x1)
+    OcclusionBuffer buffer;
+    buffer.init(48, 20);
+    CHECK(buffer.levelCount() == 7);
+
+    // A sloped occluder so every texel has a different depth
+    const std::array<glm::vec3, 4> corners = { glm::vec3(-1, -1, -0.8f), glm::vec3(0.5f, -1, 0.2f), glm::vec3(0.5f, 0.6f, 0.4f), glm::vec3(-1, 0.6f, -0.6f) };
+    addQuad(buffer, corners, glm::mat4(1.0f));
+    buffer.rasterise();
+
+    // Each texel is the farthest of the (clamped) 2x2 block below it
+    auto width = buffer.width(), height = buffer.height();
+    for (std::uint32_t level = 1; level < buffer.levelCount(); ++level)
+    {
+        const auto& source = buffer.depth(level - 1);
+        const auto& depth = buffer.depth(level);
+        const auto levelWidth = std::max(1u, (width + 1) / 2), levelHeight = std::max(1u, (height + 1) / 2);
+        CHECK(depth.size() == levelWidth * levelHeight);
+
+        for (std::uint32_t y = 0; y < levelHeight; ++y)
+        {
+            for (std::uint32_t x = 0; x < levelWidth; ++x)
+            {
+                float farthest = 0.0f;
+                for (const auto sy : { std::min(y * 2, height - 1), std::min(y * 2 + 1, height - 1) })
+                {
+                    for (const auto sx : { std::min(x * 2, width - 1), std::min(x * 2 + 1, width - 1) })
+                        farthest = std::max(farthest, source[sy * width + sx]);
+                }
+                CHECK(depth[y * levelWidth + x] == farthest);
+            }
+        }
+        width = levelWidth;
+        height = levelHeight;
+    }
+
+    // The top holds the farthest depth anywhere, which is the cleared background
+    CHECK(buffer.depth(buffer.levelCount() - 1)[0] == 1.0f);
+}
+
+void testVisibility()
+{
+    // A 10x10 wall 10 units in front of the camera, looking down -z
+    const auto viewProjection = glm::perspective(1.2f, 2.0f, 0.5f, 100.0f) * glm::lookAt(glm::vec3(0.0f), glm::vec3(0, 0, -1), glm::vec3(0, 1, 0));
+    OcclusionBuffer buffer;
+    buffer.init(128, 64);
+    addQuad(buffer, quad(-5.0f, -5.0f, 5.0f, 5.0f, -10.0f), viewProjection);
+    buffer.rasterise();
+
+    auto isVisible = [&](const glm::vec3& centre, const float halfSize) {
+        return buffer.isVisible(centre - halfSize, centre + halfSize, viewProjection);
+    };
+
+    CHECK(!isVisible({ 0, 0, -20 }, 1.0f));  // Straight behind the wall
+    CHECK(!isVisible({ 2, -2, -30 }, 2.0f)); // Behind and off centre, but still within the wall's shadow
+    CHECK(isVisible({ 0, 0, -5 }, 1.0f));    // In front of the wall
+    CHECK(isVisible({ 0, 0, -10 }, 1.0f));   // Straddling it
+    CHECK(isVisible({ 15, 0, -20 }, 1.0f));  // Beside it
+    CHECK(isVisible({ 6, 0, -20 }, 3.0f));   // Partly poking out from behind an edge
+    CHECK(isVisible({ 0, 0, 0 }, 1.0f));     // Crossing the near plane
+    CHECK(!isVisible({ 60, 0, -20 }, 1.0f)); // Off screen to the side
+
+    // Nothing is occluded by an empty buffer
+    buffer.clear();
+    buffer.rasterise();
+    CHECK(isVisible({ 0, 0, -20 }, 1.0f));
+}
+} // namespace
+
+int main()
+{
+    testRasterise();
+    testHierarchy();
+    testVisibility();
+    return testResult();
+}
@@ -0,0 +1,131 @@
+#include "range_allocator.hpp"
+#include "test.hpp"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace
+{
+void testAllocate()
+{
+    RangeAllocator allocator;
+    allocator.init(100);
+    CHECK(allocator.capacity() == 100 && allocator.used() == 0);
+    CHECK(allocator.freeBlockCount() == 1 && allocator.fragmentation() == 0.0f);
+
+    const auto a = allocator.allocate(30);
+    const auto b = allocator.allocate(50);
+    CHECK(a == 0 && b == 30);
+    CHECK(allocator.used() == 80 && allocator.largestFreeBlock() == 20);
+
+    // Too big, and empty, requests fail without changing anything
+    CHECK(allocator.allocate(21) == RangeAllocator::InvalidOffset);
+    CHECK(allocator.allocate(0) == RangeAllocator::InvalidOffset);
+    CHECK(allocator.used() == 80);
+
+    // Exactly filling the last block leaves no free blocks
+    CHECK(allocator.allocate(20) == 80);
+    CHECK(allocator.used() == 100 && allocator.freeBlockCount() == 0 && allocator.fragmentation() == 0.0f);
+    CHECK(allocator.allocate(1) == RangeAllocator::InvalidOffset);
+
+    // An empty allocator has nothing to give
+    RangeAllocator empty;
+    empty.init(0);
+    CHECK(empty.allocate(1) == RangeAllocator::InvalidOffset);
+}
+
+void testBestFit()
+{
+    // Free blocks of 10 at 0, 30 at 20 and 15 at 60 (with 10 and 10 held between them)
+    RangeAllocator allocator;
+    allocator.init(75);
+    const auto a = allocator.allocate(10), b = allocator.allocate(10), c = allocator.allocate(30), d = allocator.allocate(10), e = allocator.allocate(15);
+    CHECK(a == 0 && b == 10 && c == 20 && d == 50 && e == 60);
+    allocator.free(a, 10);
+    allocator.free(c, 30);
+    allocator.free(e, 15);
+    CHECK(allocator.freeBlockCount() == 3);
+    CHECK(allocator.fragmentation() > 0.0f);
+
+    // The smallest block that fits wins, not the first
+    CHECK(allocator.allocate(12) == 60);
+    CHECK(allocator.allocate(8) == 0);
+    CHECK(allocator.allocate(30) == 20);
+}
+
+void testCoalesce()
+{
+    RangeAllocator allocator;
+    allocator.init(40);
+    const auto a = allocator.allocate(10), b = allocator.allocate(10), c = allocator.allocate(10), d = allocator.allocate(10);
+
+    // Freeing a and c leaves two separate holes, freeing b between them merges all three
+    allocator.free(a, 10);
+    allocator.free(c, 10);
+    CHECK(allocator.freeBlockCount() == 2 && allocator.largestFreeBlock() == 10);
+    allocator.free(b, 10);
+    CHECK(allocator.freeBlockCount() == 1 && allocator.largestFreeBlock() == 30);
+    CHECK(allocator.allocate(30) == 0);
+
+    // Merging with only the preceding, then only the following block
+    allocator.free(0, 30);
+    allocator.free(d, 10);
+    CHECK(allocator.freeBlockCount() == 1 && allocator.largestFreeBlock() == 40 && allocator.used() == 0);
+}
+
+void testRandomised()
+{
+    // Random allocations and frees, then everything freed must coalesce back into the single original block
+    RangeAllocator allocator;
+    allocator.init(10000);
+    std::mt19937 random(5);
+    struct Block
+    {
+        std::uint32_t offset, size;
+    };
+    std::vector<Block> live;
+    for (int step = 0; step < 5000; ++step)
+    {
+        if (!live.empty() && random() % 3 == 0)
+        {
+            const auto i = random() % live.size();
+            allocator.free(live[i].offset, live[i].size);
+            live.erase(live.begin() + i);
+            continue;
+        }
+
+        const auto size = static_cast<std::uint32_t>(1 + random() % 200);
+        const auto offset = allocator.allocate(size);
+        if (offset != RangeAllocator::InvalidOffset)
+            live.push_back({ offset, size });
+    }
+
+    // Live blocks never overlap and add up to used()
+    std::sort(live.begin(), live.end(), [](const Block& lhs, const Block& rhs) { return lhs.offset < rhs.offset; });
+    std::uint32_t used = 0;
+    for (std::size_t i = 0; i < live.size(); ++i)
+    {
+        used += live[i].size;
+        if (i > 0)
+            CHECK(live[i - 1].offset + live[i - 1].size <= live[i].offset);
+        CHECK(live[i].offset + live[i].size <= allocator.capacity());
+    }
+    CHECK(used == allocator.used());
+
+    std::shuffle(live.begin(), live.end(), random);
+    for (const auto& block : live)
+        allocator.free(block.offset, block.size);
+    CHECK(allocator.used() == 0);
+    CHECK(allocator.freeBlockCount() == 1 && allocator.largestFreeBlock() == 10000);
+}
+} // namespace
+
+int main()
+{
+    testAllocate();
+    testBestFit();
+    testCoalesce();
+    testRandomised();
+    return testResult();
+}
@@ -0,0 +1,135 @@
+#include "shader_preprocessor.hpp"
+#include "test.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+const auto Root = std::filesystem::temp_directory_path() / "shader_preprocessor_test";
+
+void writeFile(const std::filesystem::path& path, const std::string& text)
+{
+    std::filesystem::create_directories(path.parent_path());
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << text;
+}
+
+auto canonicalName(const std::filesystem::path& path) -> std::string
+{
+    return std::filesystem::weakly_canonical(path).string();
+}
+
+auto contains(const std::string& text, const std::string& what) -> bool
+{
+    return text.find(what) != std::string::npos;
+}
+
+void testResolutionOrder()
+{
+    // shaders/common.glsl sits next to the root, first/ and second/ are include directories that also have one
+    const auto main = Root / "shaders" / "main.glsl";
+    writeFile(main, "#include \"common.glsl\"\n");
+    writeFile(Root / "shaders" / "common.glsl", "relative\n");
+    writeFile(Root / "first" / "common.glsl", "first\n");
+    writeFile(Root / "second" / "common.glsl", "second\n");
+    writeFile(Root / "second" / "only_second.glsl", "only second\n");
+
+    ShaderPreprocessor preprocessor;
+    preprocessor.addIncludeDirectory(Root / "first");
+    preprocessor.addIncludeDirectory(Root / "second");
+
+    // Relative to the including file first
+    auto result = preprocessor.expand(main.string());
+    CHECK(result.valid);
+    CHECK(contains(result.text, "relative\n"));
+    CHECK(result.files.size() == 2 && result.files[0] == canonicalName(main) && result.files[1] == canonicalName(Root / "shaders" / "common.glsl"));
+
+    // Then the include directories in the order they were added
+    std::filesystem::remove(Root / "shaders" / "common.glsl");
+    result = preprocessor.expand(main.string());
+    CHECK(result.valid && contains(result.text, "first\n") && !contains(result.text, "second\n"));
+    CHECK(preprocessor.resolve("common.glsl") == Root / "first" / "common.glsl");
+    CHECK(preprocessor.resolve("only_second.glsl") == Root / "second" / "only_second.glsl");
+
+    // In-memory sources shadow everything on disk
+    preprocessor.addSource("common.glsl", "memory\n");
+    result = preprocessor.expand(main.string());
+    CHECK(result.valid && contains(result.text, "memory\n") && !contains(result.text, "first\n"));
+    CHECK(result.files.size() == 2 && result.files[1] == "common.glsl");
+    CHECK(preprocessor.resolve("common.glsl").empty());
+
+    // Missing includes invalidate the expansion
+    preprocessor.addSource("broken.glsl", "#include \"missing.glsl\"\n");
+    CHECK(!preprocessor.expand("broken.glsl").valid);
+    CHECK(!preprocessor.expand("missing.glsl").valid);
+
+    std::filesystem::remove_all(Root);
+}
+
+void testIncludeOnce()
+{
+    // a includes b and c, b includes c again, and c includes a, closing a cycle
+    ShaderPreprocessor preprocessor;
+    preprocessor.addSource("a", "a body\n#include \"b\"\n#include \"c\"\n");
+    preprocessor.addSource("b", "b body\n#include \"c\"\n");
+    preprocessor.addSource("c", "c body\n#include \"a\"\n");
+
+    const auto result = preprocessor.expand("a");
+    CHECK(result.valid);
+    CHECK(result.files == std::vector<std::string>({ "a", "b", "c" }));
+
+    auto count = [&](const std::string& what) {
+        std::size_t found = 0;
+        for (auto at = result.text.find(what); at != std::string::npos; at = result.text.find(what, at + 1))
+            ++found;
+        return found;
+    };
+    CHECK(count("a body") == 1 && count("b body") == 1 && count("c body") == 1);
+}
+
+void testLineDirectives()
+{
+    ShaderPreprocessor preprocessor;
+    preprocessor.addSource("main", "first\n#include \"outer\"\nthird\n");
+    preprocessor.addSource("outer", "A\n  #include <inner>\nB\n");
+    preprocessor.addSource("inner", "X\n");
+
+    // Each include starts at line 1 of its own file index, and the includer resumes on the line after the #include
+    const auto result = preprocessor.expand("main");
+    CHECK(result.valid);
+    CHECK(result.text == "first\n#line 1 1\nA\n#line 1 2\nX\n#line 3 1\nB\n#line 3 0\nthird\n");
+    CHECK(result.files == std::vector<std::string>({ "main", "outer", "inner" }));
+}
+
+void testInjectDefines()
+{
+    const std::vector<std::string> defines = { "SKINNED", "LIGHTS 4" };
+
+    // After #version, then back to the line following it
+    CHECK(ShaderPreprocessor::injectDefines("#version 450 core\nvoid main() {}\n", defines)
+          == "#version 450 core\n#define SKINNED\n#define LIGHTS 4\n#line 2 0\nvoid main() {}\n");
+    CHECK(ShaderPreprocessor::injectDefines("// header\n\n#version 450 core\nvoid main() {}\n", defines)
+          == "// header\n\n#version 450 core\n#define SKINNED\n#define LIGHTS 4\n#line 4 0\nvoid main() {}\n");
+
+    // A #version without a newline still gets the defines on their own lines
+    CHECK(ShaderPreprocessor::injectDefines("#version 450 core", defines) == "#version 450 core\n#define SKINNED\n#define LIGHTS 4\n#line 2 0\n");
+
+    // Without #version they go first
+    CHECK(ShaderPreprocessor::injectDefines("void main() {}\n", defines) == "#define SKINNED\n#define LIGHTS 4\n#line 1 0\nvoid main() {}\n");
+
+    // Nothing to add leaves the source untouched
+    CHECK(ShaderPreprocessor::injectDefines("#version 450 core\nvoid main() {}\n", {}) == "#version 450 core\nvoid main() {}\n");
+}
+} // namespace
+
+int main()
+{
+    testResolutionOrder();
+    testIncludeOnce();
+    testLineDirectives();
+    testInjectDefines();
+    return testResult();
+}
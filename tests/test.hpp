@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdio>
+
+// Minimal checks for the test executables. A failed CHECK prints the expression and carries on, so one run reports every
+// failure; main returns testResult() and ctest treats non-zero as a failed test.
+
+inline int testFailures = 0;
+
+#define CHECK(expression)                                                                                                                            \
+    do                                                                                                                                               \
+    {                                                                                                                                                \
+        if (!(expression))                                                                                                                           \
+        {                                                                                                                                            \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #expression);                                                      \
+            ++testFailures;                                                                                                                          \
+        }                                                                                                                                            \
+    } while (false)
+
+inline auto testResult() -> int
+{
+    if (testFailures > 0)
+        std::fprintf(stderr, "%d check(s) failed\n", testFailures);
+    return testFailures > 0 ? 1 : 0;
+}